@@ -56,6 +56,15 @@ public:
     // Pass a non-callable callback to disable handling.
     static int set_callback(void* handle, Command cmd, Timeout timeout, const Callback& callback);
 
+    // Switch callback handling to manual drive mode and get the descriptor that signals pending
+    // callbacks. No monitoring thread is created: the caller should watch the descriptor in its
+    // own event loop and call process_events whenever it is signaled.
+    // Must be called before the first call to set_callback.
+    static int events_fd(void* handle, int* fd);
+
+    // Dispatch all pending callbacks on the calling thread. Only valid in manual drive mode.
+    static int process_events(void* handle);
+
 private:
 
     // Create new RPC Client instance connecting to specified address.
@@ -66,7 +75,8 @@ private:
 
     // Create callback monitor using port saved during construction of client.
     // This will be called only on the first call to set_callback to avoid unecessary sockets.
-    int create_callback_monitor();
+    // If threaded is false, the monitor won't launch a thread and must be driven manually.
+    int create_callback_monitor(bool threaded);
 
     // Unique identifier of the connection.
     Guid identifier_;
@@ -190,7 +200,7 @@ int Client<Command>::set_callback(void* handle, Command cmd, Timeout timeout, co
     }
 
     // Make sure Callback Monitor is created.
-    int error = client->create_callback_monitor();
+    int error = client->create_callback_monitor(true);
     if (error) {
         return error;
     }
@@ -209,6 +219,52 @@ int Client<Command>::set_callback(void* handle, Command cmd, Timeout timeout, co
 
 /*************************************************************************************************/
 
+template<class Command>
+int Client<Command>::events_fd(void* handle, int* fd)
+{
+    Client* client = static_cast<Client*>(handle);
+    if (!client || !fd) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+
+    // Callbacks are already being handled by a monitoring thread.
+    if (client->callback_monitor_ && client->callback_monitor_->threaded()) {
+        return static_cast<int>(std::errc::operation_in_progress);
+    }
+
+    int error = client->create_callback_monitor(false);
+    if (error) {
+        return error;
+    }
+
+    return protected_call([&client, &fd]() {
+        *fd = client->callback_monitor_->descriptor();
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+template<class Command>
+int Client<Command>::process_events(void* handle)
+{
+    Client* client = static_cast<Client*>(handle);
+    if (!client) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+
+    if (!client->callback_monitor_ || client->callback_monitor_->threaded()) {
+        return static_cast<int>(std::errc::operation_not_permitted);
+    }
+
+    return protected_call([&client]() {
+        client->callback_monitor_->process_events();
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
 template<class Command>
 Client<Command>::Client(const std::string& address)
     : identifier_(Guid::generate())
@@ -219,14 +275,14 @@ Client<Command>::Client(const std::string& address)
 /*************************************************************************************************/
 
 template<class Command>
-int Client<Command>::create_callback_monitor()
+int Client<Command>::create_callback_monitor(bool threaded)
 {
     // Do nothing if already created.
     if (callback_monitor_) {
         return 0;
     }
 
-    return protected_call([this] {
+    return protected_call([this, &threaded] {
 
         // Convert received port to string.
         std::string port_str = ":" + std::to_string(callback_port_);
@@ -235,7 +291,7 @@ int Client<Command>::create_callback_monitor()
         std::string addr = std::regex_replace(socket_.address(), std::regex(":\\d+"), port_str);
 
         // Add new monitor to client using identifier as channel.
-        callback_monitor_ = std::make_unique<CallbackMonitor>(addr, identifier_.to_string());
+        callback_monitor_ = std::make_unique<CallbackMonitor>(addr, identifier_.to_string(), threaded);
 
         // Succeeded.
         return 0;
@@ -247,12 +303,13 @@ int Client<Command>::create_callback_monitor()
  *************************************************************************************************/
 
 // Launch new thread to monitor callbacks events.
+// In manual drive mode no thread is launched and events are processed by the caller.
 template<class Command>
 class Client<Command>::CallbackMonitor
 {
 public:
-    // Create new subscriber socket and launch thread to monitor incoming messages.
-    CallbackMonitor(const std::string& address, const std::string& channel);
+    // Create new subscriber socket and, if threaded, launch thread to monitor incoming messages.
+    CallbackMonitor(const std::string& address, const std::string& channel, bool threaded);
 
     // Stop monitoring thread.
     ~CallbackMonitor();
@@ -261,11 +318,23 @@ public:
     // Pass a non-callable callback to disable handling of speficied ID.
     int set_callback(Command id, const Callback& callback);
 
+    // Returns true if a thread is monitoring incoming messages.
+    bool threaded() const;
+
+    // Gets descriptor signaled when messages are pending.
+    int descriptor();
+
+    // Dispatch every pending message without blocking.
+    void process_events();
+
 private:
 
     // Method executed by main thread
     void main_loop();
 
+    // Call the callback registered for the received message, if any.
+    void dispatch(InputBuffer message);
+
     // Save installed callbacks
     std::map<Command, Callback> callbacks_;
 
@@ -282,12 +351,16 @@ private:
 /*************************************************************************************************/
 
 template<class Command>
-Client<Command>::CallbackMonitor::CallbackMonitor(const std::string& address, const std::string& channel)
+Client<Command>::CallbackMonitor::CallbackMonitor(const std::string& address, const std::string& channel, bool threaded)
     : callbacks_()
     , mutex_()
     , socket_(address, channel)
-    , main_thread_(&CallbackMonitor::main_loop, this)
-{}
+    , main_thread_()
+{
+    if (threaded) {
+        main_thread_ = std::thread(&CallbackMonitor::main_loop, this);
+    }
+}
 
 /*************************************************************************************************/
 
@@ -295,7 +368,9 @@ template<class Command>
 Client<Command>::CallbackMonitor::~CallbackMonitor()
 {
     socket_.close();
-    main_thread_.join();
+    if (main_thread_.joinable()) {
+        main_thread_.join();
+    }
 }
 
 /*************************************************************************************************/
@@ -317,6 +392,52 @@ int Client<Command>::CallbackMonitor::set_callback(Command id, const Callback& c
 
 /*************************************************************************************************/
 
+template<class Command>
+bool Client<Command>::CallbackMonitor::threaded() const
+{
+    return main_thread_.joinable();
+}
+
+/*************************************************************************************************/
+
+template<class Command>
+int Client<Command>::CallbackMonitor::descriptor()
+{
+    return socket_.descriptor();
+}
+
+/*************************************************************************************************/
+
+template<class Command>
+void Client<Command>::CallbackMonitor::process_events()
+{
+    // The descriptor is edge-triggered, so drain everything that is pending.
+    while (socket_.readable()) {
+        dispatch(socket_.receive());
+    }
+}
+
+/*************************************************************************************************/
+
+template<class Command>
+void Client<Command>::CallbackMonitor::dispatch(InputBuffer message)
+{
+    // The first parameter is the callback identifier;
+    Command id;
+    read(message, id);
+
+    // Find if we have a callback registered to handle this id.
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = callbacks_.find(id);
+
+    // Call it passing remaining of the received message.
+    if (found != callbacks_.end()) {
+        found->second(std::move(message));
+    }
+}
+
+/*************************************************************************************************/
+
 template<class Command>
 void Client<Command>::CallbackMonitor::main_loop()
 {
@@ -324,20 +445,7 @@ void Client<Command>::CallbackMonitor::main_loop()
     while (true) {
         try {
             // Block until new message is available
-            InputBuffer message = socket_.receive();
-
-            // The first parameter is the callback identifier;
-            Command id;
-            read(message, id);
-
-            // Find if we have a callback registered to handle this id.
-            std::lock_guard<std::mutex> lock(mutex_);
-            auto found = callbacks_.find(id);
-
-            // Call it passing remaining of the received message.
-            if (found != callbacks_.end()) {
-                found->second(std::move(message));
-            }
+            dispatch(socket_.receive());
         }
         catch (const ConnectionException&) {
             // Aborted, exit main loop.
@@ -26,11 +26,19 @@ public:
 
     // Creates new Server instance storing it as opaque handler in handle parameter.
     // Returned handle is valid, and therefore stoppable, if start returns zero
-    static int start(void** handle, const char* address);
+    // If threaded is false, no thread is launched and requests are only processed by process_events.
+    static int start(void** handle, const char* address, bool threaded = true);
 
     // Stop server deleting instance pointed by handle.
     static int stop(void* handle);
 
+    // Get the descriptor that signals pending requests for servers started in manual drive mode.
+    // It is edge-triggered: once signaled, call process_events to drain all pending requests.
+    static int events_fd(void* handle, int* fd);
+
+    // Process all pending requests on the calling thread. Only valid in manual drive mode.
+    static int process_events(void* handle);
+
 private:
 
     // Encapsulate handle for handle-based C APIs.
@@ -44,6 +52,10 @@ private:
 
         // Publishing method used for callbackas notification.
         std::function<void(OutputBuffer)> publish;
+
+        // Extra state kept by the server on behalf of this handle.
+        // Its type is defined by each protocol and it is destroyed together with the handle.
+        std::shared_ptr<void> context;
     };
 
     // Define procedure signature
@@ -72,7 +84,8 @@ private:
     };
 
     // Construct new server that will listen on specified address.
-    Server(const std::string& address);
+    // Launch main thread only if threaded is true.
+    Server(const std::string& address, bool threaded);
 
     // Stop server and destroys it.
     ~Server();
@@ -97,6 +110,7 @@ private:
     int callback_port_;
 
     // Thread responsible for asynchronous execution.
+    // Empty when server is driven manually through process_events.
     std::unique_ptr<std::thread> main_thread_;
 
     // List of handles currently managed by this server
@@ -106,14 +120,14 @@ private:
 /*************************************************************************************************/
 
 template<class Command>
-int Server<Command>::start(void** handle, const char* address)
+int Server<Command>::start(void** handle, const char* address, bool threaded)
 {
     if (!handle || !address) {
         return static_cast<int>(std::errc::invalid_argument);
     }
 
-    return protected_call([&handle, &address]() {
-        *handle = static_cast<void*>(new Server(address));
+    return protected_call([&handle, &address, &threaded]() {
+        *handle = static_cast<void*>(new Server(address, threaded));
         return 0;
     });
 }
@@ -137,7 +151,48 @@ int Server<Command>::stop(void* handle)
 /*************************************************************************************************/
 
 template<class Command>
-Server<Command>::Server(const std::string& address)
+int Server<Command>::events_fd(void* handle, int* fd)
+{
+    Server* server = static_cast<Server*>(handle);
+    if (server == nullptr || fd == nullptr) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    if (server->main_thread_) {
+        return static_cast<int>(std::errc::operation_not_permitted);
+    }
+
+    return protected_call([&server, &fd]() {
+        *fd = server->socket_->descriptor();
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+template<class Command>
+int Server<Command>::process_events(void* handle)
+{
+    Server* server = static_cast<Server*>(handle);
+    if (server == nullptr) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    if (server->main_thread_) {
+        return static_cast<int>(std::errc::operation_not_permitted);
+    }
+
+    return protected_call([&server]() {
+        // The descriptor is edge-triggered, so drain everything that is pending.
+        while (server->socket_->readable()) {
+            server->socket_->process([server](InputBuffer in) { return server->process_request(std::move(in)); });
+        }
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+template<class Command>
+Server<Command>::Server(const std::string& address, bool threaded)
     : socket_()
     , publisher_()
     , callback_port_(0)
@@ -161,7 +216,9 @@ Server<Command>::Server(const std::string& address)
     callback_port_ = std::stoi(&listening_addr[pos + 1]);
 
     // Start main thread
-    main_thread_ = std::make_unique<std::thread>(&Server::main_loop, this);
+    if (threaded) {
+        main_thread_ = std::make_unique<std::thread>(&Server::main_loop, this);
+    }
 }
 
 /*************************************************************************************************/
@@ -174,7 +231,9 @@ Server<Command>::~Server()
     }
 
     socket_->close();
-    main_thread_->join();
+    if (main_thread_) {
+        main_thread_->join();
+    }
 }
 
 /*************************************************************************************************/
@@ -279,6 +338,7 @@ template<class Command>
 Server<Command>::Handle::Handle()
     : value()
     , publish(nullptr)
+    , context()
 {}
 
 /*************************************************************************************************/
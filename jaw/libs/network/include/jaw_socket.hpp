@@ -54,6 +54,14 @@ public:
    // Close the socket aborting any blocking operations which will throw ConnectionException.
    void close();
 
+   // Gets a file descriptor that can be watched by external event loops (select, poll, epoll).
+   // It signals readability in an edge-triggered fashion (see ZMQ_FD), so once it is signaled
+   // the caller must keep consuming messages until readable returns false.
+   int descriptor();
+
+   // Returns true if a message can be received or processed without blocking.
+   bool readable();
+
 protected:
 
     // Disable generic socket instantiation.
@@ -35,6 +35,22 @@ void Socket::close()
 
 /*************************************************************************************************/
 
+int Socket::descriptor()
+{
+    if (!pimpl_) throw ConnectionException("Closed");
+    return pimpl_->descriptor();
+}
+
+/*************************************************************************************************/
+
+bool Socket::readable()
+{
+    if (!pimpl_) throw ConnectionException("Closed");
+    return pimpl_->readable();
+}
+
+/*************************************************************************************************/
+
 ClientSocket::ClientSocket(const std::string& address)
 {
     pimpl_ = std::make_unique<ClientSocket::Impl>(address);
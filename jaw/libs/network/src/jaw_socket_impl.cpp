@@ -285,6 +285,44 @@ void Socket::Impl::close()
 
 /*************************************************************************************************/
 
+int Socket::Impl::descriptor()
+{
+    std::lock_guard<std::recursive_mutex> lock(zmq_mutex_);
+
+    if (!socket_) {
+        throw ConnectionException("Socket is not connected");
+    }
+
+    // On Windows ZMQ_FD is a SOCKET, which always fits in an int in practice.
+#if defined _WIN32
+    SOCKET fd;
+#else
+    int fd;
+#endif
+    size_t size = sizeof(fd);
+    socket_->getsockopt(ZMQ_FD, &fd, &size);
+    return static_cast<int>(fd);
+}
+
+/*************************************************************************************************/
+
+bool Socket::Impl::readable()
+{
+    std::lock_guard<std::recursive_mutex> lock(zmq_mutex_);
+
+    if (!socket_) {
+        throw ConnectionException("Socket is not connected");
+    }
+
+    // Reading ZMQ_EVENTS also resets the edge-triggered notification of ZMQ_FD.
+    int events = 0;
+    size_t size = sizeof(events);
+    socket_->getsockopt(ZMQ_EVENTS, &events, &size);
+    return (events & ZMQ_POLLIN) != 0;
+}
+
+/*************************************************************************************************/
+
 void Socket::Impl::poll(short events)
 {
     // Create abort infrastructure if needed
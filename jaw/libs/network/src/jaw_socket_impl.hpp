@@ -85,6 +85,12 @@ public:
     // Closes opened connection aborting blocking operations.
     void close();
 
+    // Gets the ZMQ_FD of the underlying socket.
+    int descriptor();
+
+    // Checks ZMQ_EVENTS for pending incoming messages.
+    bool readable();
+
 protected:
 
     // Poll for events on this sockets.
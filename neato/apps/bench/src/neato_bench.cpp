@@ -0,0 +1,398 @@
+#include "neato_api.h"
+#include "neato_laser.hpp"
+#include "neato_scan_matcher.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace Neato;
+
+/*************************************************************************************************/
+
+// Execute method repeatedly returning average execution time in seconds.
+template<class Method>
+static double measure(int repetitions, Method method)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        method();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repetitions;
+}
+
+/*************************************************************************************************/
+
+// Previous parser of Robot::read_laser, copying the result to a string and keeping only distances.
+static void legacy_read_laser(neato_laser_data_t* laser_data)
+{
+    std::string result(dummy_laser, dummy_laser_size);
+
+    char* c_result = const_cast<char*>(result.c_str());
+
+    // Skip header
+    char* entry_str = std::strstr(c_result, "\n");
+
+    int max = 5000;
+
+    for (int i = 0; i < 360; i++) {
+        int angle = std::strtol(++entry_str, &entry_str, 10);
+        if (angle != i) {
+            throw Jaw::Exception(std::errc::io_error, "Error reading laser information");
+        }
+        int distance = std::strtol(++entry_str, &entry_str, 10);
+        int intensity = std::strtol(++entry_str, &entry_str, 10);
+        int error = std::strtol(++entry_str, &entry_str, 10);
+        (void) intensity;
+
+        if (error == 0) {
+            laser_data->distance[angle] = std::min(distance, max);
+        } else {
+            laser_data->distance[angle] = 0;
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+// Returns true if parser rejects text.
+static bool rejects(const std::string& text)
+{
+    LaserScan scan;
+    try {
+        parse_laser_scan(text.data(), text.size(), scan);
+    } catch (const Jaw::Exception&) {
+        return true;
+    }
+    return false;
+}
+
+/*************************************************************************************************/
+
+static void bench_parser()
+{
+    const int repetitions = 20000;
+
+    neato_laser_data_t legacy = {};
+    LaserScan scan = {};
+
+    const double legacy_time = measure(repetitions, [&]() { legacy_read_laser(&legacy); });
+    const double parser_time = measure(repetitions, [&]() { parse_laser_scan(dummy_laser, dummy_laser_size, scan); });
+
+    // Both must give the same distances to the robot.
+    bool valid = scan.rotation_speed > 5.01 && scan.rotation_speed < 5.03;
+    for (int i = 0; i < NEATO_NUM_LASER_READINGS; i++) {
+        const int distance = scan.error[i] ? 0 : std::min<int>(scan.distance[i], NEATO_LASER_MAX_RANGE);
+        valid = valid && (distance == legacy.distance[i]);
+    }
+
+    // Malformed scans must be reported instead of filling readings with garbage.
+    const std::string sample(dummy_laser, dummy_laser_size);
+    std::string skipped = sample;
+    skipped.erase(skipped.find("\n17,") + 1, skipped.find("\n18,") - skipped.find("\n17,"));
+    std::string windows = sample;
+    for (std::size_t i = windows.find('\n'); i != std::string::npos; i = windows.find('\n', i + 2)) {
+        windows.insert(i, "\r");
+    }
+    const bool strict = rejects(sample.substr(0, sample.size() / 2)) && rejects(skipped) &&
+                        rejects("ROTATION_SPEED, 5.02") && !rejects(windows);
+
+    std::cout << "strtol       " << std::setw(8) << 1.0e6 * legacy_time << " us" << std::endl;
+    std::cout << "single pass  " << std::setw(8) << 1.0e6 * parser_time << " us"
+              << "  (" << legacy_time / parser_time << "x)"
+              << (valid ? "" : "  MISMATCH!") << (strict ? "" : "  ACCEPTS MALFORMED!") << std::endl;
+}
+
+/*************************************************************************************************/
+
+// Conversion computing sin and cos for every reading, as done by consumers of the scan.
+static int naive_points(const neato_laser_data_t& laser, float* x, float* y)
+{
+    const double pi = 3.14159265358979323846;
+    const neato_pose_t& pose = laser.pose_taken;
+    int count = 0;
+    for (int i = 0; i < NEATO_NUM_LASER_READINGS; i++) {
+        if (laser.distance[i] > 0) {
+            const double angle = (i + pose.theta) * pi / 180.0;
+            x[count] = static_cast<float>(pose.x + laser.distance[i] * std::cos(angle));
+            y[count] = static_cast<float>(pose.y + laser.distance[i] * std::sin(angle));
+            count++;
+        }
+    }
+    return count;
+}
+
+/*************************************************************************************************/
+
+static void bench_points()
+{
+    const int repetitions = 200000;
+
+    neato_laser_data_t laser = {};
+    legacy_read_laser(&laser);
+    laser.pose_taken.x = 1250.0;
+    laser.pose_taken.y = -730.0;
+    laser.pose_taken.theta = 37.5;
+
+    float naive_x[NEATO_NUM_LASER_READINGS];
+    float naive_y[NEATO_NUM_LASER_READINGS];
+    neato_laser_points_t points = {};
+    int count = 0;
+
+    // Vary heading a little so the compiler can't hoist the trigonometry out of the loop.
+    const double naive_time = measure(repetitions, [&]() {
+        laser.pose_taken.theta += 1e-9;
+        count = naive_points(laser, naive_x, naive_y);
+    });
+    const double table_time = measure(repetitions, [&]() {
+        laser.pose_taken.theta += 1e-9;
+        laser_points(laser, NEATO_FRAME_WORLD, points);
+    });
+
+    // Float directions rotated by the heading are within a fraction of millimeter at 5 meters.
+    bool valid = (points.num_points == count);
+    for (int i = 0; valid && i < count; i++) {
+        valid = std::abs(points.x[i] - naive_x[i]) < 0.05f && std::abs(points.y[i] - naive_y[i]) < 0.05f;
+    }
+
+    std::cout << "sin/cos      " << std::setw(8) << 1.0e6 * naive_time << " us" << std::endl;
+    std::cout << "tables+simd  " << std::setw(8) << 1.0e6 * table_time << " us"
+              << "  (" << naive_time / table_time << "x, " << count << " points)"
+              << (valid ? "" : "  MISMATCH!") << std::endl;
+}
+
+/*************************************************************************************************/
+
+// Count tiles received from the map.
+static void count_tiles(void* user_data, const neato_map_update_t* update)
+{
+    static_cast<std::atomic<int>*>(user_data)->fetch_add(update->num_tiles);
+}
+
+/*************************************************************************************************/
+
+static void bench_map()
+{
+    const int repetitions = 200;
+
+    // Simulated robot returns the dummy scan.
+    neato_config_t config = {};
+    config.update_interval_ms = 100;
+    neato_robot_t robot = nullptr;
+    if (neato_create(&robot, &config, nullptr)) {
+        std::cout << "Failed to create robot" << std::endl;
+        return;
+    }
+
+    // Recorded scan integrated as if the robot stood still at the origin.
+    neato_laser_data_t laser = {};
+    legacy_read_laser(&laser);
+    std::atomic<int> tiles(0);
+    neato_map_callback_set(robot, &tiles, count_tiles);
+    const double integrate_time = measure(repetitions, [&]() { neato_map_integrate(robot, &laser); });
+
+    // Read 10 by 10 meters around the origin.
+    neato_map_region_t region = { -100, -100, 200, 200 };
+    std::vector<uint8_t> cells(region.width * region.height);
+    const double read_time = measure(repetitions, [&]() { neato_map_get(robot, &region, cells.data()); });
+
+    int free = 0, occupied = 0;
+    for (uint8_t cell : cells) {
+        free += (cell < 64);
+        occupied += (cell != NEATO_MAP_UNKNOWN && cell > 192);
+    }
+
+    // Robot stands on free space, first reading hits something about 1134 mm ahead (cells of 50 mm).
+    const uint8_t* axis = cells.data() + 100 * region.width + 100;
+    const uint8_t wall = *std::max_element(axis + 1134 / 50 - 2, axis + 1134 / 50 + 6);
+    const bool valid = axis[0] < 64 && wall > 192 && cells[0] == NEATO_MAP_UNKNOWN;
+
+    // Let the robot feed the map on its own for a while.
+    neato_map_config_t map_config = {};
+    map_config.scan_interval_ms = 200;
+    const int before = tiles;
+    neato_map_set(robot, &map_config);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    neato_map_set(robot, nullptr);
+    const int live = tiles - before;
+
+    neato_map_callback_set(robot, nullptr, nullptr);
+    neato_destroy(robot);
+
+    std::cout << "integrate    " << std::setw(8) << 1.0e6 * integrate_time << " us"
+              << "  (" << tiles.load() / (repetitions + 0.0) << " tiles per scan)" << std::endl;
+    std::cout << "read 200x200 " << std::setw(8) << 1.0e6 * read_time << " us"
+              << "  (" << free << " free, " << occupied << " occupied, " << live << " tiles from robot)"
+              << (valid && live > 0 ? "" : "  MISMATCH!") << std::endl;
+}
+
+/*************************************************************************************************/
+
+// Wall of the synthetic room used to simulate scans.
+struct Wall
+{
+    double x0, y0, x1, y1;
+};
+
+// Simulate laser scan taken at pose (theta in degrees) inside room made of walls, adding noise.
+static void simulate_scan(const std::vector<Wall>& walls, const neato_pose_t& pose, unsigned int seed,
+                          neato_laser_data_t& laser)
+{
+    const double pi = 3.14159265358979323846;
+    laser.pose_taken = pose;
+    for (int i = 0; i < NEATO_NUM_LASER_READINGS; i++) {
+        const double angle = (i + pose.theta) * pi / 180.0;
+        const double dx = std::cos(angle);
+        const double dy = std::sin(angle);
+        double closest = 1e9;
+        for (const Wall& wall : walls) {
+            // Solve pose + t * d = wall start + u * (wall end - wall start).
+            const double ex = wall.x1 - wall.x0;
+            const double ey = wall.y1 - wall.y0;
+            const double denominator = dx * ey - dy * ex;
+            if (std::abs(denominator) < 1e-12) {
+                continue;
+            }
+            const double t = ((wall.x0 - pose.x) * ey - (wall.y0 - pose.y) * ex) / denominator;
+            const double u = ((wall.x0 - pose.x) * dy - (wall.y0 - pose.y) * dx) / denominator;
+            if (t > 0.0 && u >= 0.0 && u <= 1.0) {
+                closest = std::min(closest, t);
+            }
+        }
+        seed = seed * 1103515245u + 12345u;
+        const int noise = static_cast<int>((seed >> 16) % 21) - 10;
+        laser.distance[i] = std::min(static_cast<int>(closest) + noise, NEATO_LASER_MAX_RANGE);
+    }
+}
+
+/*************************************************************************************************/
+
+static void bench_scan_matching()
+{
+    const int repetitions = 200;
+    const double pi = 3.14159265358979323846;
+
+    // Room with a box and a column, so motion is constrained in every direction.
+    const std::vector<Wall> walls = {
+        { -2500, -1800, 3200, -1800 }, { 3200, -1800, 3200, 2100 }, { 3200, 2100, -2500, 2100 },
+        { -2500, 2100, -2500, -1800 }, { 800, -900, 1300, -900 }, { 1300, -900, 1300, -400 },
+        { 1300, -400, 800, -400 }, { 800, -400, 800, -900 }, { -1200, 900, -1000, 900 },
+        { -1000, 900, -1000, 1100 }, { -1000, 1100, -1200, 1100 }, { -1200, 1100, -1200, 900 },
+    };
+
+    // Robot moves and turns a little between scans, wheels measure it with some error.
+    const neato_pose_t first = { 0.0, 0.0, 0.0 };
+    const neato_pose_t second = { 180.0, -70.0, 6.0 };
+    neato_laser_data_t reference = {};
+    neato_laser_data_t scan = {};
+    simulate_scan(walls, first, 1, reference);
+    simulate_scan(walls, second, 2, scan);
+    const neato_pose_t guess = { second.x - 40.0, second.y + 30.0, (second.theta - 2.0) * pi / 180.0 };
+
+    ScanMatcher matcher;
+    matcher.set_reference(reference);
+    ScanMatch match = {};
+    const double match_time = measure(repetitions, [&]() { match = matcher.match(scan, guess); });
+
+    const double error = std::hypot(match.pose.x - second.x, match.pose.y - second.y);
+    const double turn_error = std::abs(match.pose.theta * 180.0 / pi - second.theta);
+    const double guess_error = std::hypot(guess.x - second.x, guess.y - second.y);
+
+    std::cout << "wheels       " << std::setw(8) << guess_error << " mm  " << 2.0 << " deg" << std::endl;
+    std::cout << "icp          " << std::setw(8) << error << " mm  " << turn_error << " deg  ("
+              << 1.0e6 * match_time << " us, " << match.iterations << " iterations, " << match.correspondences
+              << " pairs, " << match.residual << " mm rms)"
+              << (match.converged && error < 10.0 && turn_error < 0.5 ? "" : "  MISMATCH!") << std::endl;
+}
+
+/*************************************************************************************************/
+
+static void bench_pose()
+{
+    const int readers = 4;
+    const auto duration = std::chrono::milliseconds(500);
+
+    neato_config_t config = {};
+    config.update_interval_ms = 60;
+    neato_robot_t robot = nullptr;
+    if (neato_create(&robot, &config, nullptr)) {
+        std::cout << "Failed to create robot" << std::endl;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto now = []() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    };
+
+    // Several threads call method while the control thread keeps recording the pose, returning calls per second.
+    std::atomic<long> errors(0);
+    auto poll = [&](std::function<int(neato_pose_t*)> method) {
+        std::atomic<long> calls(0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < readers; i++) {
+            threads.emplace_back([&]() {
+                const auto stop = std::chrono::steady_clock::now() + duration;
+                neato_pose_t pose;
+                long count = 0;
+                for (; std::chrono::steady_clock::now() < stop; count++) {
+                    errors += (method(&pose) != 0);
+                }
+                calls += count;
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return calls / std::chrono::duration<double>(duration).count();
+    };
+
+    const double gets = poll([&](neato_pose_t* pose) { return neato_pose_get(robot, pose); });
+    const double ats = poll([&](neato_pose_t* pose) { return neato_pose_at(robot, now() - 100000000, pose); });
+
+    // Poses from before the robot was created and from the future are not available.
+    neato_pose_t pose;
+    const bool valid = errors == 0 && neato_pose_at(robot, 1, &pose) != 0
+                       && neato_pose_at(robot, now() + 1000000000, &pose) != 0;
+    neato_destroy(robot);
+
+    std::cout << "pose get     " << std::setw(8) << gets / 1.0e6 << " M/s"
+              << "  (" << readers << " readers)" << std::endl;
+    std::cout << "pose at      " << std::setw(8) << ats / 1.0e6 << " M/s"
+              << (valid ? "" : "  MISMATCH!") << std::endl;
+}
+
+/*************************************************************************************************/
+
+int main()
+{
+    std::cout << "== Laser scan parser ==" << std::endl;
+    bench_parser();
+
+    std::cout << "== Point cloud ==" << std::endl;
+    bench_points();
+
+    std::cout << "== Occupancy grid ==" << std::endl;
+    bench_map();
+
+    std::cout << "== Scan matching ==" << std::endl;
+    bench_scan_matching();
+
+    std::cout << "== Pose history ==" << std::endl;
+    bench_pose();
+
+    return 0;
+}
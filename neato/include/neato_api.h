@@ -20,9 +20,51 @@ int neato_destroy(neato_robot_t robot);
 // Get the current robot pose.
 int neato_pose_get(neato_robot_t robot, neato_pose_t* pose);
 
+// Get the robot pose at timestamp, in nanoseconds of the same clock as the timestamp of laser scans,
+// interpolated between the poses measured in the last seconds. Returns result_out_of_range if timestamp
+// is older than them, and invalid_argument if it is in the future.
+int neato_pose_at(neato_robot_t robot, uint64_t timestamp, neato_pose_t* pose);
+
 // Executes a laser scan and returns the result.
 int neato_laser_scan_get(neato_robot_t robot, neato_laser_data_t* laser);
 
+// Executes a laser scan and returns the result with intensities, errors and rotation speed.
+int neato_laser_scan_ex_get(neato_robot_t robot, neato_laser_scan_ex_t* scan);
+
+// Returns the newest laser scan if its sequence is greater than the supplied one, otherwise waits up to
+// timeout_ms for the next scan. Any number of callers may wait, all of them receive the same scan.
+// Use zero for both to get the newest scan without waiting. Returns timed_out if there is no such scan.
+// Remote robots wait at most NEATO_LASER_WAIT_MAX_MS, blocking other requests of every client meanwhile.
+int neato_laser_scan_wait(neato_robot_t robot, uint64_t sequence, unsigned int timeout_ms, neato_laser_scan_ex_t* scan);
+
+// Executes a laser scan and returns the points measured in the requested frame.
+int neato_laser_points_get(neato_robot_t robot, neato_frame_t frame, neato_laser_points_t* points);
+
+// Converts a laser scan already retrieved to points in the requested frame.
+// Executes locally, it doesn't require a robot.
+int neato_laser_points_convert(const neato_laser_data_t* laser, neato_frame_t frame, neato_laser_points_t* points);
+
+// Enables building an occupancy grid with the laser scans taken by the robot.
+// If config is null, stops taking scans for the map. The map can still be queried.
+int neato_map_set(neato_robot_t robot, const neato_map_config_t* config);
+
+// Set callback that receives the tiles changed by each scan integrated in the map.
+// Callback may read the map, but must not integrate scans or set the callback.
+int neato_map_callback_set(neato_robot_t robot, void* user_data, neato_map_callback_t callback);
+
+// Integrates a scan supplied by the caller, like a recorded one, in the map.
+int neato_map_integrate(neato_robot_t robot, const neato_laser_data_t* laser);
+
+// Get the occupancy of cells inside region of the map, stored row by row in cells.
+int neato_map_get(neato_robot_t robot, const neato_map_region_t* region, uint8_t* cells);
+
+// Enables correcting the pose returned by neato_pose_get aligning consecutive laser scans.
+// If config is null, stops aligning scans but keeps the corrections made so far.
+int neato_scan_match_set(neato_robot_t robot, const neato_scan_match_config_t* config);
+
+// Get metrics of the alignment of laser scans.
+int neato_scan_match_stats_get(neato_robot_t robot, neato_scan_match_stats_t* stats);
+
 // Changes the current robot speed in millimeters per second.
 int neato_speed_set(neato_robot_t robot, double speed);
 
@@ -32,6 +74,15 @@ int neato_is_heading_done(neato_robot_t robot, bool* done);
 // Changes the robot heading by delta degrees.
 int neato_delta_heading_set(neato_robot_t robot, double delta);
 
+// Switch callback delivery to manual drive mode, obtaining a descriptor for an external event loop.
+// No background thread is used: when fd becomes readable, call neato_process_events to run the
+// pending callbacks on the caller thread. The descriptor is edge-triggered, so always drain it.
+// Must be called before neato_map_callback_set. Only supported by remote version.
+int neato_events_fd_get(neato_robot_t robot, int* fd);
+
+// Run all pending callbacks on the calling thread. Only valid after neato_events_fd_get.
+int neato_process_events(neato_robot_t robot);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,8 @@
 #ifndef NEATO_DEFINES_H
 #define NEATO_DEFINES_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,12 +20,111 @@ typedef struct {
 // Number of lasear readings.
 #define NEATO_NUM_LASER_READINGS 360
 
+// Range of the laser in millimeters. Distances are clamped to it, so reaching it doesn't mean something was hit.
+#define NEATO_LASER_MAX_RANGE 5000
+
 // Data from a 360 degrees laser scan.
 typedef struct {
     neato_pose_t pose_taken;
     int distance[NEATO_NUM_LASER_READINGS];
 } neato_laser_data_t;
 
+// Flag set in error of neato_laser_scan_ex_t when the reading is invalid.
+// Remaining bits hold the lower bits of the error code reported by the sensor.
+#define NEATO_LASER_ERROR_INVALID 0x80
+
+// Longest wait of neato_laser_scan_wait on a remote robot, as the server handles one request at a time.
+#define NEATO_LASER_WAIT_MAX_MS 2000
+
+// Extended data from a 360 degrees laser scan, one array for each field (structure of arrays).
+// Arrays come first so each one starts at an offset multiple of 16. The structure itself is only 8 bytes
+// aligned, so vectorized consumers needing aligned arrays must allocate it 16 bytes aligned.
+typedef struct {
+    uint16_t distance[NEATO_NUM_LASER_READINGS];    // Distance in millimeters as reported by the sensor.
+    uint16_t intensity[NEATO_NUM_LASER_READINGS];   // Strength of the reflection.
+    uint8_t error[NEATO_NUM_LASER_READINGS];        // Zero if reading is valid, see NEATO_LASER_ERROR_INVALID.
+    neato_pose_t pose_taken;                        // Robot pose when scan was taken.
+    uint64_t timestamp;                             // Capture time in nanoseconds from a monotonic clock.
+    uint64_t sequence;                              // Number of the scan, increasing from one.
+    double rotation_speed;                          // Laser turns per second.
+} neato_laser_scan_ex_t;
+
+// Reference frames for points measured by the laser.
+typedef enum {
+    NEATO_FRAME_ROBOT,      // Centered at the robot, reading at 0 degrees on the x axis.
+    NEATO_FRAME_WORLD,      // Frame of the robot pose, using the pose when scan was taken.
+} neato_frame_t;
+
+// Points from valid readings of a laser scan, in millimeters, stored as one array for each coordinate.
+typedef struct {
+    float x[NEATO_NUM_LASER_READINGS];
+    float y[NEATO_NUM_LASER_READINGS];
+    int num_points;                 // Number of points in x and y, readings with errors are skipped.
+    neato_frame_t frame;            // Reference frame of the points.
+    neato_pose_t pose_taken;        // Robot pose when scan was taken.
+} neato_laser_points_t;
+
+// Cells on each side of the square tiles that compose the occupancy grid.
+#define NEATO_MAP_TILE_SIZE 32
+
+// Maximum number of cells on each side of a region read from the map.
+#define NEATO_MAP_MAX_REGION 1024
+
+// Occupancy of cells never observed by the laser. Other cells go from 0 (free) to 254 (occupied).
+#define NEATO_MAP_UNKNOWN 255
+
+// Configuration of the occupancy grid built from laser scans.
+typedef struct {
+    int resolution_mm;      // Size of each cell in millimeters, 50 when zero.
+    int scan_interval_ms;   // Minimum interval between scans taken for the map, zero for every loop.
+} neato_map_config_t;
+
+// Region of the map in cells. Cell (0, 0) has its corner at the origin of the world frame.
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} neato_map_region_t;
+
+// Tile of the map with the occupancy of each cell, row by row.
+typedef struct {
+    int x;      // Column of the first cell, multiple of NEATO_MAP_TILE_SIZE.
+    int y;      // Row of the first cell, multiple of NEATO_MAP_TILE_SIZE.
+    uint8_t cells[NEATO_MAP_TILE_SIZE * NEATO_MAP_TILE_SIZE];
+} neato_map_tile_t;
+
+// Tiles of the map changed by a laser scan.
+typedef struct {
+    unsigned int sequence;          // Number of scans integrated in the map.
+    int resolution_mm;              // Size of each cell in millimeters.
+    neato_pose_t pose_taken;        // Robot pose when scan was taken.
+    int num_tiles;
+    const neato_map_tile_t* tiles;
+} neato_map_update_t;
+
+// Callback used to receive changes of the map.
+typedef void(*neato_map_callback_t)(void* user_data, const neato_map_update_t* update);
+
+// Configuration of the correction of odometry aligning consecutive laser scans (scan matching).
+typedef struct {
+    int scan_interval_ms;   // Minimum interval between scans matched, zero for every loop.
+    int max_iterations;     // Iterations of each alignment, 20 when zero.
+    int max_time_ms;        // Time budget of each alignment, 20 ms when zero.
+    int max_distance_mm;    // Maximum distance between paired points, 10 to 1000 mm, 300 mm when zero.
+} neato_scan_match_config_t;
+
+// Metrics of scan matching.
+typedef struct {
+    unsigned int scans;         // Scans aligned with the previous one.
+    unsigned int converged;     // Scans where alignment converged, the others keep wheel odometry.
+    int iterations;             // Iterations of the last alignment.
+    int correspondences;        // Points paired with the previous scan on the last alignment.
+    double residual_mm;         // RMS distance of paired points to the previous scan.
+    double time_ms;             // Time spent on the last alignment.
+    neato_pose_t correction;    // Correction applied to wheel odometry.
+} neato_scan_match_stats_t;
+
 // Configuration specified during robot creation.
 typedef struct {
 
@@ -18,6 +18,17 @@ int neato_server_start(neato_server_t* server, const char* address);
 // Stop server
 int neato_server_stop(neato_server_t server);
 
+// Start server in manual drive mode. No background thread is launched.
+// Requests are only processed when neato_server_process_events is called.
+int neato_server_start_manual(neato_server_t* server, const char* address);
+
+// Get descriptor that signals pending requests for a server started in manual drive mode.
+// The descriptor is edge-triggered: once readable, call neato_server_process_events to drain it.
+int neato_server_events_fd_get(neato_server_t server, int* fd);
+
+// Process all pending requests on the calling thread.
+int neato_server_process_events(neato_server_t server);
+
 #ifdef __cplusplus
 }
 #endif
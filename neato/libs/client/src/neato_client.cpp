@@ -2,6 +2,10 @@
 
 #include "jaw_client.hpp"
 #include "neato_protocol.hpp"
+#include "neato_laser.hpp"
+#include "jaw_protected_call.hpp"
+
+#include <algorithm>
 
 using namespace Jaw;
 using namespace Neato;
@@ -44,6 +48,16 @@ int neato_pose_get(neato_robot_t robot, neato_pose_t* pose)
 
 /*************************************************************************************************/
 
+int neato_pose_at(neato_robot_t robot, uint64_t timestamp, neato_pose_t* pose)
+{
+    if (!pose) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return NeatoClient::request(robot, Command::POSE_AT, kTimeout, std::forward_as_tuple(timestamp), *pose);
+}
+
+/*************************************************************************************************/
+
 int neato_laser_scan_get(neato_robot_t robot, neato_laser_data_t* laser_data)
 {
     if (!laser_data) {
@@ -54,6 +68,117 @@ int neato_laser_scan_get(neato_robot_t robot, neato_laser_data_t* laser_data)
 
 /*************************************************************************************************/
 
+int neato_laser_scan_ex_get(neato_robot_t robot, neato_laser_scan_ex_t* scan)
+{
+    if (!scan) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return NeatoClient::request(robot, Command::LASER_SCAN_EX_GET, kTimeout, *scan);
+}
+
+/*************************************************************************************************/
+
+int neato_laser_scan_wait(neato_robot_t robot, uint64_t sequence, unsigned int timeout_ms, neato_laser_scan_ex_t* scan)
+{
+    if (!scan) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    // Server may wait the whole timeout, up to its limit, before replying.
+    const unsigned int wait_ms = std::min(timeout_ms, static_cast<unsigned int>(NEATO_LASER_WAIT_MAX_MS));
+    return NeatoClient::request(robot, Command::LASER_SCAN_WAIT, kTimeout + std::chrono::milliseconds(wait_ms),
+                                std::forward_as_tuple(sequence, timeout_ms), *scan);
+}
+
+/*************************************************************************************************/
+
+int neato_laser_points_get(neato_robot_t robot, neato_frame_t frame, neato_laser_points_t* points)
+{
+    if (!points) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return NeatoClient::request(robot, Command::LASER_POINTS_GET, kTimeout, std::forward_as_tuple(frame), *points);
+}
+
+/*************************************************************************************************/
+
+int neato_laser_points_convert(const neato_laser_data_t* laser, neato_frame_t frame, neato_laser_points_t* points)
+{
+    if (!laser || !points) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return protected_call([&laser, &frame, &points]() {
+        laser_points(*laser, frame, *points);
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+int neato_map_set(neato_robot_t robot, const neato_map_config_t* config)
+{
+    const neato_map_config_t disabled = {};
+    return NeatoClient::request(robot, Command::MAP_SET, kTimeout,
+                                std::forward_as_tuple(config != nullptr, config ? *config : disabled));
+}
+
+/*************************************************************************************************/
+
+int neato_map_callback_set(neato_robot_t robot, void* user_data, neato_map_callback_t callback)
+{
+    if (!callback) {
+        return NeatoClient::set_callback(robot, Command::MAP_CALLBACK_SET, kTimeout, nullptr);
+    }
+
+    return NeatoClient::set_callback(robot, Command::MAP_CALLBACK_SET, kTimeout,
+        [user_data, callback](InputBuffer message) {
+            neato_map_update_t update = {};
+            read(message, update);
+            callback(user_data, &update);
+        });
+}
+
+/*************************************************************************************************/
+
+int neato_map_integrate(neato_robot_t robot, const neato_laser_data_t* laser)
+{
+    if (!laser) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return NeatoClient::request(robot, Command::MAP_INTEGRATE, kTimeout, std::forward_as_tuple(*laser));
+}
+
+/*************************************************************************************************/
+
+int neato_map_get(neato_robot_t robot, const neato_map_region_t* region, uint8_t* cells)
+{
+    if (!region || !cells || region->width <= 0 || region->height <= 0) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    MapCells output = { cells, static_cast<std::size_t>(region->width) * region->height };
+    return NeatoClient::request(robot, Command::MAP_GET, kTimeout, std::forward_as_tuple(*region), output);
+}
+
+/*************************************************************************************************/
+
+int neato_scan_match_set(neato_robot_t robot, const neato_scan_match_config_t* config)
+{
+    const neato_scan_match_config_t disabled = {};
+    return NeatoClient::request(robot, Command::SCAN_MATCH_SET, kTimeout,
+                                std::forward_as_tuple(config != nullptr, config ? *config : disabled));
+}
+
+/*************************************************************************************************/
+
+int neato_scan_match_stats_get(neato_robot_t robot, neato_scan_match_stats_t* stats)
+{
+    if (!stats) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return NeatoClient::request(robot, Command::SCAN_MATCH_STATS_GET, kTimeout, *stats);
+}
+
+/*************************************************************************************************/
+
 int neato_speed_set(neato_robot_t robot, double speed)
 {
     return NeatoClient::request(robot, Command::SPEED_SET, kTimeout, std::forward_as_tuple(speed));
@@ -74,3 +199,17 @@ int neato_delta_heading_set(neato_robot_t robot, double delta)
 }
 
 /*************************************************************************************************/
+
+int neato_events_fd_get(neato_robot_t robot, int* fd)
+{
+    return NeatoClient::events_fd(robot, fd);
+}
+
+/*************************************************************************************************/
+
+int neato_process_events(neato_robot_t robot)
+{
+    return NeatoClient::process_events(robot);
+}
+
+/*************************************************************************************************/
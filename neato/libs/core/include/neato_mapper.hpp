@@ -0,0 +1,93 @@
+#ifndef NEATO_MAPPER_H
+#define NEATO_MAPPER_H
+
+#include "neato_defines.h"
+#include "neato_occupancy_grid.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Build an occupancy grid from laser scans, reporting changed tiles to a callback.
+// Scans taken by the robot are integrated by a background thread so the robot loop never waits.
+class Mapper
+{
+public:
+    // Construct mapper disabled, with an empty map.
+    Mapper();
+
+    // Stop background thread.
+    ~Mapper();
+
+    // Enable integrating scans taken by the robot with supplied configuration, disabling when null.
+    // The map is kept when disabled, changing resolution starts a new one.
+    // Throws Jaw::Exception if configuration is invalid.
+    void set_config(const neato_map_config_t* config);
+
+    // Set callback that will receive changed tiles. Once it returns the previous callback is no longer called.
+    void set_callback(void* user_data, neato_map_callback_t callback);
+
+    // Return true if robot should take a scan for the map now.
+    bool wants_scan();
+
+    // Queue scan taken by the robot to be integrated, replacing one still waiting.
+    void submit(const neato_laser_data_t& laser);
+
+    // Integrate scan on calling thread, even if disabled.
+    void integrate(const neato_laser_data_t& laser);
+
+    // Get occupancy of cells inside region. Throws Jaw::Exception if region is invalid.
+    void get_region(const neato_map_region_t& region, std::uint8_t* cells);
+
+private:
+    // Start or stop the thread integrating submitted scans.
+    void start_thread(std::chrono::milliseconds interval);
+    void stop_thread();
+
+    // Method executed by background thread.
+    void thread_loop();
+
+    // Map and number of scans integrated on it.
+    std::unique_ptr<OccupancyGrid> grid_;
+    unsigned int sequence_;
+
+    // Callback set by the user and tiles reported to it.
+    void* user_data_;
+    neato_map_callback_t callback_;
+    std::vector<neato_map_tile_t> tiles_;
+
+    // Protect access to map and callback.
+    std::mutex mutex_;
+
+    // Serialize calls to the callback, which are made without holding mutex_ so it can read the map.
+    std::mutex callback_mutex_;
+
+    // Serialize changes of configuration.
+    std::mutex config_mutex_;
+
+    // Scan waiting to be integrated and when robot should take the next one.
+    neato_laser_data_t pending_;
+    bool has_pending_;
+    bool enabled_;
+    bool stopping_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point next_scan_;
+    std::mutex pending_mutex_;
+    std::condition_variable scan_ready_;
+
+    // Thread integrating submitted scans.
+    std::thread thread_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // NEATO_MAPPER_H
@@ -0,0 +1,82 @@
+#ifndef NEATO_OCCUPANCY_GRID_H
+#define NEATO_OCCUPANCY_GRID_H
+
+#include "neato_defines.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Occupancy of the plane around the robot, kept as log-odds of each cell being occupied.
+// Cells are stored in square tiles of NEATO_MAP_TILE_SIZE cells allocated when a beam reaches them.
+class OccupancyGrid
+{
+public:
+    // Create an empty grid with cells of supplied size.
+    explicit OccupancyGrid(int resolution_mm);
+
+    // Can't copy grid.
+    OccupancyGrid(const OccupancyGrid&) = delete;
+
+    // Size of each cell in millimeters.
+    int resolution() const;
+
+    // Integrate laser scan taken at laser.pose_taken. Cells crossed by each beam become more likely
+    // free and the cell where it ends more likely occupied. Readings at max_range only clear cells.
+    void integrate(const neato_laser_data_t& laser, int max_range);
+
+    // Get tiles changed since last call with their occupancy, or just forget them if tiles is null.
+    void take_changed(std::vector<neato_map_tile_t>* tiles);
+
+    // Get occupancy of cells inside region, NEATO_MAP_UNKNOWN for cells never observed.
+    void read(const neato_map_region_t& region, std::uint8_t* cells) const;
+
+private:
+    // Tile with log-odds of each cell, row by row.
+    struct Tile
+    {
+        int x;          // Column of the tile (in tiles).
+        int y;          // Row of the tile (in tiles).
+        bool changed;   // True if tile is in changed_ list.
+        std::int16_t log_odds[NEATO_MAP_TILE_SIZE * NEATO_MAP_TILE_SIZE];
+    };
+
+    // Get tile at supplied column and row creating it if needed.
+    Tile& tile(int x, int y);
+
+    // Get tile at supplied column and row, null if it doesn't exist.
+    const Tile* find(int x, int y) const;
+
+    // Add delta to the log-odds of cell.
+    void update(int x, int y, int delta);
+
+    // Update cells from (x0, y0) to (x1, y1) using Bresenham's line algorithm.
+    void trace(int x0, int y0, int x1, int y1, bool hit);
+
+    // Size of each cell in millimeters.
+    int resolution_;
+
+    // Tiles indexed by column and row, tiles are never moved once created.
+    std::unordered_map<std::uint64_t, std::unique_ptr<Tile>> tiles_;
+
+    // Tiles changed since last call to take_changed.
+    std::vector<Tile*> changed_;
+
+    // Last tile updated, consecutive cells of a beam are usually on the same tile.
+    Tile* last_;
+
+    // Position where each valid beam ends.
+    float end_x_[NEATO_NUM_LASER_READINGS];
+    float end_y_[NEATO_NUM_LASER_READINGS];
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // NEATO_OCCUPANCY_GRID_H
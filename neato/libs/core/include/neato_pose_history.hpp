@@ -0,0 +1,62 @@
+#ifndef NEATO_POSE_HISTORY_H
+#define NEATO_POSE_HISTORY_H
+
+#include "neato_defines.h"
+
+#include <atomic>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Poses measured by odometry in the last seconds, with the time they were measured.
+// A single thread records poses without ever waiting, any number of threads read them without
+// locks, retrying if a pose was recorded while they were reading (seqlock).
+class PoseHistory
+{
+public:
+    // Construct history without poses.
+    PoseHistory();
+
+    // Can't copy history.
+    PoseHistory(const PoseHistory&) = delete;
+
+    // Record pose measured at timestamp, in nanoseconds of the steady clock, replacing the oldest one.
+    // Timestamp should be newer than the previous ones. Only one thread may record poses.
+    void record(uint64_t timestamp, const neato_pose_t& pose);
+
+    // Newest pose recorded, zero if there is none.
+    neato_pose_t latest() const;
+
+    // Pose at timestamp interpolated between the recorded ones, or the newest one if timestamp is newer.
+    // Return false if there are no poses or timestamp is older than all of them.
+    bool at(uint64_t timestamp, neato_pose_t* pose) const;
+
+private:
+    // Pose and its timestamp, atomic so readers may race with the writer.
+    struct Sample
+    {
+        std::atomic<uint64_t> timestamp;
+        std::atomic<double> x;
+        std::atomic<double> y;
+        std::atomic<double> theta;
+    };
+
+    // Run function reading samples until no pose was recorded while it executed.
+    template<class Function>
+    void read(Function function) const;
+
+    // Samples reused in turn, covering a few seconds at the fastest update interval.
+    static const unsigned int kNumSamples = 128;
+    Sample samples_[kNumSamples];
+
+    // Number of poses recorded, and version of samples, odd while a pose is being recorded.
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> version_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // NEATO_POSE_HISTORY_H
@@ -4,13 +4,19 @@
 #include "neato_defines.h"
 
 #include "jaw_exception.hpp"
-#include "neato_serial_port.hpp"
+#include "neato_serial_scheduler.hpp"
+#include "neato_laser.hpp"
+#include "neato_mapper.hpp"
+#include "neato_scan_odometry.hpp"
+#include "neato_scan_cache.hpp"
+#include "neato_pose_history.hpp"
 
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <memory>
+#include <array>
 
 namespace Neato  {
 
@@ -32,9 +38,21 @@ public:
     // Get current robot pose (x, y, theta).
     neato_pose_t get_pose();
 
+    // Get robot pose at timestamp (nanoseconds of the steady clock), interpolating the recent ones.
+    void get_pose_at(uint64_t timestamp, neato_pose_t* pose);
+
     // Perform a laser scan saving the results on the supplied structure.
     void get_laser_scan(neato_laser_data_t* laser_data);
 
+    // Perform a laser scan saving the results with intensities and errors on the supplied structure.
+    void get_laser_scan_ex(neato_laser_scan_ex_t* scan);
+
+    // Get newest laser scan if its sequence is greater than supplied one, waiting up to timeout_ms otherwise.
+    void wait_laser_scan(uint64_t sequence, unsigned int timeout_ms, neato_laser_scan_ex_t* scan);
+
+    // Perform a laser scan saving the points measured in supplied frame.
+    void get_laser_points(neato_frame_t frame, neato_laser_points_t* points);
+
     // Set the current translational speed.
     void set_speed(double speed);
 
@@ -44,42 +62,63 @@ public:
     // Request a change in heading direction by delta degrees.
     void set_delta_heading(double delta);
 
+    // Enable building the map with laser scans, disabling when config is null.
+    void set_map(const neato_map_config_t* config);
+
+    // Set callback that will receive changes of the map.
+    void set_map_callback(void* user_data, neato_map_callback_t callback);
+
+    // Integrate supplied scan in the map.
+    void integrate_map(const neato_laser_data_t* laser);
+
+    // Get occupancy of cells inside region of the map.
+    void get_map(const neato_map_region_t* region, uint8_t* cells);
+
+    // Enable correcting the pose with scan matching, disabling when config is null.
+    void set_scan_match(const neato_scan_match_config_t* config);
+
+    // Get metrics of scan matching.
+    void get_scan_match_stats(neato_scan_match_stats_t* stats);
+
 private:
 
     // Read left and right wheel distance in millimeters.
     void read_odometry(int& left_distance, int& right_distance);
 
     // Read laser information
-    void read_laser(neato_laser_data_t* laser_data);
+    void read_laser(neato_laser_scan_ex_t* scan);
+
+    // Method executed by control thread, updating odometry and motors at a fixed rate.
+    void control_loop();
 
-    // Method executed by main thread
-    void main_loop();
+    // Method executed by laser thread, reading scans when requested or needed by the map or scan matching.
+    void laser_loop();
 
-    // Serial connection used to communicate with the robot.
-    std::shared_ptr<SerialPort> serial_;
+    // Serial connection used to communicate with the robot, shared by control and laser threads.
+    std::unique_ptr<SerialScheduler> scheduler_;
 
-    // Current robot pose.
+    // Current robot pose, only used by control thread.
     neato_pose_t pose_;
 
+    // Poses published by control thread, with the time they were measured.
+    PoseHistory pose_history_;
+
     // Current robot speed.
     std::atomic<double> speed_;
 
     // Difference in defined by set_delta_heading.
     std::atomic<double> delta_heading_;
 
-    // Pointer to array of laser data supplied by get_laser_scan.
-    neato_laser_data_t* laser_data_;
+    // Newest laser scan, shared by every reader.
+    ScanCache scan_cache_;
+
+    // Result of GetLDSScan and the scan parsed from it, reused by every read.
+    std::array<char, 16384> laser_buffer_;
+    LaserScan laser_scan_;
 
     // The interval in miliseconds between each loop call.
     std::chrono::milliseconds interval_;
 
-    // Mutex used to protect attributes access.
-    std::mutex pose_mutex_;
-    std::mutex laser_mutex_;
-
-    // Conditionals used synchronize events.
-    std::condition_variable laser_ready_;
-
     // Current displacement of left and right wheels measured by the robot.
     int left_wheel_distance_;
     int right_wheel_distance_;
@@ -87,8 +126,15 @@ private:
     // Used to indicate if thread should keep running or stop.
     std::atomic<bool> keep_running_;
 
+    // Occupancy grid built with laser scans.
+    std::unique_ptr<Mapper> mapper_;
+
+    // Correction of odometry aligning consecutive scans.
+    std::unique_ptr<ScanOdometry> scan_odometry_;
+
     // Threads responsible for asynchronous execution.
-    std::unique_ptr<std::thread> main_thread_;
+    std::unique_ptr<std::thread> control_thread_;
+    std::unique_ptr<std::thread> laser_thread_;
 };
 
 /*************************************************************************************************/
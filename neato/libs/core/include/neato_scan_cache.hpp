@@ -0,0 +1,82 @@
+#ifndef NEATO_SCAN_CACHE_H
+#define NEATO_SCAN_CACHE_H
+
+#include "neato_defines.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Keep the newest laser scan for any number of readers. Scans are published in one of three slots,
+// so readers copy them without locks while the next one is written, retrying in the rare case the
+// slot was reused while copying (seqlock). Locks are only taken by readers waiting for a new scan.
+class ScanCache
+{
+public:
+    // Construct cache without scans.
+    ScanCache();
+
+    // Can't copy cache.
+    ScanCache(const ScanCache&) = delete;
+
+    // Store scan as the newest one, assigning its sequence and waking readers waiting for it.
+    // Only one thread may publish scans.
+    void publish(const neato_laser_scan_ex_t& scan);
+
+    // Sequence of newest scan, zero if there is none.
+    uint64_t sequence() const;
+
+    // Copy newest scan if its sequence is greater than supplied one, returning false otherwise. Never blocks.
+    bool read_newer(uint64_t sequence, neato_laser_scan_ex_t* scan);
+
+    // Copy scan with sequence greater than supplied one, waiting up to timeout for it to be published.
+    // Return false if it wasn't published in time or cache was closed.
+    bool wait_newer(uint64_t sequence, std::chrono::milliseconds timeout, neato_laser_scan_ex_t* scan);
+
+    // Wait until deadline or a reader waits for a scan newer than the last published.
+    // Return true if there is such reader.
+    bool wait_requested(std::chrono::steady_clock::time_point deadline);
+
+    // Wake readers and writer, readers waiting fail.
+    void close();
+
+private:
+    // Scan stored as words, so readers copying it may race with the writer.
+    static const std::size_t kNumWords = sizeof(neato_laser_scan_ex_t) / sizeof(uint64_t);
+    static_assert(sizeof(neato_laser_scan_ex_t) % sizeof(uint64_t) == 0, "Scan must be made of whole words");
+
+    // Scan and its version, odd while being written.
+    struct Slot
+    {
+        std::atomic<uint64_t> version;
+        std::atomic<uint64_t> words[kNumWords];
+    };
+
+    // Slots reused in turn, scan with sequence n is at n % kNumSlots.
+    static const unsigned int kNumSlots = 3;
+    Slot slots_[kNumSlots];
+
+    // Sequence of newest scan.
+    std::atomic<uint64_t> sequence_;
+
+    // Sequence awaited by readers, and whether cache was closed.
+    uint64_t requested_;
+    bool closed_;
+
+    // Protect attributes above and signal changes in them or in sequence.
+    std::mutex mutex_;
+    std::condition_variable published_;
+    std::condition_variable request_changed_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // NEATO_SCAN_CACHE_H
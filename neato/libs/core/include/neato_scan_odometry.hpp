@@ -0,0 +1,90 @@
+#ifndef NEATO_SCAN_ODOMETRY_H
+#define NEATO_SCAN_ODOMETRY_H
+
+#include "neato_defines.h"
+#include "neato_scan_matcher.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Correct wheel odometry aligning consecutive laser scans. Scans are matched by a background
+// thread, the motion found replaces the one measured by the wheels between both scans.
+// Poses are in millimeters and radians.
+class ScanOdometry
+{
+public:
+    // Construct disabled, without correction.
+    ScanOdometry();
+
+    // Stop background thread.
+    ~ScanOdometry();
+
+    // Enable matching scans taken by the robot with supplied configuration, disabling when null.
+    // Corrections made so far are kept when disabled. Throws Jaw::Exception if configuration is invalid.
+    void set_config(const neato_scan_match_config_t* config);
+
+    // Return true if robot should take a scan for matching now.
+    bool wants_scan();
+
+    // Queue scan taken by the robot at supplied odometry pose, replacing one still waiting.
+    void submit(const neato_laser_data_t& laser, const neato_pose_t& odometry);
+
+    // Apply correction to pose measured by wheel odometry.
+    neato_pose_t correct(const neato_pose_t& odometry);
+
+    // Get metrics of the matching.
+    void get_stats(neato_scan_match_stats_t* stats);
+
+private:
+    // Start or stop the thread matching submitted scans.
+    void start_thread(std::chrono::milliseconds interval);
+    void stop_thread();
+
+    // Method executed by background thread.
+    void thread_loop();
+
+    // Match scan with previous one updating the correction.
+    void process(const neato_laser_data_t& laser, const neato_pose_t& odometry);
+
+    // Used only by background thread: matcher holding previous scan, and odometry and corrected
+    // pose when it was taken.
+    ScanMatcher matcher_;
+    neato_pose_t reference_odometry_;
+    neato_pose_t reference_pose_;
+
+    // Transformation from odometry to corrected pose, and metrics.
+    neato_pose_t correction_;
+    neato_scan_match_stats_t stats_;
+
+    // Protect access to correction and metrics.
+    std::mutex mutex_;
+
+    // Serialize changes of configuration.
+    std::mutex config_mutex_;
+
+    // Scan waiting to be matched and when robot should take the next one.
+    neato_laser_data_t pending_;
+    neato_pose_t pending_odometry_;
+    bool has_pending_;
+    bool enabled_;
+    bool stopping_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point next_scan_;
+    std::mutex pending_mutex_;
+    std::condition_variable scan_ready_;
+
+    // Thread matching submitted scans.
+    std::thread thread_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // NEATO_SCAN_ODOMETRY_H
@@ -22,6 +22,10 @@ public:
 
     // Send command to serial and read reasult.
     virtual std::string execute(const std::string& command) = 0;
+
+    // Send command to serial and read result into buffer with supplied size, returning its length.
+    // Result is null terminated, so it must be shorter than size. Throws Jaw::Exception if it isn't.
+    virtual std::size_t execute(const std::string& command, char* buffer, std::size_t size) = 0;
 };
 
 /*************************************************************************************************/
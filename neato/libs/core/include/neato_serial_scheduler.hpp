@@ -0,0 +1,79 @@
+#ifndef NEATO_SERIAL_SCHEDULER_H
+#define NEATO_SERIAL_SCHEDULER_H
+
+#include "neato_serial_port.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Share the serial link between threads, giving it to control commands before background ones.
+// A command can't be interrupted once sent, so background commands also wait if they are expected
+// to last beyond the next time control commands will be sent.
+class SerialScheduler
+{
+public:
+    // Priority of commands.
+    enum class Priority
+    {
+        CONTROL,        // Odometry and motors, sent at a fixed rate.
+        BACKGROUND,     // Slow commands like laser scans, sent between control commands.
+    };
+
+    // Schedule commands sent to supplied serial port.
+    explicit SerialScheduler(std::shared_ptr<SerialPort> serial);
+
+    // Can't copy scheduler.
+    SerialScheduler(const SerialScheduler&) = delete;
+
+    // Set when control commands will be sent next, time_point::max() if they won't be sent anymore.
+    // Only one background command may start after this call if none fits before that time.
+    void set_next_control(std::chrono::steady_clock::time_point when);
+
+    // Send command to serial and read result, waiting for its turn.
+    std::string execute(Priority priority, const std::string& command);
+
+    // Send command to serial and read result into buffer with supplied size, waiting for its turn.
+    std::size_t execute(Priority priority, const std::string& command, char* buffer, std::size_t size);
+
+private:
+    // Hold the link while alive.
+    class Turn;
+
+    // Wait until command with supplied priority can use the link.
+    void acquire(Priority priority);
+
+    // Release link used by command with supplied priority since start.
+    void release(Priority priority, std::chrono::steady_clock::time_point start);
+
+    // Serial port shared.
+    std::shared_ptr<SerialPort> serial_;
+
+    // True while a command is using the link, and number of control commands waiting for it.
+    bool busy_;
+    unsigned int waiting_control_;
+
+    // Next time control commands will be sent, and whether a background command already
+    // started since it was set.
+    std::chrono::steady_clock::time_point next_control_;
+    bool gap_open_;
+
+    // Expected duration of background commands, average of previous ones.
+    std::chrono::steady_clock::duration background_duration_;
+
+    // Protect attributes above and signal when link is released.
+    std::mutex mutex_;
+    std::condition_variable released_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // NEATO_SERIAL_SCHEDULER_H
@@ -47,6 +47,13 @@ int neato_pose_get(neato_robot_t robot, neato_pose_t* pose)
 
 /*************************************************************************************************/
 
+int neato_pose_at(neato_robot_t robot, uint64_t timestamp, neato_pose_t* pose)
+{
+    return member_call(robot, &Robot::get_pose_at, timestamp, pose);
+}
+
+/*************************************************************************************************/
+
 int neato_laser_scan_get(neato_robot_t robot, neato_laser_data_t* laser_data)
 {
     return member_call(robot, &Robot::get_laser_scan, laser_data);
@@ -54,6 +61,82 @@ int neato_laser_scan_get(neato_robot_t robot, neato_laser_data_t* laser_data)
 
 /*************************************************************************************************/
 
+int neato_laser_scan_ex_get(neato_robot_t robot, neato_laser_scan_ex_t* scan)
+{
+    return member_call(robot, &Robot::get_laser_scan_ex, scan);
+}
+
+/*************************************************************************************************/
+
+int neato_laser_scan_wait(neato_robot_t robot, uint64_t sequence, unsigned int timeout_ms, neato_laser_scan_ex_t* scan)
+{
+    return member_call(robot, &Robot::wait_laser_scan, sequence, timeout_ms, scan);
+}
+
+/*************************************************************************************************/
+
+int neato_laser_points_get(neato_robot_t robot, neato_frame_t frame, neato_laser_points_t* points)
+{
+    return member_call(robot, &Robot::get_laser_points, frame, points);
+}
+
+/*************************************************************************************************/
+
+int neato_laser_points_convert(const neato_laser_data_t* laser, neato_frame_t frame, neato_laser_points_t* points)
+{
+    if (!laser || !points) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return protected_call([&laser, &frame, &points]() {
+        laser_points(*laser, frame, *points);
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+int neato_map_set(neato_robot_t robot, const neato_map_config_t* config)
+{
+    return member_call(robot, &Robot::set_map, config);
+}
+
+/*************************************************************************************************/
+
+int neato_map_callback_set(neato_robot_t robot, void* user_data, neato_map_callback_t callback)
+{
+    return member_call(robot, &Robot::set_map_callback, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+int neato_map_integrate(neato_robot_t robot, const neato_laser_data_t* laser)
+{
+    return member_call(robot, &Robot::integrate_map, laser);
+}
+
+/*************************************************************************************************/
+
+int neato_map_get(neato_robot_t robot, const neato_map_region_t* region, uint8_t* cells)
+{
+    return member_call(robot, &Robot::get_map, region, cells);
+}
+
+/*************************************************************************************************/
+
+int neato_scan_match_set(neato_robot_t robot, const neato_scan_match_config_t* config)
+{
+    return member_call(robot, &Robot::set_scan_match, config);
+}
+
+/*************************************************************************************************/
+
+int neato_scan_match_stats_get(neato_robot_t robot, neato_scan_match_stats_t* stats)
+{
+    return member_call(robot, &Robot::get_scan_match_stats, stats);
+}
+
+/*************************************************************************************************/
+
 int neato_speed_set(neato_robot_t robot, double speed)
 {
     return member_call(robot, &Robot::set_speed, speed);
@@ -74,3 +157,18 @@ int neato_delta_heading_set(neato_robot_t robot, double delta)
 }
 
 /*************************************************************************************************/
+
+int neato_events_fd_get(neato_robot_t, int*)
+{
+    // Local callbacks are always delivered by the robot threads.
+    return static_cast<int>(std::errc::function_not_supported);
+}
+
+/*************************************************************************************************/
+
+int neato_process_events(neato_robot_t)
+{
+    return static_cast<int>(std::errc::function_not_supported);
+}
+
+/*************************************************************************************************/
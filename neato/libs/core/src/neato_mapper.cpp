@@ -0,0 +1,199 @@
+#include "neato_mapper.hpp"
+
+#include "jaw_exception.hpp"
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Resolution used when configuration leaves it at zero.
+static const int kDefaultResolution = 50;
+
+/*************************************************************************************************/
+
+Mapper::Mapper()
+    : grid_(new OccupancyGrid(kDefaultResolution))
+    , sequence_(0)
+    , user_data_(nullptr)
+    , callback_(nullptr)
+    , tiles_()
+    , mutex_()
+    , callback_mutex_()
+    , config_mutex_()
+    , pending_()
+    , has_pending_(false)
+    , enabled_(false)
+    , stopping_(false)
+    , interval_(0)
+    , next_scan_()
+    , pending_mutex_()
+    , scan_ready_()
+    , thread_()
+{}
+
+/*************************************************************************************************/
+
+Mapper::~Mapper()
+{
+    stop_thread();
+}
+
+/*************************************************************************************************/
+
+void Mapper::set_config(const neato_map_config_t* config)
+{
+    if (config && (config->resolution_mm < 0 || config->resolution_mm > 1000 || config->scan_interval_ms < 0)) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid map configuration");
+    }
+
+    // Thread must stop before taking the map, it may be waiting for it.
+    std::lock_guard<std::mutex> config_lock(config_mutex_);
+    stop_thread();
+    if (!config) {
+        return;
+    }
+
+    const int resolution = config->resolution_mm ? config->resolution_mm : kDefaultResolution;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (resolution != grid_->resolution()) {
+            grid_.reset(new OccupancyGrid(resolution));
+            sequence_ = 0;
+        }
+    }
+    start_thread(std::chrono::milliseconds(config->scan_interval_ms));
+}
+
+/*************************************************************************************************/
+
+void Mapper::set_callback(void* user_data, neato_map_callback_t callback)
+{
+    std::lock_guard<std::mutex> callback_lock(callback_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    user_data_ = user_data;
+    callback_ = callback;
+}
+
+/*************************************************************************************************/
+
+bool Mapper::wants_scan()
+{
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    if (!enabled_) {
+        return false;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_scan_) {
+        return false;
+    }
+    next_scan_ = now + interval_;
+    return true;
+}
+
+/*************************************************************************************************/
+
+void Mapper::submit(const neato_laser_data_t& laser)
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_ = laser;
+        has_pending_ = true;
+    }
+    scan_ready_.notify_one();
+}
+
+/*************************************************************************************************/
+
+void Mapper::integrate(const neato_laser_data_t& laser)
+{
+    // Updates reach the callback in the order they were made, tiles_ is only used while holding callback_mutex_.
+    std::lock_guard<std::mutex> callback_lock(callback_mutex_);
+    void* user_data = nullptr;
+    neato_map_callback_t callback = nullptr;
+    neato_map_update_t update = {};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        grid_->integrate(laser, NEATO_LASER_MAX_RANGE);
+        grid_->take_changed(callback_ ? &tiles_ : nullptr);
+        sequence_++;
+
+        user_data = user_data_;
+        callback = callback_;
+        update.sequence = sequence_;
+        update.resolution_mm = grid_->resolution();
+    }
+
+    if (callback) {
+        update.pose_taken = laser.pose_taken;
+        update.num_tiles = static_cast<int>(tiles_.size());
+        update.tiles = tiles_.data();
+        callback(user_data, &update);
+    }
+}
+
+/*************************************************************************************************/
+
+void Mapper::get_region(const neato_map_region_t& region, std::uint8_t* cells)
+{
+    if (region.width <= 0 || region.height <= 0 ||
+        region.width > NEATO_MAP_MAX_REGION || region.height > NEATO_MAP_MAX_REGION) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid map region");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    grid_->read(region, cells);
+}
+
+/*************************************************************************************************/
+
+void Mapper::start_thread(std::chrono::milliseconds interval)
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        enabled_ = true;
+        stopping_ = false;
+        has_pending_ = false;
+        interval_ = interval;
+        next_scan_ = std::chrono::steady_clock::now();
+    }
+    thread_ = std::thread(&Mapper::thread_loop, this);
+}
+
+/*************************************************************************************************/
+
+void Mapper::stop_thread()
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        enabled_ = false;
+        stopping_ = true;
+    }
+    scan_ready_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/*************************************************************************************************/
+
+void Mapper::thread_loop()
+{
+    neato_laser_data_t laser;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex_);
+            scan_ready_.wait(lock, [this]() { return stopping_ || has_pending_; });
+            if (stopping_) {
+                return;
+            }
+            laser = pending_;
+            has_pending_ = false;
+        }
+        integrate(laser);
+    }
+}
+
+/*************************************************************************************************/
+
+}
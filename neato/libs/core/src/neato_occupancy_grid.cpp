@@ -0,0 +1,239 @@
+#include "neato_occupancy_grid.hpp"
+
+#include "neato_laser.hpp"
+#include "jaw_exception.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+namespace {
+
+// Tiles have a power of two size so cells are found with shifts and masks.
+const int kTileShift = 5;
+const int kTileMask = NEATO_MAP_TILE_SIZE - 1;
+static_assert(NEATO_MAP_TILE_SIZE == (1 << kTileShift), "Tile size must match shift");
+
+// Log-odds are fixed point numbers scaled by 100. A hit has probability 0.7 of being right,
+// a miss 0.6. Limits keep the map able to change when something moves.
+const int kHit = 85;
+const int kMiss = -41;
+const int kMinLogOdds = -200;
+const int kMaxLogOdds = 350;
+
+// Value of cells never observed, zero would make it impossible to tell them from uncertain ones.
+const std::int16_t kUnknown = std::numeric_limits<std::int16_t>::min();
+
+// Occupancy reported for each log-odds, from 0 (free) to 254 (occupied).
+struct OccupancyTable
+{
+    OccupancyTable()
+    {
+        for (int i = kMinLogOdds; i <= kMaxLogOdds; i++) {
+            const double probability = 1.0 / (1.0 + std::exp(-i / 100.0));
+            values[i - kMinLogOdds] = static_cast<std::uint8_t>(std::lround(probability * 254.0));
+        }
+    }
+
+    std::uint8_t operator()(std::int16_t log_odds) const
+    {
+        return log_odds == kUnknown ? NEATO_MAP_UNKNOWN : values[log_odds - kMinLogOdds];
+    }
+
+    std::uint8_t values[kMaxLogOdds - kMinLogOdds + 1];
+};
+
+const OccupancyTable& occupancy()
+{
+    static const OccupancyTable table;
+    return table;
+}
+
+// Key of tile at supplied column and row.
+std::uint64_t tile_key(int x, int y)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+}
+
+// Cell containing coordinate in millimeters.
+int cell_at(double coordinate, int resolution)
+{
+    return static_cast<int>(std::floor(coordinate / resolution));
+}
+
+}
+
+/*************************************************************************************************/
+
+OccupancyGrid::OccupancyGrid(int resolution_mm)
+    : resolution_(resolution_mm)
+    , tiles_()
+    , changed_()
+    , last_(nullptr)
+    , end_x_()
+    , end_y_()
+{}
+
+/*************************************************************************************************/
+
+int OccupancyGrid::resolution() const
+{
+    return resolution_;
+}
+
+/*************************************************************************************************/
+
+void OccupancyGrid::integrate(const neato_laser_data_t& laser, int max_range)
+{
+    // Beams are traced up to the range, scans supplied by users may have much longer readings.
+    int distance[NEATO_NUM_LASER_READINGS];
+    for (int i = 0; i < NEATO_NUM_LASER_READINGS; i++) {
+        distance[i] = std::min(laser.distance[i], max_range);
+    }
+
+    // Endpoints are computed for all beams at once, only valid ones are kept in the same order.
+    polar_to_cartesian(distance, laser.pose_taken, end_x_, end_y_);
+
+    const int x0 = cell_at(laser.pose_taken.x, resolution_);
+    const int y0 = cell_at(laser.pose_taken.y, resolution_);
+
+    std::size_t point = 0;
+    for (int i = 0; i < NEATO_NUM_LASER_READINGS; i++) {
+        if (laser.distance[i] <= 0) {
+            continue;
+        }
+        const int x1 = cell_at(end_x_[point], resolution_);
+        const int y1 = cell_at(end_y_[point], resolution_);
+        trace(x0, y0, x1, y1, laser.distance[i] < max_range);
+        point++;
+    }
+}
+
+/*************************************************************************************************/
+
+void OccupancyGrid::take_changed(std::vector<neato_map_tile_t>* tiles)
+{
+    if (tiles) {
+        const OccupancyTable& table = occupancy();
+        tiles->resize(changed_.size());
+        for (std::size_t i = 0; i < changed_.size(); i++) {
+            const Tile& source = *changed_[i];
+            neato_map_tile_t& target = (*tiles)[i];
+            target.x = source.x * NEATO_MAP_TILE_SIZE;
+            target.y = source.y * NEATO_MAP_TILE_SIZE;
+            for (int j = 0; j < NEATO_MAP_TILE_SIZE * NEATO_MAP_TILE_SIZE; j++) {
+                target.cells[j] = table(source.log_odds[j]);
+            }
+        }
+    }
+
+    for (Tile* tile : changed_) {
+        tile->changed = false;
+    }
+    changed_.clear();
+}
+
+/*************************************************************************************************/
+
+void OccupancyGrid::read(const neato_map_region_t& region, std::uint8_t* cells) const
+{
+    const OccupancyTable& table = occupancy();
+    for (int y = region.y; y < region.y + region.height; y++) {
+        std::uint8_t* output = cells + static_cast<std::size_t>(y - region.y) * region.width;
+
+        // Copy the part of the row inside each tile at once.
+        int x = region.x;
+        while (x < region.x + region.width) {
+            const int end = std::min(((x >> kTileShift) + 1) * NEATO_MAP_TILE_SIZE, region.x + region.width);
+            const Tile* tile = find(x >> kTileShift, y >> kTileShift);
+            if (tile) {
+                const std::int16_t* log_odds = tile->log_odds + (y & kTileMask) * NEATO_MAP_TILE_SIZE;
+                for (; x < end; x++) {
+                    *output++ = table(log_odds[x & kTileMask]);
+                }
+            } else {
+                std::memset(output, NEATO_MAP_UNKNOWN, end - x);
+                output += end - x;
+                x = end;
+            }
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+OccupancyGrid::Tile& OccupancyGrid::tile(int x, int y)
+{
+    std::unique_ptr<Tile>& tile = tiles_[tile_key(x, y)];
+    if (!tile) {
+        tile.reset(new Tile);
+        tile->x = x;
+        tile->y = y;
+        tile->changed = false;
+        std::fill(std::begin(tile->log_odds), std::end(tile->log_odds), kUnknown);
+    }
+    return *tile;
+}
+
+/*************************************************************************************************/
+
+const OccupancyGrid::Tile* OccupancyGrid::find(int x, int y) const
+{
+    auto it = tiles_.find(tile_key(x, y));
+    return it != tiles_.end() ? it->second.get() : nullptr;
+}
+
+/*************************************************************************************************/
+
+void OccupancyGrid::update(int x, int y, int delta)
+{
+    // Arithmetic shift rounds negative cells down, to the tile containing them.
+    const int tile_x = x >> kTileShift;
+    const int tile_y = y >> kTileShift;
+    if (!last_ || last_->x != tile_x || last_->y != tile_y) {
+        last_ = &tile(tile_x, tile_y);
+    }
+
+    std::int16_t& cell = last_->log_odds[(y & kTileMask) * NEATO_MAP_TILE_SIZE + (x & kTileMask)];
+    const int value = (cell == kUnknown ? 0 : cell) + delta;
+    cell = static_cast<std::int16_t>(std::min(std::max(value, kMinLogOdds), kMaxLogOdds));
+
+    if (!last_->changed) {
+        last_->changed = true;
+        changed_.push_back(last_);
+    }
+}
+
+/*************************************************************************************************/
+
+void OccupancyGrid::trace(int x0, int y0, int x1, int y1, bool hit)
+{
+    const int dx = std::abs(x1 - x0);
+    const int dy = -std::abs(y1 - y0);
+    const int step_x = x0 < x1 ? 1 : -1;
+    const int step_y = y0 < y1 ? 1 : -1;
+
+    int error = dx + dy;
+    while (x0 != x1 || y0 != y1) {
+        update(x0, y0, kMiss);
+        const int error2 = 2 * error;
+        if (error2 >= dy) {
+            error += dy;
+            x0 += step_x;
+        }
+        if (error2 <= dx) {
+            error += dx;
+            y0 += step_y;
+        }
+    }
+    update(x1, y1, hit ? kHit : kMiss);
+}
+
+/*************************************************************************************************/
+
+}
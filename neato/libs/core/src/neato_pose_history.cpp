@@ -0,0 +1,123 @@
+#include "neato_pose_history.hpp"
+
+#include <algorithm>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+PoseHistory::PoseHistory()
+    : samples_()
+    , count_(0)
+    , version_(0)
+{}
+
+/*************************************************************************************************/
+
+void PoseHistory::record(uint64_t timestamp, const neato_pose_t& pose)
+{
+    const uint64_t version = version_.load(std::memory_order_relaxed);
+    const uint64_t count = count_.load(std::memory_order_relaxed);
+
+    version_.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Sample& sample = samples_[count % kNumSamples];
+    sample.timestamp.store(timestamp, std::memory_order_relaxed);
+    sample.x.store(pose.x, std::memory_order_relaxed);
+    sample.y.store(pose.y, std::memory_order_relaxed);
+    sample.theta.store(pose.theta, std::memory_order_relaxed);
+    count_.store(count + 1, std::memory_order_relaxed);
+
+    version_.store(version + 2, std::memory_order_release);
+}
+
+/*************************************************************************************************/
+
+template<class Function>
+void PoseHistory::read(Function function) const
+{
+    while (true) {
+        const uint64_t version = version_.load(std::memory_order_acquire);
+        if (version & 1) {
+            continue;
+        }
+        function(count_.load(std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version_.load(std::memory_order_relaxed) == version) {
+            return;
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+neato_pose_t PoseHistory::latest() const
+{
+    neato_pose_t pose = {};
+    read([this, &pose](uint64_t count) {
+        if (count) {
+            const Sample& sample = samples_[(count - 1) % kNumSamples];
+            pose.x = sample.x.load(std::memory_order_relaxed);
+            pose.y = sample.y.load(std::memory_order_relaxed);
+            pose.theta = sample.theta.load(std::memory_order_relaxed);
+        }
+    });
+    return pose;
+}
+
+/*************************************************************************************************/
+
+bool PoseHistory::at(uint64_t timestamp, neato_pose_t* pose) const
+{
+    bool found = false;
+    read([this, timestamp, pose, &found](uint64_t count) {
+        found = false;
+        if (!count) {
+            return;
+        }
+        auto time_of = [this](uint64_t index) {
+            return samples_[index % kNumSamples].timestamp.load(std::memory_order_relaxed);
+        };
+
+        // Find first sample not older than timestamp, samples are sorted by time.
+        const uint64_t oldest = (count > kNumSamples) ? count - kNumSamples : 0;
+        if (timestamp < time_of(oldest)) {
+            return;
+        }
+        uint64_t first = oldest;
+        uint64_t last = count;
+        while (first < last) {
+            const uint64_t middle = first + (last - first) / 2;
+            if (time_of(middle) < timestamp) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+
+        // Timestamps newer than all samples give weight above one, clamped to the newest pose.
+        const uint64_t index = std::min(first, count - 1);
+        const Sample& after = samples_[index % kNumSamples];
+        const Sample& before = samples_[(index == oldest ? index : index - 1) % kNumSamples];
+        const uint64_t start = before.timestamp.load(std::memory_order_relaxed);
+        const uint64_t end = after.timestamp.load(std::memory_order_relaxed);
+        const double weight = (end > start && timestamp < end) ?
+            static_cast<double>(timestamp - start) / static_cast<double>(end - start) : 1.0;
+
+        // Theta is not wrapped by odometry, so it can be interpolated directly.
+        auto mix = [weight](const std::atomic<double>& a, const std::atomic<double>& b) {
+            const double start = a.load(std::memory_order_relaxed);
+            return start + (b.load(std::memory_order_relaxed) - start) * weight;
+        };
+        pose->x = mix(before.x, after.x);
+        pose->y = mix(before.y, after.y);
+        pose->theta = mix(before.theta, after.theta);
+        found = true;
+    });
+    return found;
+}
+
+/*************************************************************************************************/
+
+}
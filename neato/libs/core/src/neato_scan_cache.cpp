@@ -0,0 +1,131 @@
+#include "neato_scan_cache.hpp"
+
+#include <cstring>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+ScanCache::ScanCache()
+    : slots_()
+    , sequence_(0)
+    , requested_(0)
+    , closed_(false)
+    , mutex_()
+    , published_()
+    , request_changed_()
+{}
+
+/*************************************************************************************************/
+
+void ScanCache::publish(const neato_laser_scan_ex_t& scan)
+{
+    const uint64_t sequence = sequence_.load(std::memory_order_relaxed) + 1;
+    Slot& slot = slots_[sequence % kNumSlots];
+
+    neato_laser_scan_ex_t numbered = scan;
+    numbered.sequence = sequence;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&numbered);
+
+    // Readers seeing the odd version, or a different one after copying, know the copy is invalid.
+    slot.version.store(2 * sequence - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < kNumWords; ++i) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+        slot.words[i].store(word, std::memory_order_relaxed);
+    }
+    slot.version.store(2 * sequence, std::memory_order_release);
+
+    {
+        // Update sequence under the lock, so waiting readers can't miss it.
+        std::lock_guard<std::mutex> lock(mutex_);
+        sequence_.store(sequence, std::memory_order_release);
+    }
+    published_.notify_all();
+}
+
+/*************************************************************************************************/
+
+uint64_t ScanCache::sequence() const
+{
+    return sequence_.load(std::memory_order_acquire);
+}
+
+/*************************************************************************************************/
+
+bool ScanCache::read_newer(uint64_t sequence, neato_laser_scan_ex_t* scan)
+{
+    while (true) {
+        const uint64_t newest = sequence_.load(std::memory_order_acquire);
+        if (newest <= sequence) {
+            return false;
+        }
+
+        // Slot is only rewritten after two more scans, so retrying is very unlikely.
+        const Slot& slot = slots_[newest % kNumSlots];
+        const uint64_t version = slot.version.load(std::memory_order_acquire);
+        if (version != 2 * newest) {
+            continue;
+        }
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(scan);
+        for (std::size_t i = 0; i < kNumWords; ++i) {
+            const uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+            std::memcpy(bytes + i * sizeof(word), &word, sizeof(word));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) == version) {
+            return true;
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+bool ScanCache::wait_newer(uint64_t sequence, std::chrono::milliseconds timeout, neato_laser_scan_ex_t* scan)
+{
+    if (read_newer(sequence, scan)) {
+        return true;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (requested_ <= sequence) {
+            requested_ = sequence + 1;
+            request_changed_.notify_all();
+        }
+        published_.wait_for(lock, timeout, [this, sequence]() {
+            return closed_ || sequence_.load(std::memory_order_relaxed) > sequence;
+        });
+        if (closed_) {
+            return false;
+        }
+    }
+    return read_newer(sequence, scan);
+}
+
+/*************************************************************************************************/
+
+bool ScanCache::wait_requested(std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto requested = [this]() { return requested_ > sequence_.load(std::memory_order_relaxed); };
+    request_changed_.wait_until(lock, deadline, [this, &requested]() { return closed_ || requested(); });
+    return !closed_ && requested();
+}
+
+/*************************************************************************************************/
+
+void ScanCache::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    published_.notify_all();
+    request_changed_.notify_all();
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,222 @@
+#include "neato_scan_odometry.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <cmath>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Limits of the maximum distance between paired points, in millimeters.
+static const int kMinDistance = 10;
+static const int kMaxDistance = 1000;
+
+/*************************************************************************************************/
+
+namespace {
+
+// Pose b given in the frame of pose a.
+neato_pose_t compose(const neato_pose_t& a, const neato_pose_t& b)
+{
+    const double c = std::cos(a.theta);
+    const double s = std::sin(a.theta);
+    return { a.x + c * b.x - s * b.y, a.y + s * b.x + c * b.y, a.theta + b.theta };
+}
+
+// Pose that composed with a gives the origin.
+neato_pose_t inverse(const neato_pose_t& a)
+{
+    const double c = std::cos(a.theta);
+    const double s = std::sin(a.theta);
+    return { -c * a.x - s * a.y, s * a.x - c * a.y, -a.theta };
+}
+
+}
+
+/*************************************************************************************************/
+
+ScanOdometry::ScanOdometry()
+    : matcher_()
+    , reference_odometry_()
+    , reference_pose_()
+    , correction_()
+    , stats_()
+    , mutex_()
+    , config_mutex_()
+    , pending_()
+    , pending_odometry_()
+    , has_pending_(false)
+    , enabled_(false)
+    , stopping_(false)
+    , interval_(0)
+    , next_scan_()
+    , pending_mutex_()
+    , scan_ready_()
+    , thread_()
+{}
+
+/*************************************************************************************************/
+
+ScanOdometry::~ScanOdometry()
+{
+    stop_thread();
+}
+
+/*************************************************************************************************/
+
+void ScanOdometry::set_config(const neato_scan_match_config_t* config)
+{
+    // Pairing grid has cells of max distance over the whole laser range, so small distances would need huge grids.
+    const bool distance_valid = config && (config->max_distance_mm == 0 ||
+        (config->max_distance_mm >= kMinDistance && config->max_distance_mm <= kMaxDistance));
+    if (config && (config->scan_interval_ms < 0 || config->max_iterations < 0 || config->max_time_ms < 0 ||
+                   !distance_valid)) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid scan matching configuration");
+    }
+
+    // Matcher belongs to the thread, so it is only touched while stopped. Motion between the last
+    // scan and the next one is unknown, so matching restarts from the next scan.
+    std::lock_guard<std::mutex> config_lock(config_mutex_);
+    stop_thread();
+    matcher_.clear_reference();
+    if (!config) {
+        return;
+    }
+
+    matcher_.set_config(*config);
+    start_thread(std::chrono::milliseconds(config->scan_interval_ms));
+}
+
+/*************************************************************************************************/
+
+bool ScanOdometry::wants_scan()
+{
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    if (!enabled_) {
+        return false;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_scan_) {
+        return false;
+    }
+    next_scan_ = now + interval_;
+    return true;
+}
+
+/*************************************************************************************************/
+
+void ScanOdometry::submit(const neato_laser_data_t& laser, const neato_pose_t& odometry)
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_ = laser;
+        pending_odometry_ = odometry;
+        has_pending_ = true;
+    }
+    scan_ready_.notify_one();
+}
+
+/*************************************************************************************************/
+
+neato_pose_t ScanOdometry::correct(const neato_pose_t& odometry)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return compose(correction_, odometry);
+}
+
+/*************************************************************************************************/
+
+void ScanOdometry::get_stats(neato_scan_match_stats_t* stats)
+{
+    if (!stats) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid scan matching metrics");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    *stats = stats_;
+    stats->correction = correction_;
+    stats->correction.theta = correction_.theta * 180.0 / 3.14159265358979323846;
+}
+
+/*************************************************************************************************/
+
+void ScanOdometry::start_thread(std::chrono::milliseconds interval)
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        enabled_ = true;
+        stopping_ = false;
+        has_pending_ = false;
+        interval_ = interval;
+        next_scan_ = std::chrono::steady_clock::now();
+    }
+    thread_ = std::thread(&ScanOdometry::thread_loop, this);
+}
+
+/*************************************************************************************************/
+
+void ScanOdometry::stop_thread()
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        enabled_ = false;
+        stopping_ = true;
+    }
+    scan_ready_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/*************************************************************************************************/
+
+void ScanOdometry::thread_loop()
+{
+    neato_laser_data_t laser;
+    neato_pose_t odometry;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex_);
+            scan_ready_.wait(lock, [this]() { return stopping_ || has_pending_; });
+            if (stopping_) {
+                return;
+            }
+            laser = pending_;
+            odometry = pending_odometry_;
+            has_pending_ = false;
+        }
+        process(laser, odometry);
+    }
+}
+
+/*************************************************************************************************/
+
+void ScanOdometry::process(const neato_laser_data_t& laser, const neato_pose_t& odometry)
+{
+    if (matcher_.has_reference()) {
+        // Wheels give the initial guess, and the motion used when alignment fails.
+        const neato_pose_t guess = compose(inverse(reference_odometry_), odometry);
+        const ScanMatch match = matcher_.match(laser, guess);
+        const neato_pose_t pose = compose(reference_pose_, match.converged ? match.pose : guess);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        correction_ = compose(pose, inverse(odometry));
+        stats_.scans++;
+        stats_.converged += match.converged ? 1 : 0;
+        stats_.iterations = match.iterations;
+        stats_.correspondences = match.correspondences;
+        stats_.residual_mm = match.residual;
+        stats_.time_ms = match.time_ms;
+        reference_pose_ = pose;
+    } else {
+        reference_pose_ = correct(odometry);
+    }
+
+    matcher_.set_reference(laser);
+    reference_odometry_ = odometry;
+}
+
+/*************************************************************************************************/
+
+}
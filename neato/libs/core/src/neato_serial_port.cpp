@@ -3,6 +3,7 @@
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
+#include <limits>
 #include "jaw_exception.hpp"
 
 #define SIMULATED 1
@@ -51,6 +52,32 @@ public:
         return result;
     }
 
+    // Send command to serial and read result into buffer.
+    virtual std::size_t execute(const std::string& command, char* buffer, std::size_t size)
+    {
+        std::size_t length = 0;
+#if !SIMULATED
+        static char delimiter = char(26);
+        output_ << command << std::endl;
+        input_.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+        // Get stops before delimiter, failing if there was nothing to read.
+        input_.get(buffer, size, delimiter);
+        length = static_cast<std::size_t>(input_.gcount());
+        input_.clear();
+        if (input_.get() != delimiter) {
+            input_.ignore(std::numeric_limits<std::streamsize>::max(), delimiter);
+            throw Jaw::Exception(std::errc::message_size, "Serial result larger than buffer");
+        }
+#else
+        (void)command;
+#endif
+        if (size) {
+            buffer[length] = '\0';
+        }
+        return length;
+    }
+
 private:
 
     // File streams used in serial connection.
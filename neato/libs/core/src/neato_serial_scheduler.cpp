@@ -0,0 +1,109 @@
+#include "neato_serial_scheduler.hpp"
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+class SerialScheduler::Turn
+{
+public:
+    Turn(SerialScheduler& scheduler, Priority priority)
+        : scheduler_(scheduler)
+        , priority_(priority)
+        , start_()
+    {
+        scheduler_.acquire(priority_);
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    ~Turn()
+    {
+        scheduler_.release(priority_, start_);
+    }
+
+private:
+    SerialScheduler& scheduler_;
+    Priority priority_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/*************************************************************************************************/
+
+SerialScheduler::SerialScheduler(std::shared_ptr<SerialPort> serial)
+    : serial_(std::move(serial))
+    , busy_(false)
+    , waiting_control_(0)
+    , next_control_(std::chrono::steady_clock::time_point::max())
+    , gap_open_(true)
+    , background_duration_(0)
+    , mutex_()
+    , released_()
+{}
+
+/*************************************************************************************************/
+
+void SerialScheduler::set_next_control(std::chrono::steady_clock::time_point when)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        next_control_ = when;
+        gap_open_ = true;
+    }
+    released_.notify_all();
+}
+
+/*************************************************************************************************/
+
+std::string SerialScheduler::execute(Priority priority, const std::string& command)
+{
+    Turn turn(*this, priority);
+    return serial_->execute(command);
+}
+
+/*************************************************************************************************/
+
+std::size_t SerialScheduler::execute(Priority priority, const std::string& command, char* buffer, std::size_t size)
+{
+    Turn turn(*this, priority);
+    return serial_->execute(command, buffer, size);
+}
+
+/*************************************************************************************************/
+
+void SerialScheduler::acquire(Priority priority)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (priority == Priority::CONTROL) {
+        waiting_control_++;
+        released_.wait(lock, [this]() { return !busy_; });
+        waiting_control_--;
+    } else {
+        // Subtract from next control, adding to now could overflow when there is none.
+        released_.wait(lock, [this]() {
+            const bool fits = next_control_ - std::chrono::steady_clock::now() >= background_duration_;
+            return !busy_ && waiting_control_ == 0 && (fits || gap_open_);
+        });
+        gap_open_ = false;
+    }
+    busy_ = true;
+}
+
+/*************************************************************************************************/
+
+void SerialScheduler::release(Priority priority, std::chrono::steady_clock::time_point start)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        busy_ = false;
+        if (priority == Priority::BACKGROUND) {
+            const auto duration = std::chrono::steady_clock::now() - start;
+            background_duration_ = (3 * background_duration_ + duration) / 4;
+        }
+    }
+    released_.notify_all();
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,48 @@
+#ifndef NEATO_LASER_H
+#define NEATO_LASER_H
+
+#include "neato_defines.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Readings of a complete turn of the laser distance sensor, one for each degree.
+struct LaserScan
+{
+    std::uint16_t distance[NEATO_NUM_LASER_READINGS];   // Distance in millimeters.
+    std::uint16_t intensity[NEATO_NUM_LASER_READINGS];  // Strength of the reflection.
+    std::uint16_t error[NEATO_NUM_LASER_READINGS];      // Error code of the sensor, zero if reading is valid.
+    double rotation_speed;                              // Turns per second.
+};
+
+// Parse result of GetLDSScan stored in data (not null terminated) in a single pass, without allocations.
+// Expects the header line, one line "angle, distance, intensity, error" for each degree (error in
+// hexadecimal) and the line with ROTATION_SPEED. Throws Jaw::Exception if format is invalid.
+void parse_laser_scan(const char* data, std::size_t size, LaserScan& scan);
+
+// Convert valid readings (distance greater than zero) to points using precomputed directions and
+// vector instructions, returning how many were written at the start of x and y. Points are in the
+// frame of the robot when origin is zero, otherwise origin is the robot pose (theta in degrees, as
+// returned by Robot::get_pose). Both x and y must have room for NEATO_NUM_LASER_READINGS points.
+std::size_t polar_to_cartesian(const int* distance, const neato_pose_t& origin, float* x, float* y);
+
+// Rotate by angle (radians) and translate count points to the output arrays, which may be x and y.
+void transform_points(const float* x, const float* y, std::size_t count, double angle, double dx, double dy,
+                      float* out_x, float* out_y);
+
+// Convert laser scan to points in supplied frame. Throws Jaw::Exception if frame is invalid.
+void laser_points(const neato_laser_data_t& laser, neato_frame_t frame, neato_laser_points_t& points);
+
+// Result of GetLDSScan returned while simulating the robot.
+extern const char dummy_laser[];
+extern const std::size_t dummy_laser_size;
+
+/*************************************************************************************************/
+
+}
+
+#endif // NEATO_LASER_H
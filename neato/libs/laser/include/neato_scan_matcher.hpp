@@ -0,0 +1,93 @@
+#ifndef NEATO_SCAN_MATCHER_H
+#define NEATO_SCAN_MATCHER_H
+
+#include "neato_defines.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Result of aligning a scan with the reference one.
+struct ScanMatch
+{
+    neato_pose_t pose;      // Pose of the scan in the frame of the reference, theta in radians.
+    bool converged;         // True if alignment converged with enough correspondences.
+    int iterations;         // Iterations executed.
+    int correspondences;    // Points paired with the reference on last iteration.
+    double residual;        // RMS distance of paired points to the reference lines, in millimeters.
+    double time_ms;         // Time spent aligning the scan.
+};
+
+// Align laser scans using point-to-line ICP (iterative closest point). Points of the reference are
+// indexed in a uniform grid with cells as large as the maximum pairing distance, so each point of
+// the aligned scan only looks at the 3x3 cells around it.
+class ScanMatcher
+{
+public:
+    // Construct matcher without reference, using default configuration.
+    ScanMatcher();
+
+    // Set limits of the alignment, fields left at zero use defaults.
+    // Takes effect on the next reference.
+    void set_config(const neato_scan_match_config_t& config);
+
+    // Use scan as reference for the following alignments.
+    void set_reference(const neato_laser_data_t& laser);
+
+    // Forget reference.
+    void clear_reference();
+
+    // Return true once a reference was set.
+    bool has_reference() const;
+
+    // Align scan with reference starting from guess (theta in radians). Stops once converged or
+    // after the configured number of iterations or time.
+    ScanMatch match(const neato_laser_data_t& laser, const neato_pose_t& guess);
+
+private:
+    // Points of valid readings in the frame of the robot.
+    struct Points
+    {
+        float x[NEATO_NUM_LASER_READINGS];
+        float y[NEATO_NUM_LASER_READINGS];
+        std::size_t count;
+    };
+
+    // Load points of readings that hit something.
+    static void load(const neato_laser_data_t& laser, Points& points);
+
+    // Index in grid of cell containing point, negative if outside.
+    int cell_of(float x, float y) const;
+
+    // Limits of the alignment.
+    int max_iterations_;
+    int max_time_ms_;
+    float max_distance_;
+
+    // Reference points and the normal of the line through each one (zero if unknown).
+    Points reference_;
+    float normal_x_[NEATO_NUM_LASER_READINGS];
+    float normal_y_[NEATO_NUM_LASER_READINGS];
+    bool has_reference_;
+
+    // Grid over reference points: points of cell i are order_[cell_start_[i]] until cell_start_[i + 1].
+    int grid_size_;
+    float cell_size_;
+    std::vector<std::uint16_t> cell_start_;
+    std::vector<std::uint16_t> order_;
+
+    // Scan being aligned and its points moved by the current estimate.
+    Points current_;
+    float moved_x_[NEATO_NUM_LASER_READINGS];
+    float moved_y_[NEATO_NUM_LASER_READINGS];
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // NEATO_SCAN_MATCHER_H
@@ -0,0 +1,164 @@
+#include "neato_laser.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <cstring>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+namespace {
+
+// Cursor over the text being parsed, methods throw if the text doesn't match.
+class Cursor
+{
+public:
+    Cursor(const char* data, std::size_t size)
+        : current_(data)
+        , end_(data + size)
+    {}
+
+    // Skip spaces (and carriage returns) inside a line.
+    void skip_spaces()
+    {
+        while (current_ != end_ && (*current_ == ' ' || *current_ == '\t' || *current_ == '\r')) {
+            current_++;
+        }
+    }
+
+    // Skip everything up to the start of the next line.
+    void skip_line()
+    {
+        const void* newline = std::memchr(current_, '\n', end_ - current_);
+        current_ = newline ? static_cast<const char*>(newline) + 1 : end_;
+    }
+
+    // Consume end of line (or of text) after optional spaces.
+    void end_line()
+    {
+        skip_spaces();
+        if (current_ != end_) {
+            expect('\n');
+        }
+    }
+
+    // Consume text starting at current position.
+    void expect(const char* text)
+    {
+        const std::size_t length = std::strlen(text);
+        if (static_cast<std::size_t>(end_ - current_) < length || std::memcmp(current_, text, length) != 0) {
+            fail();
+        }
+        current_ += length;
+    }
+
+    // Consume a single character after optional spaces.
+    void expect(char c)
+    {
+        skip_spaces();
+        if (current_ == end_ || *current_ != c) {
+            fail();
+        }
+        current_++;
+    }
+
+    // Consume a number with up to 16 bits after optional spaces, written in supplied base.
+    template<unsigned int Base = 10>
+    std::uint16_t number()
+    {
+        skip_spaces();
+        unsigned int value = 0;
+        const char* start = current_;
+        for (; current_ != end_; current_++) {
+            unsigned int digit = digit_value<Base>(*current_);
+            if (digit >= Base) {
+                break;
+            }
+            value = value * Base + digit;
+            if (value > 0xFFFF) {
+                fail();
+            }
+        }
+        if (current_ == start) {
+            fail();
+        }
+        return static_cast<std::uint16_t>(value);
+    }
+
+    // Consume a decimal number with optional fraction after optional spaces.
+    double decimal()
+    {
+        double value = number();
+        if (current_ != end_ && *current_ == '.') {
+            current_++;
+            for (double scale = 0.1; current_ != end_ && digit_value(*current_) < 10; current_++, scale /= 10.0) {
+                value += digit_value(*current_) * scale;
+            }
+        }
+        return value;
+    }
+
+    // Report text doesn't match the format.
+    [[noreturn]] static void fail()
+    {
+        throw Jaw::Exception(std::errc::io_error, "Error reading laser information");
+    }
+
+private:
+    // Value of digit in supplied base, Base or more if c is not a digit.
+    // Decimal digits need a single comparison, as they are most of the scan.
+    template<unsigned int Base = 10>
+    static unsigned int digit_value(char c)
+    {
+        const unsigned int decimal = static_cast<unsigned char>(c - '0');
+        if (decimal < 10 || Base <= 10) {
+            return decimal;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return static_cast<unsigned int>(c - 'A' + 10);
+        }
+        if (c >= 'a' && c <= 'f') {
+            return static_cast<unsigned int>(c - 'a' + 10);
+        }
+        return 16;
+    }
+
+    const char* current_;
+    const char* end_;
+};
+
+}
+
+/*************************************************************************************************/
+
+void parse_laser_scan(const char* data, std::size_t size, LaserScan& scan)
+{
+    Cursor cursor(data, size);
+
+    cursor.expect("AngleInDegrees");
+    cursor.skip_line();
+
+    for (unsigned int angle = 0; angle < NEATO_NUM_LASER_READINGS; angle++) {
+        if (cursor.number() != angle) {
+            Cursor::fail();
+        }
+        cursor.expect(',');
+        scan.distance[angle] = cursor.number();
+        cursor.expect(',');
+        scan.intensity[angle] = cursor.number();
+        cursor.expect(',');
+        scan.error[angle] = cursor.number<16>();
+        cursor.end_line();
+    }
+
+    cursor.skip_spaces();
+    cursor.expect("ROTATION_SPEED");
+    cursor.expect(',');
+    scan.rotation_speed = cursor.decimal();
+    cursor.end_line();
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,165 @@
+#include "neato_laser.hpp"
+#include "neato_simd.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <cmath>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// Direction of each reading, reading i is taken i degrees counterclockwise from the x axis.
+struct BeamTable
+{
+    BeamTable()
+    {
+        for (int i = 0; i < NEATO_NUM_LASER_READINGS; i++) {
+            cos[i] = static_cast<float>(std::cos(i * kPi / 180.0));
+            sin[i] = static_cast<float>(std::sin(i * kPi / 180.0));
+        }
+    }
+
+    alignas(16) float cos[NEATO_NUM_LASER_READINGS];
+    alignas(16) float sin[NEATO_NUM_LASER_READINGS];
+};
+
+// Table is filled on first use, initialization of local statics is thread safe.
+const BeamTable& beam_table()
+{
+    static const BeamTable table;
+    return table;
+}
+
+}
+
+/*************************************************************************************************/
+
+std::size_t polar_to_cartesian(const int* distance, const neato_pose_t& origin, float* x, float* y)
+{
+    const BeamTable& table = beam_table();
+
+    // Rotating every direction by the heading gives the same cost as the robot frame.
+    const double theta = origin.theta * kPi / 180.0;
+    const float cos_theta = static_cast<float>(std::cos(theta));
+    const float sin_theta = static_cast<float>(std::sin(theta));
+    const float origin_x = static_cast<float>(origin.x);
+    const float origin_y = static_cast<float>(origin.y);
+
+    int i = 0;
+#if defined(NEATO_SSE2)
+    const __m128 vcos = _mm_set1_ps(cos_theta);
+    const __m128 vsin = _mm_set1_ps(sin_theta);
+    const __m128 vx = _mm_set1_ps(origin_x);
+    const __m128 vy = _mm_set1_ps(origin_y);
+    for (; i + 4 <= NEATO_NUM_LASER_READINGS; i += 4) {
+        const __m128 d = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(distance + i)));
+        const __m128 c = _mm_load_ps(table.cos + i);
+        const __m128 s = _mm_load_ps(table.sin + i);
+        const __m128 ux = _mm_sub_ps(_mm_mul_ps(c, vcos), _mm_mul_ps(s, vsin));
+        const __m128 uy = _mm_add_ps(_mm_mul_ps(s, vcos), _mm_mul_ps(c, vsin));
+        _mm_storeu_ps(x + i, _mm_add_ps(vx, _mm_mul_ps(d, ux)));
+        _mm_storeu_ps(y + i, _mm_add_ps(vy, _mm_mul_ps(d, uy)));
+    }
+#elif defined(NEATO_NEON)
+    const float32x4_t vcos = vdupq_n_f32(cos_theta);
+    const float32x4_t vsin = vdupq_n_f32(sin_theta);
+    const float32x4_t vx = vdupq_n_f32(origin_x);
+    const float32x4_t vy = vdupq_n_f32(origin_y);
+    for (; i + 4 <= NEATO_NUM_LASER_READINGS; i += 4) {
+        const float32x4_t d = vcvtq_f32_s32(vld1q_s32(distance + i));
+        const float32x4_t c = vld1q_f32(table.cos + i);
+        const float32x4_t s = vld1q_f32(table.sin + i);
+        const float32x4_t ux = vmlsq_f32(vmulq_f32(c, vcos), s, vsin);
+        const float32x4_t uy = vmlaq_f32(vmulq_f32(s, vcos), c, vsin);
+        vst1q_f32(x + i, vmlaq_f32(vx, d, ux));
+        vst1q_f32(y + i, vmlaq_f32(vy, d, uy));
+    }
+#endif
+    for (; i < NEATO_NUM_LASER_READINGS; i++) {
+        const float d = static_cast<float>(distance[i]);
+        const float ux = table.cos[i] * cos_theta - table.sin[i] * sin_theta;
+        const float uy = table.sin[i] * cos_theta + table.cos[i] * sin_theta;
+        x[i] = origin_x + d * ux;
+        y[i] = origin_y + d * uy;
+    }
+
+    // Drop invalid readings keeping the order, always copying so there are no branches.
+    std::size_t count = 0;
+    for (i = 0; i < NEATO_NUM_LASER_READINGS; i++) {
+        x[count] = x[i];
+        y[count] = y[i];
+        count += (distance[i] > 0);
+    }
+    return count;
+}
+
+/*************************************************************************************************/
+
+void transform_points(const float* x, const float* y, std::size_t count, double angle, double dx, double dy,
+                      float* out_x, float* out_y)
+{
+    const float cos_angle = static_cast<float>(std::cos(angle));
+    const float sin_angle = static_cast<float>(std::sin(angle));
+    const float offset_x = static_cast<float>(dx);
+    const float offset_y = static_cast<float>(dy);
+
+    std::size_t i = 0;
+#if defined(NEATO_SSE2)
+    const __m128 vcos = _mm_set1_ps(cos_angle);
+    const __m128 vsin = _mm_set1_ps(sin_angle);
+    const __m128 vx = _mm_set1_ps(offset_x);
+    const __m128 vy = _mm_set1_ps(offset_y);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 px = _mm_loadu_ps(x + i);
+        const __m128 py = _mm_loadu_ps(y + i);
+        const __m128 rx = _mm_sub_ps(_mm_mul_ps(px, vcos), _mm_mul_ps(py, vsin));
+        const __m128 ry = _mm_add_ps(_mm_mul_ps(px, vsin), _mm_mul_ps(py, vcos));
+        _mm_storeu_ps(out_x + i, _mm_add_ps(rx, vx));
+        _mm_storeu_ps(out_y + i, _mm_add_ps(ry, vy));
+    }
+#elif defined(NEATO_NEON)
+    const float32x4_t vcos = vdupq_n_f32(cos_angle);
+    const float32x4_t vsin = vdupq_n_f32(sin_angle);
+    const float32x4_t vx = vdupq_n_f32(offset_x);
+    const float32x4_t vy = vdupq_n_f32(offset_y);
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t px = vld1q_f32(x + i);
+        const float32x4_t py = vld1q_f32(y + i);
+        const float32x4_t rx = vmlsq_f32(vmulq_f32(px, vcos), py, vsin);
+        const float32x4_t ry = vmlaq_f32(vmulq_f32(px, vsin), py, vcos);
+        vst1q_f32(out_x + i, vaddq_f32(rx, vx));
+        vst1q_f32(out_y + i, vaddq_f32(ry, vy));
+    }
+#endif
+    for (; i < count; i++) {
+        const float px = x[i];
+        const float py = y[i];
+        out_x[i] = px * cos_angle - py * sin_angle + offset_x;
+        out_y[i] = px * sin_angle + py * cos_angle + offset_y;
+    }
+}
+
+/*************************************************************************************************/
+
+void laser_points(const neato_laser_data_t& laser, neato_frame_t frame, neato_laser_points_t& points)
+{
+    neato_pose_t origin = {};
+    if (frame == NEATO_FRAME_WORLD) {
+        origin = laser.pose_taken;
+    } else if (frame != NEATO_FRAME_ROBOT) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid reference frame");
+    }
+
+    points.num_points = static_cast<int>(polar_to_cartesian(laser.distance, origin, points.x, points.y));
+    points.frame = frame;
+    points.pose_taken = laser.pose_taken;
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,260 @@
+#include "neato_scan_matcher.hpp"
+
+#include "neato_laser.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace Neato {
+
+/*************************************************************************************************/
+
+// Defaults used when configuration leaves fields at zero.
+static const int kDefaultIterations = 20;
+static const int kDefaultTime = 20;
+static const int kDefaultDistance = 300;
+
+// Alignment converged once updates are smaller than these (millimeters and radians).
+static const double kMinStep = 0.1;
+static const double kMinTurn = 1e-4;
+
+// Minimum points paired, also relative to the points of the scan, to trust the alignment.
+static const std::size_t kMinCorrespondences = 20;
+
+/*************************************************************************************************/
+
+ScanMatcher::ScanMatcher()
+    : max_iterations_(kDefaultIterations)
+    , max_time_ms_(kDefaultTime)
+    , max_distance_(static_cast<float>(kDefaultDistance))
+    , reference_()
+    , normal_x_()
+    , normal_y_()
+    , has_reference_(false)
+    , grid_size_(0)
+    , cell_size_(0.0f)
+    , cell_start_()
+    , order_()
+    , current_()
+    , moved_x_()
+    , moved_y_()
+{}
+
+/*************************************************************************************************/
+
+void ScanMatcher::set_config(const neato_scan_match_config_t& config)
+{
+    max_iterations_ = config.max_iterations ? config.max_iterations : kDefaultIterations;
+    max_time_ms_ = config.max_time_ms ? config.max_time_ms : kDefaultTime;
+    max_distance_ = static_cast<float>(config.max_distance_mm ? config.max_distance_mm : kDefaultDistance);
+}
+
+/*************************************************************************************************/
+
+void ScanMatcher::set_reference(const neato_laser_data_t& laser)
+{
+    load(laser, reference_);
+    const std::size_t count = reference_.count;
+    const float max_distance2 = max_distance_ * max_distance_;
+
+    // Line through each point goes to its neighbors in the scan, when they are close enough.
+    for (std::size_t i = 0; i < count; i++) {
+        const std::size_t previous = (i + count - 1) % count;
+        const std::size_t next = (i + 1) % count;
+        auto close = [&](std::size_t j) {
+            const float dx = reference_.x[j] - reference_.x[i];
+            const float dy = reference_.y[j] - reference_.y[i];
+            return j != i && dx * dx + dy * dy < max_distance2;
+        };
+        const std::size_t first = close(previous) ? previous : i;
+        const std::size_t last = close(next) ? next : i;
+        const float tangent_x = reference_.x[last] - reference_.x[first];
+        const float tangent_y = reference_.y[last] - reference_.y[first];
+        const float length = std::sqrt(tangent_x * tangent_x + tangent_y * tangent_y);
+        normal_x_[i] = length > 0.0f ? -tangent_y / length : 0.0f;
+        normal_y_[i] = length > 0.0f ? tangent_x / length : 0.0f;
+    }
+
+    // Sort points by cell (counting sort), covering the whole range of the sensor.
+    cell_size_ = max_distance_;
+    grid_size_ = 2 * static_cast<int>(std::ceil(NEATO_LASER_MAX_RANGE / cell_size_)) + 2;
+    cell_start_.assign(static_cast<std::size_t>(grid_size_) * grid_size_ + 1, 0);
+    for (std::size_t i = 0; i < count; i++) {
+        const int cell = cell_of(reference_.x[i], reference_.y[i]);
+        if (cell >= 0) {
+            cell_start_[cell + 1]++;
+        }
+    }
+    for (std::size_t i = 1; i < cell_start_.size(); i++) {
+        cell_start_[i] += cell_start_[i - 1];
+    }
+    order_.resize(count);
+    std::vector<std::uint16_t> next(cell_start_.begin(), cell_start_.end() - 1);
+    for (std::size_t i = 0; i < count; i++) {
+        const int cell = cell_of(reference_.x[i], reference_.y[i]);
+        if (cell >= 0) {
+            order_[next[cell]++] = static_cast<std::uint16_t>(i);
+        }
+    }
+
+    has_reference_ = true;
+}
+
+/*************************************************************************************************/
+
+void ScanMatcher::clear_reference()
+{
+    has_reference_ = false;
+}
+
+/*************************************************************************************************/
+
+bool ScanMatcher::has_reference() const
+{
+    return has_reference_;
+}
+
+/*************************************************************************************************/
+
+ScanMatch ScanMatcher::match(const neato_laser_data_t& laser, const neato_pose_t& guess)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::milliseconds(max_time_ms_);
+
+    load(laser, current_);
+    const std::size_t min_correspondences = std::max(kMinCorrespondences, current_.count / 4);
+    const float max_distance2 = max_distance_ * max_distance_;
+
+    ScanMatch result = {};
+    result.pose = guess;
+    double x = guess.x;
+    double y = guess.y;
+    double theta = guess.theta;
+
+    while (has_reference_ && result.iterations < max_iterations_) {
+        result.iterations++;
+        transform_points(current_.x, current_.y, current_.count, theta, x, y, moved_x_, moved_y_);
+
+        // Normal equations of the linearized distances to the lines, h is symmetric.
+        double h00 = 0, h01 = 0, h02 = 0, h11 = 0, h12 = 0, h22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double squares = 0;
+        int pairs = 0;
+
+        for (std::size_t i = 0; i < current_.count; i++) {
+            const float px = moved_x_[i];
+            const float py = moved_y_[i];
+            const int cell = cell_of(px, py);
+            if (cell < 0) {
+                continue;
+            }
+
+            // Closest reference point in the 3x3 cells around point, only used if it has a line.
+            int closest = -1;
+            float closest_distance2 = max_distance2;
+            for (int row = -1; row <= 1; row++) {
+                const int first = cell + row * grid_size_ - 1;
+                for (int j = cell_start_[first]; j < cell_start_[first + 3]; j++) {
+                    const int k = order_[j];
+                    const float dx = px - reference_.x[k];
+                    const float dy = py - reference_.y[k];
+                    const float distance2 = dx * dx + dy * dy;
+                    if (distance2 < closest_distance2) {
+                        closest = k;
+                        closest_distance2 = distance2;
+                    }
+                }
+            }
+            if (closest < 0 || (normal_x_[closest] == 0.0f && normal_y_[closest] == 0.0f)) {
+                continue;
+            }
+
+            const double nx = normal_x_[closest];
+            const double ny = normal_y_[closest];
+            const double residual = nx * (px - reference_.x[closest]) + ny * (py - reference_.y[closest]);
+            const double turn = ny * (px - x) - nx * (py - y);
+
+            h00 += nx * nx;
+            h01 += nx * ny;
+            h02 += nx * turn;
+            h11 += ny * ny;
+            h12 += ny * turn;
+            h22 += turn * turn;
+            b0 += nx * residual;
+            b1 += ny * residual;
+            b2 += turn * residual;
+            squares += residual * residual;
+            pairs++;
+        }
+
+        result.correspondences = pairs;
+        result.residual = pairs ? std::sqrt(squares / pairs) : 0.0;
+        if (static_cast<std::size_t>(pairs) < min_correspondences) {
+            break;
+        }
+
+        // Solve h * step = -b with Cramer's rule, giving up if points don't constrain the pose.
+        const double c00 = h11 * h22 - h12 * h12;
+        const double c01 = h02 * h12 - h01 * h22;
+        const double c02 = h01 * h12 - h02 * h11;
+        const double determinant = h00 * c00 + h01 * c01 + h02 * c02;
+        if (std::abs(determinant) < 1e-9) {
+            break;
+        }
+        const double c11 = h00 * h22 - h02 * h02;
+        const double c12 = h01 * h02 - h00 * h12;
+        const double c22 = h00 * h11 - h01 * h01;
+        const double step_x = -(c00 * b0 + c01 * b1 + c02 * b2) / determinant;
+        const double step_y = -(c01 * b0 + c11 * b1 + c12 * b2) / determinant;
+        const double step_theta = -(c02 * b0 + c12 * b1 + c22 * b2) / determinant;
+
+        x += step_x;
+        y += step_y;
+        theta += step_theta;
+
+        if (std::abs(step_x) < kMinStep && std::abs(step_y) < kMinStep && std::abs(step_theta) < kMinTurn) {
+            result.converged = true;
+            break;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            break;
+        }
+    }
+
+    result.pose.x = x;
+    result.pose.y = y;
+    result.pose.theta = theta;
+    result.time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/*************************************************************************************************/
+
+void ScanMatcher::load(const neato_laser_data_t& laser, Points& points)
+{
+    int distance[NEATO_NUM_LASER_READINGS];
+    for (int i = 0; i < NEATO_NUM_LASER_READINGS; i++) {
+        distance[i] = laser.distance[i] < NEATO_LASER_MAX_RANGE ? laser.distance[i] : 0;
+    }
+    const neato_pose_t origin = {};
+    points.count = polar_to_cartesian(distance, origin, points.x, points.y);
+}
+
+/*************************************************************************************************/
+
+int ScanMatcher::cell_of(float x, float y) const
+{
+    // Border cells are left empty, so the 3x3 neighborhood of a valid cell is always inside.
+    const float half = 0.5f * grid_size_ * cell_size_;
+    const int column = static_cast<int>(std::floor((x + half) / cell_size_));
+    const int row = static_cast<int>(std::floor((y + half) / cell_size_));
+    if (column < 1 || row < 1 || column >= grid_size_ - 1 || row >= grid_size_ - 1) {
+        return -1;
+    }
+    return row * grid_size_ + column;
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,15 @@
+#ifndef NEATO_SIMD_H
+#define NEATO_SIMD_H
+
+// Select the vector instruction set available for the target.
+// Kernels must always provide a scalar version used when none is found.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NEATO_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define NEATO_NEON
+#endif
+
+#endif // NEATO_SIMD_H
@@ -20,6 +20,25 @@ enum class Command
     SPEED_SET,
     IS_HEADING_DONE,
     DELTA_HEADING_SET,
+    LASER_SCAN_EX_GET,
+    LASER_POINTS_GET,
+    MAP_SET,
+    MAP_CALLBACK_SET,
+    MAP_INTEGRATE,
+    MAP_GET,
+    SCAN_MATCH_SET,
+    SCAN_MATCH_STATS_GET,
+    LASER_SCAN_WAIT,
+    POSE_AT,
+};
+
+/*************************************************************************************************/
+
+// Cells of a map region, sent as a single block.
+struct MapCells
+{
+    uint8_t* data;
+    std::size_t size;
 };
 
 /*************************************************************************************************/
@@ -80,6 +99,156 @@ void read(InputBuffer& buffer, neato_laser_data_t& value, Args&... args)
     read(buffer, args...);
 }
 
+/*************************************************************************************************/
+
+// Each array is copied as a single block.
+template<class... Args>
+void write(OutputBuffer& buffer, const neato_laser_scan_ex_t& value, const Args&... args)
+{
+    write(buffer, value.pose_taken, value.timestamp, value.sequence, value.rotation_speed);
+    write(buffer, value.distance, value.intensity, value.error);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, neato_laser_scan_ex_t& value, Args&... args)
+{
+    read(buffer, value.pose_taken, value.timestamp, value.sequence, value.rotation_speed);
+    read(buffer, value.distance);
+    read(buffer, value.intensity);
+    read(buffer, value.error);
+    read(buffer, args...);
+}
+
+/*************************************************************************************************/
+
+// Only valid points are sent, each coordinate as a single block.
+template<class... Args>
+void write(OutputBuffer& buffer, const neato_laser_points_t& value, const Args&... args)
+{
+    write(buffer, value.pose_taken, value.frame, value.num_points);
+    buffer.write(reinterpret_cast<const uint8_t*>(value.x), sizeof(float) * value.num_points);
+    buffer.write(reinterpret_cast<const uint8_t*>(value.y), sizeof(float) * value.num_points);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, neato_laser_points_t& value, Args&... args)
+{
+    read(buffer, value.pose_taken, value.frame, value.num_points);
+    if (value.num_points < 0 || value.num_points > NEATO_NUM_LASER_READINGS) {
+        throw Exception(std::errc::bad_message, "Received too many laser points");
+    }
+    const std::size_t size = sizeof(float) * value.num_points;
+    std::memcpy(value.x, buffer.read(size), size);
+    std::memcpy(value.y, buffer.read(size), size);
+    read(buffer, args...);
+}
+
+/*************************************************************************************************/
+
+template<class... Args>
+void write(OutputBuffer& buffer, const neato_map_config_t& value, const Args&... args)
+{
+    write(buffer, value.resolution_mm, value.scan_interval_ms);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, neato_map_config_t& value, Args&... args)
+{
+    read(buffer, value.resolution_mm, value.scan_interval_ms);
+    read(buffer, args...);
+}
+
+/*************************************************************************************************/
+
+template<class... Args>
+void write(OutputBuffer& buffer, const neato_map_region_t& value, const Args&... args)
+{
+    write(buffer, value.x, value.y, value.width, value.height);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, neato_map_region_t& value, Args&... args)
+{
+    read(buffer, value.x, value.y, value.width, value.height);
+    read(buffer, args...);
+}
+
+/*************************************************************************************************/
+
+// Tiles are sent as a single block and read in place, pointing to the message.
+template<class... Args>
+void write(OutputBuffer& buffer, const neato_map_update_t& value, const Args&... args)
+{
+    write(buffer, value.sequence, value.resolution_mm, value.pose_taken, value.num_tiles);
+    buffer.write(reinterpret_cast<const uint8_t*>(value.tiles), value.num_tiles * sizeof(neato_map_tile_t));
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, neato_map_update_t& value, Args&... args)
+{
+    read(buffer, value.sequence, value.resolution_mm, value.pose_taken, value.num_tiles);
+    if (value.num_tiles < 0) {
+        throw Exception(std::errc::bad_message, "Received invalid number of tiles");
+    }
+    value.tiles = static_cast<const neato_map_tile_t*>(buffer.read(value.num_tiles * sizeof(neato_map_tile_t)));
+    read(buffer, args...);
+}
+
+/*************************************************************************************************/
+
+template<class... Args>
+void write(OutputBuffer& buffer, const neato_scan_match_config_t& value, const Args&... args)
+{
+    write(buffer, value.scan_interval_ms, value.max_iterations, value.max_time_ms, value.max_distance_mm);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, neato_scan_match_config_t& value, Args&... args)
+{
+    read(buffer, value.scan_interval_ms, value.max_iterations, value.max_time_ms, value.max_distance_mm);
+    read(buffer, args...);
+}
+
+/*************************************************************************************************/
+
+template<class... Args>
+void write(OutputBuffer& buffer, const neato_scan_match_stats_t& value, const Args&... args)
+{
+    write(buffer, value.scans, value.converged, value.iterations, value.correspondences);
+    write(buffer, value.residual_mm, value.time_ms, value.correction);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, neato_scan_match_stats_t& value, Args&... args)
+{
+    read(buffer, value.scans, value.converged, value.iterations, value.correspondences);
+    read(buffer, value.residual_mm, value.time_ms, value.correction);
+    read(buffer, args...);
+}
+
+/*************************************************************************************************/
+
+template<class... Args>
+void write(OutputBuffer& buffer, const Neato::MapCells& value, const Args&... args)
+{
+    buffer.write(value.data, value.size);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, Neato::MapCells& value, Args&... args)
+{
+    std::memcpy(value.data, buffer.read(value.size), value.size);
+    read(buffer, args...);
+}
+
 /**************************************************************************************************/
 
 }
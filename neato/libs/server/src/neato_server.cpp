@@ -4,6 +4,8 @@
 #include "jaw_server.hpp"
 #include "neato_protocol.hpp"
 
+#include <algorithm>
+
 using namespace Neato;
 
 namespace Jaw {
@@ -17,6 +19,15 @@ using NeatoServer = Server<Command>;
 template<>
 const NeatoServer::Config& NeatoServer::config()
 {
+    // Publish tiles changed in the map, so subscribers can keep their copy up to date.
+    static auto map_callback = [](void* user_data, const neato_map_update_t* update)
+    {
+        Handle* handle = static_cast<Handle*>(user_data);
+        OutputBuffer message;
+        write(message, Command::MAP_CALLBACK_SET, *update);
+        handle->publish(std::move(message));
+    };
+
     static Config NeatoServerConfig = {
 
         // Create Command
@@ -47,6 +58,16 @@ const NeatoServer::Config& NeatoServer::config()
                 return reply;
             }},
 
+            { Command::POSE_AT, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                uint64_t timestamp;
+                read(args, timestamp);
+                neato_pose_t pose;
+                int error = neato_pose_at(handle.value, timestamp, &pose);
+                write(reply, error, pose);
+                return reply;
+            }},
+
             { Command::LASER_SCAN_GET, [](Handle& handle, InputBuffer) {
                 OutputBuffer reply;
                 neato_laser_data_t laser_data;
@@ -55,6 +76,113 @@ const NeatoServer::Config& NeatoServer::config()
                 return reply;
             }},
 
+            { Command::LASER_SCAN_EX_GET, [](Handle& handle, InputBuffer) {
+                OutputBuffer reply;
+                neato_laser_scan_ex_t scan;
+                int error = neato_laser_scan_ex_get(handle.value, &scan);
+                write(reply, error, scan);
+                return reply;
+            }},
+
+            { Command::LASER_SCAN_WAIT, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                uint64_t sequence;
+                unsigned int timeout_ms;
+                read(args, sequence, timeout_ms);
+                // Requests are handled one at a time, so other clients wait as well.
+                timeout_ms = std::min(timeout_ms, static_cast<unsigned int>(NEATO_LASER_WAIT_MAX_MS));
+                neato_laser_scan_ex_t scan;
+                int error = neato_laser_scan_wait(handle.value, sequence, timeout_ms, &scan);
+                write(reply, error, scan);
+                return reply;
+            }},
+
+            { Command::LASER_POINTS_GET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                neato_frame_t frame;
+                read(args, frame);
+                neato_laser_points_t points = {};
+                int error = neato_laser_points_get(handle.value, frame, &points);
+
+                // Points are sent as long as num_points says, so only write them if they were filled.
+                write(reply, error);
+                if (error == 0) {
+                    write(reply, points);
+                }
+                return reply;
+            }},
+
+            { Command::MAP_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                neato_map_config_t config;
+                read(args, enable, config);
+                int error = neato_map_set(handle.value, enable ? &config : nullptr);
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::MAP_CALLBACK_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                read(args, enable);
+                int error = 0;
+
+                if (enable) {
+                    error = neato_map_callback_set(handle.value, &handle, map_callback);
+                } else {
+                    error = neato_map_callback_set(handle.value, nullptr, nullptr);
+                }
+
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::MAP_INTEGRATE, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                neato_laser_data_t laser_data;
+                read(args, laser_data);
+                int error = neato_map_integrate(handle.value, &laser_data);
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::MAP_GET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                neato_map_region_t region;
+                read(args, region);
+
+                // Validate region before allocating cells for it.
+                std::vector<uint8_t> cells;
+                int error = static_cast<int>(std::errc::invalid_argument);
+                if (region.width > 0 && region.height > 0 &&
+                    region.width <= NEATO_MAP_MAX_REGION && region.height <= NEATO_MAP_MAX_REGION) {
+                    cells.resize(static_cast<std::size_t>(region.width) * region.height);
+                    error = neato_map_get(handle.value, &region, cells.data());
+                }
+
+                write(reply, error, MapCells{ cells.data(), cells.size() });
+                return reply;
+            }},
+
+            { Command::SCAN_MATCH_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                neato_scan_match_config_t config;
+                read(args, enable, config);
+                int error = neato_scan_match_set(handle.value, enable ? &config : nullptr);
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::SCAN_MATCH_STATS_GET, [](Handle& handle, InputBuffer) {
+                OutputBuffer reply;
+                neato_scan_match_stats_t stats;
+                int error = neato_scan_match_stats_get(handle.value, &stats);
+                write(reply, error, stats);
+                return reply;
+            }},
+
             { Command::SPEED_SET, [](Handle& handle, InputBuffer args) {
                 OutputBuffer reply;
                 double speed;
@@ -103,3 +231,24 @@ int neato_server_stop(neato_server_t server)
 }
 
 /*************************************************************************************************/
+
+int neato_server_start_manual(neato_server_t* server, const char* address)
+{
+    return Jaw::NeatoServer::start(server, address, false);
+}
+
+/*************************************************************************************************/
+
+int neato_server_events_fd_get(neato_server_t server, int* fd)
+{
+    return Jaw::NeatoServer::events_fd(server, fd);
+}
+
+/*************************************************************************************************/
+
+int neato_server_process_events(neato_server_t server)
+{
+    return Jaw::NeatoServer::process_events(server);
+}
+
+/*************************************************************************************************/
@@ -0,0 +1,1140 @@
+#include "picam_api.h"
+#include "picam_codec.hpp"
+#include "picam_delta.hpp"
+#include "picam_imgproc.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+
+using namespace PiCam;
+
+/*************************************************************************************************/
+
+// Sequence of frames with the same layout used as benchmark input.
+struct FrameSet
+{
+    std::string name;
+    picam_image_t layout;
+    std::vector<std::vector<unsigned char>> frames;
+};
+
+// Image pointing to the data of frame i of supplied set.
+static picam_image_t frame_image(FrameSet& set, std::size_t i)
+{
+    picam_image_t image = set.layout;
+    image.data = set.frames[i].data();
+    return image;
+}
+
+// Execute method repeatedly returning average execution time in seconds.
+template<class Method>
+static double measure(int repetitions, Method method)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        method();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repetitions;
+}
+
+static const char* format_name(picam_image_format_t format)
+{
+    switch (format) {
+        case PICAM_IMAGE_FORMAT_GRAY: return "gray";
+        case PICAM_IMAGE_FORMAT_RGB: return "rgb";
+        case PICAM_IMAGE_FORMAT_BGR: return "bgr";
+        case PICAM_IMAGE_FORMAT_I420: return "i420";
+        case PICAM_IMAGE_FORMAT_NV12: return "nv12";
+        default: return "unknown";
+    }
+}
+
+/*************************************************************************************************/
+
+// Used to synchronize with the dummy camera thread.
+struct Capture
+{
+    FrameSet* set;
+    std::size_t count;
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+static void capture_callback(void* user_data, picam_image_t* image)
+{
+    Capture* capture = static_cast<Capture*>(user_data);
+    std::lock_guard<std::mutex> lock(capture->mutex);
+    if (capture->set->frames.size() < capture->count) {
+        capture->set->layout = *image;
+        capture->set->frames.emplace_back(image->data, image->data + image->data_size);
+        if (capture->set->frames.size() == capture->count) {
+            capture->done.notify_one();
+        }
+    }
+}
+
+// Grab frames produced by local camera (the dummy one when MMAL is not available).
+static bool capture_frames(FrameSet& set, picam_image_format_t format, unsigned int width, unsigned int height,
+                           std::size_t count)
+{
+    picam_config_t config = {};
+    config.format = format;
+    config.width = width;
+    config.height = height;
+    config.framerate = 60.0;
+    config.pattern = PICAM_PATTERN_GRADIENT;
+
+    picam_camera_t camera = nullptr;
+    if (picam_create(&camera, &config, nullptr)) {
+        return false;
+    }
+
+    Capture capture;
+    capture.set = &set;
+    capture.count = count;
+    set.name = std::string("camera ") + format_name(format);
+
+    int error = picam_callback_set(camera, &capture, &capture_callback);
+    if (!error) {
+        std::unique_lock<std::mutex> lock(capture.mutex);
+        capture.done.wait_for(lock, std::chrono::seconds(10), [&set, count]() { return set.frames.size() == count; });
+    }
+    picam_callback_set(camera, nullptr, nullptr);
+    picam_destroy(camera);
+
+    return !error && set.frames.size() == count;
+}
+
+// Load raw frames stored back to back in a file.
+static bool load_frames(FrameSet& set, const std::string& path, picam_image_format_t format,
+                        unsigned int width, unsigned int height)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    set.name = std::string("recorded ") + format_name(format);
+    set.layout.format = format;
+    set.layout.width = width;
+    set.layout.height = height;
+    set.layout.bytes_per_line = width * bytes_per_pixel(format);
+    set.layout.data_size = image_size(format, width, height);
+    set.layout.data = nullptr;
+    set_planes(set.layout);
+
+    std::vector<unsigned char> frame(set.layout.data_size);
+    while (file.read(reinterpret_cast<char*>(frame.data()), frame.size())) {
+        set.frames.push_back(frame);
+    }
+    return !set.frames.empty();
+}
+
+/*************************************************************************************************/
+
+// Measure encode and decode throughput of the lossless codec and the compression ratio.
+static void bench_codec(FrameSet& set)
+{
+    const picam_image_t layout = codec_view(set.layout);
+    const unsigned int channels = codec_channels(layout.format);
+    const std::size_t raw_size = static_cast<std::size_t>(layout.width) * layout.height * channels;
+    const int repetitions = 5;
+
+    std::vector<std::vector<unsigned char>> encoded(set.frames.size());
+    std::vector<unsigned char> decoded(raw_size);
+
+    std::size_t total_encoded = 0;
+    double encode_time = 0.0;
+    double decode_time = 0.0;
+    bool lossless = true;
+
+    for (std::size_t i = 0; i < set.frames.size(); i++) {
+        picam_image_t image = codec_view(frame_image(set, i));
+        std::vector<unsigned char>& output = encoded[i];
+        output.resize(codec_max_size(image.width, image.height, channels));
+
+        std::size_t size = 0;
+        encode_time += measure(repetitions, [&]() { size = codec_encode(image, output.data()); });
+        output.resize(size);
+        total_encoded += size;
+
+        picam_image_t result = image;
+        result.bytes_per_line = image.width * channels;
+        result.data = decoded.data();
+        decode_time += measure(repetitions, [&]() { codec_decode(output.data(), output.size(), result); });
+
+        for (unsigned int y = 0; y < image.height; y++) {
+            if (std::memcmp(image.data + y * image.bytes_per_line,
+                            result.data + y * result.bytes_per_line, result.bytes_per_line) != 0) {
+                lossless = false;
+            }
+        }
+    }
+
+    const double megabytes = raw_size * set.frames.size() / 1.0e6;
+    const double ratio = static_cast<double>(raw_size * set.frames.size()) / total_encoded;
+
+    std::cout << std::left << std::setw(16) << set.name
+              << " encode " << std::right << std::setw(8) << megabytes / encode_time << " MB/s"
+              << " decode " << std::setw(8) << megabytes / decode_time << " MB/s"
+              << " ratio " << std::setw(6) << ratio
+              << (lossless ? "" : "  MISMATCH!") << std::endl;
+}
+
+// Frames with a static background (first frame of source) and a small moving square.
+// Approximates a fixed camera looking at a mostly static scene.
+static FrameSet static_scene(FrameSet& source)
+{
+    FrameSet set;
+    set.name = "static " + std::string(format_name(source.layout.format));
+    set.layout = source.layout;
+
+    const unsigned int channels = codec_channels(set.layout.format);
+    const unsigned int size = 48;
+
+    for (std::size_t i = 0; i < source.frames.size(); i++) {
+        std::vector<unsigned char> frame = source.frames[0];
+        unsigned int x0 = static_cast<unsigned int>(i * 8) % (set.layout.width - size);
+        unsigned int y0 = set.layout.height / 2;
+        for (unsigned int y = y0; y < y0 + size && y < set.layout.height; y++) {
+            std::memset(&frame[y * set.layout.bytes_per_line + x0 * channels], 255, size * channels);
+        }
+        set.frames.push_back(std::move(frame));
+    }
+    return set;
+}
+
+// Measure encode and decode time of the delta encoding and the bandwidth it saves.
+static void bench_delta(FrameSet& set)
+{
+    const picam_image_t layout = codec_view(set.layout);
+    const unsigned int channels = codec_channels(layout.format);
+    const std::size_t raw_size = static_cast<std::size_t>(layout.width) * layout.height * channels;
+    const int repetitions = 5;
+
+    std::vector<std::vector<unsigned char>> encoded(set.frames.size());
+    std::size_t total_encoded = 0;
+
+    // Encoding depends on previous frames, so the whole sequence is repeated.
+    double encode_time = measure(repetitions, [&]() {
+        DeltaEncoder encoder;
+        total_encoded = 0;
+        for (std::size_t i = 0; i < set.frames.size(); i++) {
+            encoder.encode(codec_view(frame_image(set, i)), encoded[i]);
+            total_encoded += encoded[i].size();
+        }
+    });
+
+    bool lossless = true;
+    double decode_time = measure(repetitions, [&]() {
+        DeltaDecoder decoder;
+        for (std::size_t i = 0; i < set.frames.size(); i++) {
+            picam_image_t result = layout;
+            if (!decoder.decode(encoded[i].data(), encoded[i].size(), result)) {
+                lossless = false;
+            }
+        }
+    });
+
+    // Check the reconstruction of every frame.
+    DeltaDecoder decoder;
+    for (std::size_t i = 0; i < set.frames.size(); i++) {
+        picam_image_t image = codec_view(frame_image(set, i));
+        picam_image_t result = layout;
+        decoder.decode(encoded[i].data(), encoded[i].size(), result);
+        for (unsigned int y = 0; y < image.height; y++) {
+            if (std::memcmp(image.data + y * image.bytes_per_line,
+                            result.data + y * result.bytes_per_line, result.bytes_per_line) != 0) {
+                lossless = false;
+            }
+        }
+    }
+
+    const double frames = static_cast<double>(set.frames.size());
+    const double saved = 100.0 * (1.0 - static_cast<double>(total_encoded) / (raw_size * frames));
+
+    std::cout << std::left << std::setw(16) << set.name
+              << " encode " << std::right << std::setw(8) << 1.0e3 * encode_time / frames << " ms/frame"
+              << " decode " << std::setw(8) << 1.0e3 * decode_time / frames << " ms/frame"
+              << " saved " << std::setw(6) << saved << " %"
+              << (lossless ? "" : "  MISMATCH!") << std::endl;
+}
+
+// Measure time spent building the reduced levels of the image pyramid.
+static void bench_pyramid(FrameSet& set)
+{
+    const int repetitions = 20;
+
+    std::vector<unsigned char> buffers[3];
+    picam_image_t levels[3];
+    unsigned int width = set.layout.width;
+    unsigned int height = set.layout.height;
+    for (int i = 0; i < 3; i++) {
+        width /= 2;
+        height /= 2;
+        buffers[i].resize(image_size(set.layout.format, width, height));
+        levels[i].data = buffers[i].data();
+    }
+
+    std::cout << std::left << std::setw(16) << set.name << std::right;
+
+    // Each level is reduced from the previous one, so time is accumulated.
+    double total = 0.0;
+    for (int i = 0; i < 3; i++) {
+        double elapsed = 0.0;
+        for (std::size_t f = 0; f < set.frames.size(); f++) {
+            picam_image_t source = (i == 0) ? frame_image(set, f) : levels[i - 1];
+            elapsed += measure(repetitions, [&]() { downscale_half(source, levels[i]); });
+        }
+        total += elapsed / set.frames.size();
+        std::cout << " 1/" << (2 << i) << " " << std::setw(7) << 1.0e3 * total << " ms";
+    }
+
+    const double megabytes = image_size(set.layout.format, set.layout.width, set.layout.height) / 1.0e6;
+    std::cout << "  (" << megabytes / total << " MB/s input)" << std::endl;
+}
+
+// Measure motion kernels on the luma of consecutive frames, checking block sums against a plain
+// loop and the background update against its definition.
+static void bench_motion(FrameSet& set)
+{
+    const int repetitions = 20;
+
+    Plane planes[3];
+    picam_image_t first = frame_image(set, 0);
+    image_planes(first, planes);
+    if (planes[0].channels != 1 || set.frames.size() < 2) {
+        return;
+    }
+    const unsigned int width = planes[0].width;
+    const unsigned int height = planes[0].height;
+    const unsigned int blocks = (width / 8) * (height / 8);
+
+    std::vector<unsigned int> sums(blocks);
+    std::vector<unsigned char> background(width * height);
+    Plane back = { background.data(), width, height, width, 1 };
+    bool valid = true;
+
+    double differences = 0.0;
+    double follow = 0.0;
+    for (std::size_t f = 1; f < set.frames.size(); f++) {
+        Plane previous[3], current[3];
+        image_planes(frame_image(set, f - 1), previous);
+        image_planes(frame_image(set, f), current);
+
+        differences += measure(repetitions, [&]() { block_differences(current[0], previous[0], sums.data()); });
+        for (unsigned int b = 0; b < blocks && valid; b++) {
+            const unsigned int bx = b % (width / 8), by = b / (width / 8);
+            unsigned int sum = 0;
+            for (unsigned int y = 8 * by; y < 8 * by + 8; y++) {
+                for (unsigned int x = 8 * bx; x < 8 * bx + 8; x++) {
+                    sum += std::abs(current[0].data[y * current[0].bytes_per_line + x] -
+                                    previous[0].data[y * previous[0].bytes_per_line + x]);
+                }
+            }
+            valid = (sum == sums[b]);
+        }
+
+        for (unsigned int y = 0; y < height; y++) {
+            std::memcpy(background.data() + y * width, previous[0].data + y * previous[0].bytes_per_line, width);
+        }
+        follow_background(current[0], back);
+        for (unsigned int y = 0; y < height && valid; y++) {
+            for (unsigned int x = 0; x < width && valid; x++) {
+                const int from = previous[0].data[y * previous[0].bytes_per_line + x];
+                const int to = current[0].data[y * current[0].bytes_per_line + x];
+                valid = (background[y * width + x] == from + (to > from) - (to < from));
+            }
+        }
+        follow += measure(repetitions, [&]() { follow_background(current[0], back); });
+    }
+    differences /= set.frames.size() - 1;
+    follow /= set.frames.size() - 1;
+
+    const double megapixels = width * height / 1.0e6;
+    std::cout << std::left << std::setw(16) << set.name << std::right
+              << " differences " << std::setw(7) << 1.0e3 * differences << " ms"
+              << " (" << std::setw(7) << megapixels / differences << " MP/s)"
+              << "  background " << std::setw(7) << 1.0e3 * follow << " ms"
+              << " (" << std::setw(7) << megapixels / follow << " MP/s)"
+              << (valid ? "" : "  MISMATCH!") << std::endl;
+}
+
+/*************************************************************************************************/
+
+static void bench_stats(FrameSet& set)
+{
+    const int repetitions = 20;
+
+    Plane planes[3];
+    const unsigned int count = image_planes(frame_image(set, 0), planes);
+
+    double full = 0.0;
+    double sampled = 0.0;
+    bool valid = true;
+    for (std::size_t f = 0; f < set.frames.size(); f++) {
+        image_planes(frame_image(set, f), planes);
+
+        for (unsigned int i = 0; i < count; i++) {
+            const Plane& plane = planes[i];
+            std::vector<std::uint32_t> counted(plane.channels * 256);
+            std::vector<std::uint32_t> expected(plane.channels * 256);
+            std::uint32_t* histograms[3];
+            for (unsigned int c = 0; c < plane.channels; c++) {
+                histograms[c] = counted.data() + 256 * c;
+            }
+
+            // Step 1 takes the unrolled path for single channels, step 3 the one for every channel.
+            for (unsigned int step : { 1u, 3u }) {
+                std::fill(counted.begin(), counted.end(), 0);
+                std::fill(expected.begin(), expected.end(), 0);
+                count_values(plane, step, histograms);
+                for (unsigned int y = 0; y < plane.height; y += step) {
+                    for (unsigned int x = 0; x < plane.width; x += step) {
+                        for (unsigned int c = 0; c < plane.channels; c++) {
+                            expected[256 * c + plane.data[y * plane.bytes_per_line + x * plane.channels + c]]++;
+                        }
+                    }
+                }
+                valid = valid && (counted == expected);
+            }
+
+            full += measure(repetitions, [&]() { count_values(plane, 1, histograms); });
+            sampled += measure(repetitions, [&]() { count_values(plane, 4, histograms); });
+        }
+    }
+    full /= set.frames.size();
+    sampled /= set.frames.size();
+
+    const double megapixels = set.layout.width * set.layout.height / 1.0e6;
+    std::cout << std::left << std::setw(16) << set.name << std::right
+              << " histograms " << std::setw(7) << 1.0e3 * full << " ms"
+              << " (" << std::setw(7) << megapixels / full << " MP/s)"
+              << "  step 4 " << std::setw(7) << 1.0e3 * sampled << " ms"
+              << (valid ? "" : "  MISMATCH!") << std::endl;
+}
+
+/*************************************************************************************************/
+
+// Copy region pixel by pixel, used as reference for the crop engine.
+static std::vector<unsigned char> reference_crop(const picam_image_t& image, const PixelRect& rect)
+{
+    Plane planes[3];
+    const unsigned int count = image_planes(image, planes);
+
+    std::vector<unsigned char> result;
+    for (unsigned int i = 0; i < count; i++) {
+        const Plane& plane = planes[i];
+        const unsigned int scale = (i == 0) ? 1 : 2;
+        for (unsigned int y = rect.y / scale; y < (rect.y + rect.height) / scale; y++) {
+            for (unsigned int x = rect.x / scale; x < (rect.x + rect.width) / scale; x++) {
+                for (unsigned int c = 0; c < plane.channels; c++) {
+                    result.push_back(plane.data[y * plane.bytes_per_line + x * plane.channels + c]);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+// Check crops against the reference, with and without line padding, and measure throughput.
+static void bench_crop(FrameSet& set)
+{
+    const picam_roi_t rois[] = {
+        { 0.0f, 0.0f, 1.0f, 1.0f },
+        { 0.25f, 0.25f, 0.5f, 0.5f },
+        { 0.1f, 0.7f, 0.33f, 0.3f },
+        { 0.9f, 0.0f, 0.1f, 1.0f },
+        { 0.013f, 0.021f, 0.517f, 0.313f },
+    };
+    const unsigned int padding = 12;
+    const int repetitions = 20;
+
+    // Same frame with extra bytes at the end of each line of every plane.
+    picam_image_t padded = frame_image(set, 0);
+    Plane planes[3];
+    padded.num_planes = image_planes(padded, planes);
+
+    std::vector<unsigned char> padded_data;
+    for (unsigned int i = 0; i < padded.num_planes; i++) {
+        const unsigned int line_size = planes[i].width * planes[i].channels;
+        padded.planes[i].offset = static_cast<unsigned int>(padded_data.size());
+        padded.planes[i].bytes_per_line = line_size + padding;
+        for (unsigned int y = 0; y < planes[i].height; y++) {
+            const unsigned char* line = planes[i].data + y * planes[i].bytes_per_line;
+            padded_data.insert(padded_data.end(), line, line + line_size);
+            padded_data.insert(padded_data.end(), padding, 0xAA);
+        }
+    }
+    padded.bytes_per_line = padded.planes[0].bytes_per_line;
+    padded.data_size = static_cast<unsigned int>(padded_data.size());
+    padded.data = padded_data.data();
+
+    std::vector<unsigned char> output(set.layout.data_size);
+    std::size_t bytes = 0;
+    double elapsed = 0.0;
+    bool correct = true;
+
+    for (const picam_image_t& image : { frame_image(set, 0), padded }) {
+        for (const picam_roi_t& roi : rois) {
+            PixelRect rect = roi_to_rect(roi, image.format, image.width, image.height);
+            picam_image_t result;
+            result.data = output.data();
+            elapsed += measure(repetitions, [&]() { crop(image, rect, result); });
+            bytes += result.data_size;
+
+            std::vector<unsigned char> reference = reference_crop(image, rect);
+            if (reference.size() != result.data_size ||
+                std::memcmp(reference.data(), result.data, reference.size()) != 0) {
+                correct = false;
+            }
+        }
+    }
+
+    std::cout << std::left << std::setw(16) << set.name << std::right
+              << " crop " << std::setw(8) << bytes / elapsed / 1.0e6 << " MB/s"
+              << (correct ? "" : "  MISMATCH!") << std::endl;
+}
+
+/*************************************************************************************************/
+
+/*************************************************************************************************/
+
+// Measure conversion from the set format to every other format. Conversions that can be
+// reverted without loss (channel swaps) are checked to return the original frame.
+static void bench_convert(FrameSet& set)
+{
+    const picam_image_format_t formats[] = {
+        PICAM_IMAGE_FORMAT_GRAY,
+        PICAM_IMAGE_FORMAT_RGB,
+        PICAM_IMAGE_FORMAT_BGR,
+        PICAM_IMAGE_FORMAT_I420,
+        PICAM_IMAGE_FORMAT_NV12,
+    };
+    const int repetitions = 20;
+
+    const picam_image_t input = frame_image(set, 0);
+    std::vector<unsigned char> output(image_size(PICAM_IMAGE_FORMAT_RGB, input.width, input.height));
+    std::vector<unsigned char> back(output.size());
+
+    std::cout << std::left << std::setw(16) << set.name << std::right;
+
+    for (picam_image_format_t format : formats) {
+        if (format == input.format || !can_convert(input.format, format)) {
+            continue;
+        }
+        picam_image_t result;
+        result.data = output.data();
+        double elapsed = measure(repetitions, [&]() { convert(input, format, result); });
+
+        bool correct = true;
+        if (bytes_per_pixel(format) == 3 && bytes_per_pixel(input.format) == 3) {
+            picam_image_t restored;
+            restored.data = back.data();
+            convert(result, input.format, restored);
+            correct = std::memcmp(restored.data, input.data, restored.data_size) == 0;
+        }
+
+        std::cout << " " << format_name(format) << " " << std::setw(7) << 1.0e3 * elapsed << " ms"
+                  << (correct ? "" : " MISMATCH!");
+    }
+
+    std::cout << std::endl;
+}
+
+/*************************************************************************************************/
+
+/*************************************************************************************************/
+
+// Counters updated by the synthetic camera thread.
+struct Stream
+{
+    std::uint64_t frames;
+    std::uint64_t corrupt;
+    std::uint64_t first_sequence;
+    std::uint64_t last_sequence;
+    std::uint32_t first_dropped;
+    std::uint32_t last_dropped;
+    double latency;
+};
+
+static void stream_callback(void* user_data, picam_image_t* image)
+{
+    Stream* stream = static_cast<Stream*>(user_data);
+
+    // Stamp written by the synthetic camera must agree with metadata.
+    std::uint64_t sequence, timestamp;
+    std::memcpy(&sequence, image->data, sizeof(sequence));
+    std::memcpy(&timestamp, image->data + sizeof(sequence), sizeof(timestamp));
+    if (sequence != image->sequence || timestamp != image->timestamp) {
+        stream->corrupt++;
+    }
+
+    const std::uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    // Camera may deliver frames before the callback is set.
+    if (stream->frames == 0) {
+        stream->first_sequence = sequence;
+        stream->first_dropped = image->dropped;
+    }
+    stream->last_sequence = sequence;
+    stream->last_dropped = image->dropped;
+    stream->latency += (now - timestamp) / 1.0e3;
+    stream->frames++;
+}
+
+// Measure how fast the unthrottled synthetic camera delivers frames through the local pipeline.
+// Consumer work (in microseconds) simulates a slow client, so frames are dropped by the pipeline.
+static void bench_synthetic(picam_image_format_t format, picam_pattern_t pattern, unsigned int width,
+                            unsigned int height, picam_delivery_t delivery = PICAM_DELIVERY_NEWEST,
+                            unsigned int work = 0)
+{
+    static const char* names[] = { "gradient", "noise", "box" };
+    static const char* policies[] = { "newest", "queue" };
+
+    picam_config_t config = {};
+    config.format = format;
+    config.width = width;
+    config.height = height;
+    config.framerate = 0.0;
+    config.pattern = pattern;
+    config.backend = PICAM_BACKEND_SYNTHETIC;
+    config.delivery = delivery;
+
+    picam_camera_t camera = nullptr;
+    if (picam_create(&camera, &config, nullptr)) {
+        std::cout << "Failed to create synthetic camera" << std::endl;
+        return;
+    }
+
+    Stream stream = {};
+    std::pair<Stream*, unsigned int> context(&stream, work);
+    picam_callback_set(camera, &context, [](void* user_data, picam_image_t* image) {
+        auto context = static_cast<std::pair<Stream*, unsigned int>*>(user_data);
+        stream_callback(context->first, image);
+        if (context->second) {
+            std::this_thread::sleep_for(std::chrono::microseconds(context->second));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    picam_callback_set(camera, nullptr, nullptr);
+    picam_destroy(camera);
+
+    // Every sequence number not delivered must be reported as dropped. Frames dropped after the
+    // last delivered one may be counted too.
+    const std::uint64_t missing = stream.frames ? stream.last_sequence - stream.first_sequence + 1 - stream.frames : 0;
+    const std::uint64_t reported = stream.last_dropped - stream.first_dropped;
+
+    const double megabytes = image_size(format, width, height) * static_cast<double>(stream.frames) / 1.0e6;
+    std::cout << std::left << std::setw(6) << format_name(format) << std::setw(10) << names[pattern]
+              << std::setw(7) << policies[delivery]
+              << std::right << std::setw(5) << width << "x" << std::setw(4) << height
+              << std::setw(9) << stream.frames << " fps " << std::setw(8) << megabytes << " MB/s"
+              << " latency " << std::setw(8) << (stream.frames ? stream.latency / stream.frames : 0.0) << " us"
+              << " dropped " << std::setw(8) << missing
+              << (stream.corrupt ? "  CORRUPT!" : "") << (reported != missing ? "  WRONG DROP COUNT!" : "")
+              << std::endl;
+}
+
+/*************************************************************************************************/
+
+// Frames kept after the callback, either acquired or copied.
+struct Holder
+{
+    bool acquire;
+    std::deque<picam_image_t*> frames;
+    std::deque<std::vector<unsigned char>> copies;
+    std::uint64_t received;
+    std::uint64_t corrupt;
+};
+
+// Returns true if stamp written by the synthetic camera matches image sequence.
+static bool stamp_valid(const picam_image_t* image)
+{
+    std::uint64_t sequence;
+    std::memcpy(&sequence, image->data, sizeof(sequence));
+    return sequence == image->sequence;
+}
+
+static void holder_callback(void* user_data, picam_image_t* image)
+{
+    Holder* holder = static_cast<Holder*>(user_data);
+    holder->received++;
+
+    if (!holder->acquire) {
+        holder->copies.emplace_back(image->data, image->data + image->data_size);
+        if (holder->copies.size() > 2) {
+            holder->copies.pop_front();
+        }
+        return;
+    }
+
+    picam_image_t* frame = nullptr;
+    if (picam_frame_acquire(image, &frame)) {
+        holder->corrupt++;
+        return;
+    }
+    holder->frames.push_back(frame);
+
+    // Camera must not reuse buffers while they are held.
+    if (holder->frames.size() > 2) {
+        if (!stamp_valid(holder->frames.front())) {
+            holder->corrupt++;
+        }
+        picam_frame_release(holder->frames.front());
+        holder->frames.pop_front();
+    }
+}
+
+// Compare holding frames beyond the callback by copying them and by acquiring their buffers.
+static void bench_acquire(picam_image_format_t format, unsigned int width, unsigned int height)
+{
+    for (bool acquire : { false, true }) {
+        picam_config_t config = {};
+        config.format = format;
+        config.width = width;
+        config.height = height;
+        config.framerate = 0.0;
+        config.pattern = PICAM_PATTERN_BOX;
+        config.backend = PICAM_BACKEND_SYNTHETIC;
+        config.queue_depth = 4;
+
+        picam_camera_t camera = nullptr;
+        if (picam_create(&camera, &config, nullptr)) {
+            std::cout << "Failed to create synthetic camera" << std::endl;
+            return;
+        }
+
+        Holder holder = {};
+        holder.acquire = acquire;
+        picam_callback_set(camera, &holder, &holder_callback);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        picam_callback_set(camera, nullptr, nullptr);
+
+        for (picam_image_t* frame : holder.frames) {
+            picam_frame_release(frame);
+        }
+        picam_destroy(camera);
+
+        std::cout << std::left << std::setw(6) << format_name(format) << std::setw(8)
+                  << (acquire ? "acquire" : "copy") << std::right << std::setw(5) << width << "x"
+                  << std::setw(4) << height << std::setw(9) << holder.received << " fps"
+                  << (holder.corrupt ? "  CORRUPT!" : "") << std::endl;
+    }
+}
+
+/*************************************************************************************************/
+
+// Sink receiving frames for bench_sinks, work (in milliseconds) simulates a slow consumer.
+struct SinkStats
+{
+    const char* name;
+    unsigned int work;
+    std::uint64_t frames;
+    std::uint32_t dropped;
+};
+
+static void sink_callback(void* user_data, picam_image_t* image)
+{
+    SinkStats* stats = static_cast<SinkStats*>(user_data);
+    stats->frames++;
+    stats->dropped = image->dropped;
+    if (stats->work) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(stats->work));
+    }
+}
+
+// Check that a slow sink doesn't stall the others.
+static void bench_sinks()
+{
+    picam_config_t config = {};
+    config.format = PICAM_IMAGE_FORMAT_GRAY;
+    config.width = 640;
+    config.height = 480;
+    config.framerate = 120.0;
+    config.pattern = PICAM_PATTERN_GRADIENT;
+    config.backend = PICAM_BACKEND_SYNTHETIC;
+
+    picam_camera_t camera = nullptr;
+    if (picam_create(&camera, &config, nullptr)) {
+        std::cout << "Failed to create synthetic camera" << std::endl;
+        return;
+    }
+
+    SinkStats stats[] = {
+        { "tracking", 0, 0, 0 },
+        { "decimated", 0, 0, 0 },
+        { "limited", 0, 0, 0 },
+        { "recorder", 50, 0, 0 },
+    };
+    picam_sink_config_t configs[] = {
+        { 0, 0.0, 0, PICAM_DELIVERY_NEWEST },
+        { 4, 0.0, 0, PICAM_DELIVERY_NEWEST },
+        { 0, 15.0, 0, PICAM_DELIVERY_NEWEST },
+        { 0, 0.0, 8, PICAM_DELIVERY_QUEUE },
+    };
+
+    picam_sink_t sinks[4];
+    for (int i = 0; i < 4; i++) {
+        picam_sink_add(camera, &configs[i], &stats[i], &sink_callback, &sinks[i]);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    for (int i = 0; i < 4; i++) {
+        picam_sink_remove(camera, sinks[i]);
+    }
+    picam_destroy(camera);
+
+    for (auto& sink : stats) {
+        std::cout << std::left << std::setw(10) << sink.name << std::right
+                  << std::setw(8) << sink.frames / 2.0 << " fps  dropped " << std::setw(5) << sink.dropped
+                  << std::endl;
+    }
+}
+
+/*************************************************************************************************/
+
+// Frames counted by bench_replay.
+static void count_callback(void* user_data, picam_image_t*)
+{
+    (*static_cast<std::uint64_t*>(user_data))++;
+}
+
+// Record the synthetic camera configured by config for a second.
+static bool record_synthetic(const picam_config_t& config, const char* path)
+{
+    picam_camera_t camera = nullptr;
+    picam_recorder_t recorder = nullptr;
+    if (picam_recorder_create(&recorder, path)) {
+        std::cout << "Failed to create recording " << path << std::endl;
+        return false;
+    }
+    if (picam_create(&camera, &config, nullptr)) {
+        std::cout << "Failed to create synthetic camera" << std::endl;
+        picam_recorder_destroy(recorder);
+        return false;
+    }
+
+    picam_sink_config_t sink_config = { 0, 0.0, 4, PICAM_DELIVERY_NEWEST };
+    picam_sink_t sink;
+    picam_sink_add(camera, &sink_config, recorder, &picam_recorder_callback, &sink);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    picam_sink_remove(camera, sink);
+    picam_destroy(camera);
+    picam_recorder_destroy(recorder);
+    return true;
+}
+
+// Record the synthetic camera for a second, then replay the file as fast as possible and at the
+// recorded rate. Replayed frames point to the mapped file, so replay is not limited by copies.
+static void bench_replay(picam_image_format_t format, unsigned int width, unsigned int height)
+{
+    const char* path = "picam_bench_replay.rec";
+
+    picam_config_t config = {};
+    config.format = format;
+    config.width = width;
+    config.height = height;
+    config.framerate = 0.0;
+    config.pattern = PICAM_PATTERN_BOX;
+    config.backend = PICAM_BACKEND_SYNTHETIC;
+
+    if (!record_synthetic(config, path)) {
+        return;
+    }
+    picam_camera_t camera = nullptr;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    const double megabytes = static_cast<double>(file.tellg()) / 1.0e6;
+
+    // Replay backend reads the recording named by PICAM_REPLAY.
+    setenv("PICAM_REPLAY", path, 1);
+    config.backend = PICAM_BACKEND_REPLAY;
+    std::uint64_t replayed[2] = { 0, 0 };
+    for (int paced = 0; paced < 2; paced++) {
+        config.framerate = paced ? 1.0 : 0.0;
+        if (picam_create(&camera, &config, nullptr)) {
+            std::cout << "Failed to replay " << path << std::endl;
+            break;
+        }
+        picam_callback_set(camera, &replayed[paced], &count_callback);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        picam_callback_set(camera, nullptr, nullptr);
+        picam_destroy(camera);
+    }
+    unsetenv("PICAM_REPLAY");
+    std::remove(path);
+
+    std::cout << std::left << std::setw(6) << format_name(format) << std::right << std::setw(5) << width
+              << "x" << std::setw(4) << height << " record " << std::setw(8) << megabytes << " MB/s"
+              << "  replay " << std::setw(8) << replayed[0] << " fps"
+              << "  recorded rate " << std::setw(6) << replayed[1] << " fps" << std::endl;
+}
+
+/*************************************************************************************************/
+
+// Test pixel with the definition of FAST-9, used as reference for fast_scores.
+static unsigned int reference_fast(const Plane& gray, unsigned int x, unsigned int y, int threshold)
+{
+    static const int circle[16][2] = {
+        {  0, -3 }, {  1, -3 }, {  2, -2 }, {  3, -1 }, {  3,  0 }, {  3,  1 }, {  2,  2 }, {  1,  3 },
+        {  0,  3 }, { -1,  3 }, { -2,  2 }, { -3,  1 }, { -3,  0 }, { -3, -1 }, { -2, -2 }, { -1, -3 },
+    };
+    const int center = gray.data[y * gray.bytes_per_line + x];
+    int values[16];
+    for (int k = 0; k < 16; k++) {
+        values[k] = gray.data[(y + circle[k][1]) * gray.bytes_per_line + x + circle[k][0]];
+    }
+
+    for (int sign : { 1, -1 }) {
+        for (int start = 0; start < 16; start++) {
+            bool arc = true;
+            for (int k = start; k < start + 9 && arc; k++) {
+                arc = sign * (values[k % 16] - center) > threshold;
+            }
+            if (arc) {
+                unsigned int score = 0;
+                for (int k = 0; k < 16; k++) {
+                    score += std::max(0, sign * (values[k] - center) - threshold);
+                }
+                return score;
+            }
+        }
+    }
+    return 0;
+}
+
+// Find corners on an image of random blocks, full of them, checking scores against the definition.
+static void bench_fast(unsigned int width, unsigned int height)
+{
+    const int repetitions = 20;
+    const unsigned int threshold = 20;
+
+    std::vector<unsigned char> pixels(width * height);
+    std::srand(1);
+    for (unsigned int by = 0; by < height; by += 4) {
+        for (unsigned int bx = 0; bx < width; bx += 4) {
+            const unsigned char value = static_cast<unsigned char>(std::rand() % 256);
+            for (unsigned int y = by; y < std::min(by + 4, height); y++) {
+                for (unsigned int x = bx; x < std::min(bx + 4, width); x++) {
+                    pixels[y * width + x] = value;
+                }
+            }
+        }
+    }
+    Plane gray = { pixels.data(), width, height, width, 1 };
+
+    std::vector<std::uint16_t> scores(width * height);
+    std::vector<Corner> corners;
+    fast_scores(gray, threshold, 0, height, scores.data());
+    bool valid = true;
+    for (unsigned int y = kFeatureBorder; y + kFeatureBorder < height && valid; y++) {
+        for (unsigned int x = kFeatureBorder; x + kFeatureBorder < width && valid; x++) {
+            valid = (scores[y * width + x] == reference_fast(gray, x, y, threshold));
+        }
+    }
+
+    const double scoring = measure(repetitions, [&]() { fast_scores(gray, threshold, 0, height, scores.data()); });
+    const double suppression = measure(repetitions, [&]() {
+        corners.clear();
+        suppress_non_maxima(scores.data(), width, height, 0, height, corners);
+    });
+
+    std::cout << "blocks " << std::setw(5) << width << "x" << std::setw(4) << height
+              << " scores " << std::setw(7) << 1.0e3 * scoring << " ms"
+              << "  suppression " << std::setw(7) << 1.0e3 * suppression << " ms"
+              << "  corners " << std::setw(6) << corners.size()
+              << (valid ? "" : "  MISMATCH!") << std::endl;
+}
+
+// Frames and keypoints counted by bench_features.
+struct FeatureCount
+{
+    std::uint64_t frames;
+    std::uint64_t keypoints;
+};
+
+static void features_callback(void* user_data, const picam_features_t* features)
+{
+    FeatureCount* count = static_cast<FeatureCount*>(user_data);
+    count->frames++;
+    count->keypoints += features->num_keypoints;
+}
+
+// Extract features from the synthetic camera, and from a recording of it, as fast as they can be produced.
+static void bench_features(picam_pattern_t pattern, unsigned int width, unsigned int height)
+{
+    const char* path = "picam_bench_features.rec";
+
+    picam_config_t config = {};
+    config.format = PICAM_IMAGE_FORMAT_GRAY;
+    config.width = width;
+    config.height = height;
+    config.framerate = 0.0;
+    config.pattern = pattern;
+    config.backend = PICAM_BACKEND_SYNTHETIC;
+
+    if (!record_synthetic(config, path)) {
+        return;
+    }
+    setenv("PICAM_REPLAY", path, 1);
+
+    // Threads: one stripe, and one per core.
+    FeatureCount counts[2][2] = {};
+    for (int replay = 0; replay < 2; replay++) {
+        config.backend = replay ? PICAM_BACKEND_REPLAY : PICAM_BACKEND_SYNTHETIC;
+        for (int parallel = 0; parallel < 2; parallel++) {
+            picam_camera_t camera = nullptr;
+            if (picam_create(&camera, &config, nullptr)) {
+                std::cout << "Failed to create camera" << std::endl;
+                continue;
+            }
+            picam_features_config_t features = { 0, 500, 1, parallel ? 0u : 1u };
+            picam_features_set(camera, &features);
+            picam_features_callback_set(camera, &counts[replay][parallel], &features_callback);
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            picam_features_callback_set(camera, nullptr, nullptr);
+            picam_destroy(camera);
+        }
+    }
+    unsetenv("PICAM_REPLAY");
+    std::remove(path);
+
+    const char* names[] = { "synthetic", "replay" };
+    for (int replay = 0; replay < 2; replay++) {
+        const FeatureCount& single = counts[replay][0];
+        const FeatureCount& parallel = counts[replay][1];
+        std::cout << std::left << std::setw(10) << names[replay] << std::setw(9)
+                  << (pattern == PICAM_PATTERN_NOISE ? "noise" : "box") << std::right << std::setw(5) << width
+                  << "x" << std::setw(4) << height
+                  << "  1 thread " << std::setw(6) << single.frames << " fps"
+                  << "  all cores " << std::setw(6) << parallel.frames << " fps"
+                  << "  keypoints " << std::setw(4) << (parallel.frames ? parallel.keypoints / parallel.frames : 0)
+                  << std::endl;
+    }
+}
+
+/*************************************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    // Optional recorded frames: picam_bench <file> <width> <height> <gray|rgb|bgr|i420|nv12>
+    std::vector<FrameSet> sets;
+
+    const unsigned int width = 640;
+    const unsigned int height = 480;
+    const std::size_t count = 30;
+
+    for (auto format : { PICAM_IMAGE_FORMAT_GRAY, PICAM_IMAGE_FORMAT_RGB, PICAM_IMAGE_FORMAT_I420 }) {
+        FrameSet set;
+        if (capture_frames(set, format, width, height, count)) {
+            sets.push_back(std::move(set));
+        } else {
+            std::cout << "Failed to capture " << format_name(format) << " frames from camera" << std::endl;
+        }
+    }
+
+    if (argc > 4) {
+        std::string name(argv[4]);
+        picam_image_format_t format = PICAM_IMAGE_FORMAT_RGB;
+        if (name == "gray") format = PICAM_IMAGE_FORMAT_GRAY;
+        if (name == "bgr") format = PICAM_IMAGE_FORMAT_BGR;
+        if (name == "i420") format = PICAM_IMAGE_FORMAT_I420;
+        if (name == "nv12") format = PICAM_IMAGE_FORMAT_NV12;
+
+        FrameSet set;
+        if (load_frames(set, argv[1], format, std::stoi(argv[2]), std::stoi(argv[3]))) {
+            sets.push_back(std::move(set));
+        } else {
+            std::cout << "Failed to load recorded frames from " << argv[1] << std::endl;
+        }
+    }
+
+    const std::size_t captured = sets.size();
+    for (std::size_t i = 0; i < captured; i++) {
+        sets.push_back(static_scene(sets[i]));
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    std::cout << "== Lossless codec ==" << std::endl;
+    for (auto& set : sets) {
+        bench_codec(set);
+    }
+
+    std::cout << "== Delta encoding ==" << std::endl;
+    std::cout << std::setprecision(3);
+    for (auto& set : sets) {
+        bench_delta(set);
+    }
+
+    std::cout << "== Pyramid ==" << std::endl;
+    for (std::size_t i = 0; i < captured; i++) {
+        bench_pyramid(sets[i]);
+    }
+
+    std::cout << "== Motion ==" << std::endl;
+    for (std::size_t i = 0; i < captured; i++) {
+        bench_motion(sets[i]);
+    }
+
+    std::cout << "== Statistics ==" << std::endl;
+    for (std::size_t i = 0; i < captured; i++) {
+        bench_stats(sets[i]);
+    }
+
+    std::cout << "== Features ==" << std::endl;
+    bench_fast(640, 480);
+    bench_fast(1920, 1080);
+    bench_features(PICAM_PATTERN_BOX, 640, 480);
+    bench_features(PICAM_PATTERN_NOISE, 640, 480);
+
+    std::cout << "== Crop ==" << std::endl;
+    for (std::size_t i = 0; i < captured; i++) {
+        bench_crop(sets[i]);
+    }
+
+    std::cout << "== Convert ==" << std::endl;
+    for (std::size_t i = 0; i < captured; i++) {
+        bench_convert(sets[i]);
+    }
+
+    std::cout << "== Synthetic camera ==" << std::endl;
+    for (auto format : { PICAM_IMAGE_FORMAT_GRAY, PICAM_IMAGE_FORMAT_RGB, PICAM_IMAGE_FORMAT_I420 }) {
+        for (auto pattern : { PICAM_PATTERN_GRADIENT, PICAM_PATTERN_NOISE, PICAM_PATTERN_BOX }) {
+            bench_synthetic(format, pattern, 640, 480);
+        }
+        bench_synthetic(format, PICAM_PATTERN_BOX, 1920, 1080);
+    }
+
+    // Slow consumer: newest frame keeps latency low while queue delivers older frames in order.
+    for (auto delivery : { PICAM_DELIVERY_NEWEST, PICAM_DELIVERY_QUEUE }) {
+        bench_synthetic(PICAM_IMAGE_FORMAT_GRAY, PICAM_PATTERN_GRADIENT, 640, 480, delivery, 1000);
+    }
+
+    std::cout << "== Sinks (camera at 120 fps) ==" << std::endl;
+    bench_sinks();
+
+    std::cout << "== Holding frames ==" << std::endl;
+    bench_acquire(PICAM_IMAGE_FORMAT_GRAY, 640, 480);
+    bench_acquire(PICAM_IMAGE_FORMAT_RGB, 1920, 1080);
+
+    std::cout << "== Record and replay ==" << std::endl;
+    bench_replay(PICAM_IMAGE_FORMAT_GRAY, 640, 480);
+    bench_replay(PICAM_IMAGE_FORMAT_I420, 1920, 1080);
+
+    return 0;
+}
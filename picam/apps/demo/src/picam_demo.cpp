@@ -13,19 +13,18 @@
 #include <opencv2/opencv.hpp>
 #include "jaw_queue.hpp"
 
-static Jaw::Queue<cv::Mat> frame_queue(1);
+static Jaw::Queue<picam_image_t*> frame_queue(1);
 
 static void camera_callback(void*, picam_image_t* image)
 {
-    int type = (image->format == PICAM_IMAGE_FORMAT_GRAY) ? CV_8UC1 : CV_8UC3;
-    cv::Mat frame(image->height, image->width, type, image->data);
-    cv::Mat copy;
-    if (image->format == PICAM_IMAGE_FORMAT_RGB) {
-        cv::cvtColor(frame, copy, CV_RGB2BGR);
-    } else {
-        copy = frame.clone();
+    // Keep frame without copying it, display loop releases it.
+    picam_image_t* frame = nullptr;
+    if (picam_frame_acquire(image, &frame)) {
+        return;
+    }
+    if (!frame_queue.push(frame, std::chrono::seconds(0))) {
+        picam_frame_release(frame);
     }
-    frame_queue.push(copy, std::chrono::seconds(0));
 }
 
 #else // Provide simple callback.
@@ -35,6 +34,7 @@ static void camera_callback(void*, picam_image_t* image)
     std::cout << "Got new image!" << std::endl;
     std::cout << "W : " << image->width << " H : " << image->height << " L : " << image->bytes_per_line << std::endl;
     std::cout << "Data Size : " << image->data_size << std::endl;
+    std::cout << "Sequence : " << image->sequence << " Dropped : " << image->dropped << " Lost : " << image->lost << std::endl;
     std::cout << std::endl;
 }
 
@@ -119,15 +119,31 @@ int main(int argc, char* argv[])
             picam_params_set(camera, &params);
         }
 
-        cv::Mat frame;
-        if (frame_queue.pop(frame, std::chrono::milliseconds(100))) {
-            cv::imshow("Frame", frame);
+        picam_image_t* image = nullptr;
+        if (frame_queue.pop(image, std::chrono::milliseconds(100))) {
+            int type = (image->format == PICAM_IMAGE_FORMAT_GRAY) ? CV_8UC1 : CV_8UC3;
+            cv::Mat frame(image->height, image->width, type, image->data, image->bytes_per_line);
+            if (image->format == PICAM_IMAGE_FORMAT_RGB) {
+                cv::Mat converted;
+                cv::cvtColor(frame, converted, CV_RGB2BGR);
+                cv::imshow("Frame", converted);
+            } else {
+                cv::imshow("Frame", frame);
+            }
+            picam_frame_release(image);
             frame_counter.fetch_add(1);
         }
 
     }
     frame_monitor.join();
 
+    // Frames must be released before camera is destroyed.
+    picam_callback_set(camera, nullptr, nullptr);
+    picam_image_t* image = nullptr;
+    while (frame_queue.pop(image, std::chrono::seconds(0))) {
+        picam_frame_release(image);
+    }
+
 #else
 
     // Waits for ENTER to be pressed.
@@ -20,12 +20,108 @@ int picam_destroy(picam_camera_t camera);
 // Set callback that will be called every time a new frame is availabe.
 int picam_callback_set(picam_camera_t camera, void* user_data, picam_callback_t callback);
 
+// Set callback that will receive every new frame reduced to the specified pyramid level.
+// Each level has its own callback, picam_callback_set is the same as using PICAM_LEVEL_FULL.
+// Reduced levels are computed on camera side, so only the selected resolution is transmitted.
+int picam_level_callback_set(picam_camera_t camera, picam_level_t level, void* user_data,
+                             picam_callback_t callback);
+
+// Add region that will be cropped from every new frame, replacing any region with the same name.
+// Region is relative to images delivered by picam_callback_set (after params.crop is applied).
+int picam_crop_add(picam_camera_t camera, const char* name, const picam_roi_t* roi);
+
+// Remove named region.
+int picam_crop_remove(picam_camera_t camera, const char* name);
+
+// Set callback that will receive every named region of each new frame, one call per region.
+int picam_crop_callback_set(picam_camera_t camera, void* user_data, picam_crop_callback_t callback);
+
+// Add sink receiving the same images as picam_callback_set from its own thread, storing its
+// identifier in sink. Each sink has its own rate limits and queue, so a slow sink only drops its
+// own frames. Remote version applies rate limits on camera side and queues frames on both sides.
+int picam_sink_add(picam_camera_t camera, const picam_sink_config_t* config, void* user_data,
+                   picam_callback_t callback, picam_sink_t* sink);
+
+// Remove sink, waiting for the image being delivered. Must not be called from the sink callback.
+int picam_sink_remove(picam_camera_t camera, picam_sink_t sink);
+
+// Enable motion detection with supplied configuration, or disable it when config is null.
+// Detection runs on every frame before callbacks and sinks, which can be skipped while the scene is
+// static (config suppress_static), so a remote camera doesn't publish frames nobody needs.
+int picam_motion_set(picam_camera_t camera, const picam_motion_config_t* config);
+
+// Set callback that will receive motion of every frame where it was found, and of the first frame
+// without motion after them (no regions), marking the end of the event.
+int picam_motion_callback_set(picam_camera_t camera, void* user_data, picam_motion_callback_t callback);
+
+// Enable statistics of delivered frames (histograms, mean, variance and clipping of each channel)
+// with supplied configuration, or disable them when config is null. They are computed on every
+// captured frame selected by the configuration, including frames later skipped by motion detection.
+int picam_stats_set(picam_camera_t camera, const picam_stats_config_t* config);
+
+// Set callback that will receive statistics of frames. Remote version receives only statistics,
+// so a controller driving picam_params_set doesn't need to fetch frames.
+int picam_stats_callback_set(picam_camera_t camera, void* user_data, picam_stats_callback_t callback);
+
+// Enable feature extraction with supplied configuration, or disable it when config is null.
+// Features are extracted from every captured frame while a callback is set, splitting it in stripes
+// processed by several threads, before motion detection can skip it.
+int picam_features_set(picam_camera_t camera, const picam_features_config_t* config);
+
+// Set callback that will receive features of frames. Remote version receives only the keypoints
+// (and descriptors), so visual odometry doesn't need to fetch frames.
+int picam_features_callback_set(picam_camera_t camera, void* user_data, picam_features_callback_t callback);
+
+// Keep image received by a callback alive after it returns, storing in frame an image with the
+// same content valid until picam_frame_release. Camera, sink and raw remote buffers are shared
+// without copying, other images (pyramid levels, regions, decoded frames) are copied.
+// Camera drops frames while all its buffers are held, so release them as soon as possible and
+// always before the camera (or sink) is destroyed.
+int picam_frame_acquire(const picam_image_t* image, picam_image_t** frame);
+
+// Release image obtained by picam_frame_acquire.
+int picam_frame_release(picam_image_t* frame);
+
+// Create recorder appending every image passed to picam_recorder_callback to a new file at path.
+// File is written through a memory mapping and indexed when the recorder is destroyed. To record
+// a camera, add a sink with the recorder as user data:
+//   picam_sink_add(camera, &config, recorder, picam_recorder_callback, &sink);
+// Local version replays it with PICAM_BACKEND_REPLAY when PICAM_REPLAY names the file, following
+// the recorded timestamps, or as fast as possible if config framerate is zero.
+int picam_recorder_create(picam_recorder_t* recorder, const char* path);
+
+// Write index and close recording. Sinks writing to it must be removed first.
+int picam_recorder_destroy(picam_recorder_t recorder);
+
+// Sink callback appending image to the recorder passed as user data.
+void picam_recorder_callback(void* recorder, picam_image_t* image);
+
+// Select format of delivered images, default is the format used on creation.
+// Images are converted once per frame before reaching any callback. Remote version converts them
+// on camera side, so they are transmitted in the selected format. Planar formats (I420, NV12) need
+// even width and height, otherwise an invalid argument error is returned.
+int picam_format_set(picam_camera_t camera, picam_image_format_t format);
+
 // Get the current parameters used by camera.
 int picam_params_get(picam_camera_t camera, picam_params_t* params);
 
 // Update camera parameters to new value.
 int picam_params_set(picam_camera_t camera, picam_params_t* params);
 
+// Select how images are encoded for transmission. Default is PICAM_ENCODING_RAW.
+// Images are always decoded before reaching the callback. Local version ignores encoding.
+// With PICAM_ENCODING_DELTA frames received after a lost message are skipped until next keyframe.
+int picam_encoding_set(picam_camera_t camera, picam_encoding_t encoding);
+
+// Switch callback delivery to manual drive mode, obtaining a descriptor for an external event loop.
+// No background thread is used: when fd becomes readable, call picam_process_events to run the
+// pending callbacks on the caller thread. The descriptor is edge-triggered, so always drain it.
+// Must be called before picam_callback_set. Only supported by remote version.
+int picam_events_fd_get(picam_camera_t camera, int* fd);
+
+// Run all pending callbacks on the calling thread. Only valid after picam_events_fd_get.
+int picam_process_events(picam_camera_t camera);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,8 @@
 #ifndef PICAM_DEFINES_H
 #define PICAM_DEFINES_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -8,30 +10,116 @@ extern "C" {
 // Define opaque picam camera handle.
 typedef void* picam_camera_t;
 
+// Define opaque picam recorder handle.
+typedef void* picam_recorder_t;
+
 // Image formats
 typedef enum {
 
     PICAM_IMAGE_FORMAT_GRAY,
     PICAM_IMAGE_FORMAT_BGR,
     PICAM_IMAGE_FORMAT_RGB,
+    PICAM_IMAGE_FORMAT_I420,    // YUV 4:2:0, Y plane followed by U and V planes.
+    PICAM_IMAGE_FORMAT_NV12,    // YUV 4:2:0, Y plane followed by interleaved UV plane.
 
 } picam_image_format_t;
 
+// Encodings used to transmit images from server to client.
+typedef enum {
+
+    PICAM_ENCODING_RAW,     // Uncompressed pixels.
+    PICAM_ENCODING_QOI,     // Lossless fast compression (QOI-like).
+    PICAM_ENCODING_DELTA,   // Only tiles that changed since previous frame, with periodic keyframes.
+
+} picam_encoding_t;
+
+// Levels of the image pyramid, each one with half the width and height of the previous.
+typedef enum {
+
+    PICAM_LEVEL_FULL,       // Captured image.
+    PICAM_LEVEL_HALF,       // 1/2 of captured resolution.
+    PICAM_LEVEL_QUARTER,    // 1/4 of captured resolution.
+    PICAM_LEVEL_EIGHTH,     // 1/8 of captured resolution.
+    PICAM_LEVEL_COUNT,
+
+} picam_level_t;
+
+// Policies used when frames are produced faster than they can be delivered.
+typedef enum {
+
+    PICAM_DELIVERY_NEWEST,      // Skip waiting frames and deliver only the newest one.
+    PICAM_DELIVERY_QUEUE,       // Deliver every waiting frame in order.
+
+} picam_delivery_t;
+
+// Location of an image plane inside image data.
+typedef struct {
+
+    unsigned int offset;            // Position of the first line of the plane, in bytes from data.
+    unsigned int bytes_per_line;    // Distance between lines of the plane.
+
+} picam_plane_t;
+
+// Maximum number of planes of an image.
+#define PICAM_MAX_PLANES 3
+
+// Patterns produced by the synthetic camera.
+// Each frame carries its sequence number and capture time (steady clock, in nanoseconds) as two
+// native endian uint64 values at the beginning of the first line, if it is wide enough.
+typedef enum {
+
+    PICAM_PATTERN_GRADIENT,     // Stripes (GRAY) or hue gradient (color) moving horizontally.
+    PICAM_PATTERN_NOISE,        // Random pixels changing every frame.
+    PICAM_PATTERN_BOX,          // White box bouncing over a dark background.
+
+} picam_pattern_t;
+
+// Sources of frames of a local camera. Every backend is built in, except MMAL that is only
+// available when building for the Raspberry Pi.
+typedef enum {
+
+    PICAM_BACKEND_DEFAULT,      // Named by PICAM_BACKEND variable (mmal, synthetic or replay) if set,
+                                // replay if PICAM_REPLAY is set, otherwise MMAL or synthetic.
+    PICAM_BACKEND_MMAL,         // Raspberry Pi camera.
+    PICAM_BACKEND_SYNTHETIC,    // Generated pattern (see picam_pattern_t).
+    PICAM_BACKEND_REPLAY,       // Recording named by PICAM_REPLAY variable (see picam_recorder_create).
+
+} picam_backend_t;
+
 // Image structure.
 typedef struct {
 
     picam_image_format_t format;
     unsigned int width;
     unsigned int height;
-    unsigned int bytes_per_line;
+    unsigned int bytes_per_line;    // Distance between lines of the first (or only) plane.
     unsigned int data_size;
     unsigned char* data;
 
+    // Planes of the image: 1 for GRAY, RGB and BGR, 3 for I420 (Y, U, V) and 2 for NV12 (Y, UV).
+    // Chroma planes have half the width and height of the image.
+    // If num_planes is zero the planes are assumed to follow each other without gaps, chroma
+    // strides being derived from bytes_per_line (half of it for I420, the same for NV12).
+    unsigned int num_planes;
+    picam_plane_t planes[PICAM_MAX_PLANES];
+
+    // Frame metadata. New fields are only appended so images keep the layout of older versions.
+    uint64_t timestamp;     // Capture time in nanoseconds from a monotonic clock (steady clock).
+    uint64_t sequence;      // Number of the frame since capture started, skipped values were dropped.
+    uint32_t dropped;       // Frames dropped by the camera since capture started (slow consumers).
+    uint32_t lost;          // Frames lost between server and client since subscription (remote only).
+
+    // Buffer holding data, kept alive by picam_frame_acquire. Null if data has to be copied.
+    void* buffer;
+
 } picam_image_t;
 
 // Callback used to receive frames from camera.
 typedef void (*picam_callback_t)(void*, picam_image_t*);
 
+// Callback used to receive named regions cropped from frames.
+typedef void (*picam_crop_callback_t)(void*, const char*, picam_image_t*);
+
 // Represent a Region of Interest that should be normalized between [0.0, 1.0].
 typedef struct {
 
@@ -65,10 +153,132 @@ typedef struct {
     picam_image_format_t format;
     unsigned int width;
     unsigned int height;
-    double framerate;
+    double framerate;               // Synthetic and replay cameras run as fast as possible when zero.
+    picam_pattern_t pattern;        // Only used by the synthetic camera.
+    unsigned int queue_depth;       // Frames that can wait for delivery, default (2) when zero.
+    picam_delivery_t delivery;      // Frames discarded when delivery is late (newest or queue).
+    picam_backend_t backend;        // Source of frames, selected when camera is created.
 
 } picam_config_t;
 
+// Identifier of a sink added to a camera.
+typedef int picam_sink_t;
+
+// Configuration of a sink, frames skipped by the rate limits are reported as dropped.
+typedef struct {
+
+    unsigned int decimation;        // Deliver one of every decimation frames, all when zero.
+    double max_fps;                 // Maximum delivery rate, unlimited when zero.
+    unsigned int queue_depth;       // Frames that can wait for delivery, default (2) when zero.
+    picam_delivery_t delivery;      // Frames discarded when delivery is late (newest or queue).
+
+} picam_sink_config_t;
+
+// Configuration of motion detection. Frames are compared to a background that follows slow changes
+// (lighting), using the luma reduced to at most 320 pixels wide, split in blocks of 8x8 pixels.
+typedef struct {
+
+    unsigned int threshold;         // Mean difference (0 - 255) of a changed block, default (12) when zero.
+    float min_area;                 // Smallest region reported, as a fraction of the frame (0.0 - 1.0).
+    int suppress_static;            // Don't deliver frames without motion to callbacks and sinks.
+    unsigned int hold;              // Frames still delivered after motion stops when suppressing.
+
+} picam_motion_config_t;
+
+// Maximum number of regions reported for each frame.
+#define PICAM_MAX_MOTION_REGIONS 8
+
+// Motion found on a frame.
+typedef struct {
+
+    uint64_t timestamp;             // Timestamp of the analysed frame.
+    uint64_t sequence;              // Sequence number of the analysed frame.
+    float changed;                  // Fraction of the frame that differs from the background.
+    unsigned int num_regions;       // Regions larger than min_area, largest first. Zero without motion.
+    picam_roi_t regions[PICAM_MAX_MOTION_REGIONS];  // Bounding boxes, normalized as picam_roi_t.
+
+} picam_motion_t;
+
+// Callback used to receive motion events.
+typedef void (*picam_motion_callback_t)(void*, const picam_motion_t*);
+
+// Configuration of frame statistics, computed on delivered frames before motion detection.
+typedef struct {
+
+    unsigned int decimation;        // Compute them on one of every decimation frames, all when zero.
+    unsigned int step;              // Count one of every step pixels and lines, all when zero.
+
+} picam_stats_config_t;
+
+// Maximum number of channels of an image.
+#define PICAM_MAX_CHANNELS 3
+
+// Statistics of one channel of a frame.
+typedef struct {
+
+    uint32_t histogram[256];        // Number of pixels counted with each value.
+    float mean;                     // Mean value (0 - 255).
+    float variance;                 // Variance of the values.
+    float clipped_low;              // Percentage (0 - 100) of pixels at 0.
+    float clipped_high;             // Percentage (0 - 100) of pixels at 255.
+
+} picam_channel_stats_t;
+
+// Statistics of a frame. Channels follow the frame format: one for gray, colors in memory order
+// for BGR and RGB, and Y, U, V for I420 and NV12 (chroma at its reduced resolution).
+typedef struct {
+
+    uint64_t timestamp;             // Timestamp of the analysed frame.
+    uint64_t sequence;              // Sequence number of the analysed frame.
+    picam_image_format_t format;    // Format of the analysed frame.
+    float luma;                     // Mean luma (0 - 255), using BT.601 weights for BGR and RGB.
+    unsigned int num_channels;      // Channels in use.
+    picam_channel_stats_t channels[PICAM_MAX_CHANNELS];
+
+} picam_stats_t;
+
+// Callback used to receive frame statistics.
+typedef void (*picam_stats_callback_t)(void*, const picam_stats_t*);
+
+// Configuration of feature extraction, finding FAST-9 corners on the luma of delivered frames.
+typedef struct {
+
+    unsigned int threshold;         // Difference (1 - 255) between a corner and its circle, default (20) when zero.
+    unsigned int max_features;      // Strongest corners reported, all of them when zero.
+    int descriptors;                // Report the patch of pixels around each corner.
+    unsigned int threads;           // Stripes of the frame processed in parallel, one per core when zero.
+
+} picam_features_config_t;
+
+// Side of the patches used as descriptors.
+#define PICAM_PATCH_SIZE 8
+
+// Corner found on a frame, in pixels of the analysed frame.
+typedef struct {
+
+    uint16_t x;
+    uint16_t y;
+    uint16_t score;                 // Sum of the differences beyond threshold, larger for stronger corners.
+
+} picam_keypoint_t;
+
+// Features found on a frame. Lists are only valid during the callback.
+typedef struct {
+
+    uint64_t timestamp;             // Timestamp of the analysed frame.
+    uint64_t sequence;              // Sequence number of the analysed frame.
+    unsigned int width;             // Dimensions of the analysed frame.
+    unsigned int height;
+    unsigned int num_keypoints;
+    const picam_keypoint_t* keypoints;  // Corners, strongest first.
+    const uint8_t* descriptors;     // Luma of PICAM_PATCH_SIZE x PICAM_PATCH_SIZE pixels for each corner,
+                                    // starting at (x - 4, y - 4). Null when disabled.
+
+} picam_features_t;
+
+// Callback used to receive features.
+typedef void (*picam_features_callback_t)(void*, const picam_features_t*);
+
 #ifdef __cplusplus
 }
 #endif
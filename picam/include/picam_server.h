@@ -18,6 +18,17 @@ int picam_server_start(picam_server_t* server, const char* address);
 // Stop server
 int picam_server_stop(picam_server_t server);
 
+// Start server in manual drive mode. No background thread is launched.
+// Requests are only processed when picam_server_process_events is called.
+int picam_server_start_manual(picam_server_t* server, const char* address);
+
+// Get descriptor that signals pending requests for a server started in manual drive mode.
+// The descriptor is edge-triggered: once readable, call picam_server_process_events to drain it.
+int picam_server_events_fd_get(picam_server_t server, int* fd);
+
+// Process all pending requests on the calling thread.
+int picam_server_process_events(picam_server_t server);
+
 #ifdef __cplusplus
 }
 #endif
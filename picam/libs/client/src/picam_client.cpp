@@ -1,7 +1,14 @@
 #include "picam_api.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
 #include "jaw_client.hpp"
 #include "picam_protocol.hpp"
+#include "picam_sink.hpp"
+#include "picam_frame.hpp"
 
 using namespace Jaw;
 using namespace PiCam;
@@ -17,6 +24,64 @@ static std::chrono::seconds kTimeout = std::chrono::seconds(3);
 
 /*************************************************************************************************/
 
+// Buffer keeping a message alive while raw images pointing inside it are acquired.
+class MessageBuffer : public FrameBuffer
+{
+public:
+    MessageBuffer(InputBuffer message)
+        : message_(std::move(message))
+    {}
+
+protected:
+    void recycle() override
+    {
+        delete this;
+    }
+
+private:
+    InputBuffer message_;
+};
+
+// Call deliver with image read from message. Raw images are handed to a MessageBuffer, so they
+// can be acquired without copying, while decoded ones point to storage reused by the decoder.
+template<class Deliver>
+static void deliver_image(InputBuffer& message, picam_image_t& image, const FrameDecoder& decoder, Deliver deliver)
+{
+    if (decoder.encoding != PICAM_ENCODING_RAW) {
+        deliver(image);
+        return;
+    }
+
+    MessageBuffer* buffer = new MessageBuffer(std::move(message));
+    image.buffer = buffer;
+    buffer->acquire();
+    deliver(image);
+    buffer->release();
+}
+
+/*************************************************************************************************/
+
+// Sink of a remote camera. Rate limits are applied by the server, frames are decoded by the
+// callback monitor and handed to a local sink so each one is delivered from its own thread.
+struct RemoteSink
+{
+    FrameDecoder decoder;
+    std::unique_ptr<Sink> sink;
+};
+
+// Sinks of a remote camera indexed by the identifier assigned by the server.
+struct RemoteSinks
+{
+    std::mutex mutex;
+    std::map<picam_sink_t, std::unique_ptr<RemoteSink>> sinks;
+};
+
+// Sinks of every remote camera, created when its first sink is added.
+static std::mutex sinks_mutex;
+static std::map<picam_camera_t, std::shared_ptr<RemoteSinks>> camera_sinks;
+
+/*************************************************************************************************/
+
 int picam_create(picam_camera_t* camera, const picam_config_t* config, const char* address)
 {
     if (!config) {
@@ -30,23 +95,303 @@ int picam_create(picam_camera_t* camera, const picam_config_t* config, const cha
 
 int picam_destroy(picam_camera_t camera)
 {
-    return PiCamClient::destroy(camera, Command::DESTROY, kTimeout);
+    int error = PiCamClient::destroy(camera, Command::DESTROY, kTimeout);
+
+    // Callback monitor is gone, so sinks won't receive frames anymore.
+    std::shared_ptr<RemoteSinks> sinks;
+    {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        auto it = camera_sinks.find(camera);
+        if (it != camera_sinks.end()) {
+            sinks = it->second;
+            camera_sinks.erase(it);
+        }
+    }
+    return error;
 }
 
 /*************************************************************************************************/
 
 int picam_callback_set(picam_camera_t camera, void *user_data, picam_callback_t callback)
 {
-    return PiCamClient::set_callback(camera, Command::CALLBACK_SET, kTimeout,
-        [user_data, callback](InputBuffer message) {
+    return picam_level_callback_set(camera, PICAM_LEVEL_FULL, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+int picam_level_callback_set(picam_camera_t camera, picam_level_t level, void* user_data,
+                             picam_callback_t callback)
+{
+    if (level < PICAM_LEVEL_FULL || level >= PICAM_LEVEL_COUNT) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+
+    if (!callback) {
+        return PiCamClient::set_callback(camera, level_command(level), kTimeout, nullptr);
+    }
+
+    // Decoder state (storage and reconstructed frame), reused between frames.
+    auto decoder = std::make_shared<FrameDecoder>();
+
+    return PiCamClient::set_callback(camera, level_command(level), kTimeout,
+        [user_data, callback, decoder](InputBuffer message) {
+            picam_image_t image;
+            if (read_encoded(message, image, *decoder)) {
+                deliver_image(message, image, *decoder, [user_data, callback](picam_image_t& image) {
+                    callback(user_data, &image);
+                });
+            }
+        });
+}
+
+/*************************************************************************************************/
+
+int picam_crop_add(picam_camera_t camera, const char* name, const picam_roi_t* roi)
+{
+    if (!name || !roi) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return PiCamClient::request(camera, Command::CROP_ADD, kTimeout, std::forward_as_tuple(std::string(name), *roi));
+}
+
+/*************************************************************************************************/
+
+int picam_crop_remove(picam_camera_t camera, const char* name)
+{
+    if (!name) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return PiCamClient::request(camera, Command::CROP_REMOVE, kTimeout, std::forward_as_tuple(std::string(name)));
+}
+
+/*************************************************************************************************/
+
+int picam_crop_callback_set(picam_camera_t camera, void* user_data, picam_crop_callback_t callback)
+{
+    if (!callback) {
+        return PiCamClient::set_callback(camera, Command::CROP_CALLBACK_SET, kTimeout, nullptr);
+    }
+
+    // Each region is an independent stream, so it needs its own decoder.
+    auto decoders = std::make_shared<std::map<std::string, FrameDecoder>>();
+
+    return PiCamClient::set_callback(camera, Command::CROP_CALLBACK_SET, kTimeout,
+        [user_data, callback, decoders](InputBuffer message) {
+            std::string name;
             picam_image_t image;
-            read(message, image);
-            callback(user_data, &image);
+            read(message, name);
+            FrameDecoder& decoder = (*decoders)[name];
+            if (read_encoded(message, image, decoder)) {
+                deliver_image(message, image, decoder, [user_data, callback, &name](picam_image_t& image) {
+                    callback(user_data, name.c_str(), &image);
+                });
+            }
         });
 }
 
 /*************************************************************************************************/
 
+int picam_sink_add(picam_camera_t camera, const picam_sink_config_t* config, void* user_data,
+                   picam_callback_t callback, picam_sink_t* sink)
+{
+    if (!config || !callback || !sink) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+
+    // Frames already passed server rate limits, only queue them locally.
+    picam_sink_config_t local = *config;
+    local.decimation = 0;
+    local.max_fps = 0.0;
+
+    std::unique_ptr<RemoteSink> remote(new RemoteSink());
+    int error = protected_call([&remote, &local, &user_data, &callback]() {
+        remote->sink.reset(new Sink(local, user_data, callback));
+        return 0;
+    });
+    if (error) {
+        return error;
+    }
+
+    // All sinks of a camera share the same callback, routing frames by identifier.
+    std::shared_ptr<RemoteSinks> sinks;
+    {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        std::shared_ptr<RemoteSinks>& entry = camera_sinks[camera];
+        if (!entry) {
+            entry = std::make_shared<RemoteSinks>();
+            error = PiCamClient::set_callback(camera, Command::SINK_CALLBACK_SET, kTimeout,
+                [sinks = entry](InputBuffer message) {
+                    picam_sink_t sink;
+                    read(message, sink);
+
+                    std::lock_guard<std::mutex> lock(sinks->mutex);
+                    auto it = sinks->sinks.find(sink);
+                    if (it == sinks->sinks.end()) {
+                        return;
+                    }
+                    picam_image_t image;
+                    if (read_encoded(message, image, it->second->decoder)) {
+                        it->second->sink->offer(image);
+                    }
+                });
+            if (error) {
+                camera_sinks.erase(camera);
+                return error;
+            }
+        }
+        sinks = entry;
+    }
+
+    // Register sink locally before the server starts publishing its frames.
+    std::lock_guard<std::mutex> lock(sinks->mutex);
+    error = PiCamClient::request(camera, Command::SINK_ADD, kTimeout, std::forward_as_tuple(*config), *sink);
+    if (!error) {
+        sinks->sinks[*sink] = std::move(remote);
+    }
+    return error;
+}
+
+/*************************************************************************************************/
+
+int picam_sink_remove(picam_camera_t camera, picam_sink_t sink)
+{
+    int error = PiCamClient::request(camera, Command::SINK_REMOVE, kTimeout, std::forward_as_tuple(sink));
+    if (error) {
+        return error;
+    }
+
+    std::shared_ptr<RemoteSinks> sinks;
+    {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        auto it = camera_sinks.find(camera);
+        if (it != camera_sinks.end()) {
+            sinks = it->second;
+        }
+    }
+
+    // Local sink is destroyed outside the lock, so other sinks keep receiving frames meanwhile.
+    std::unique_ptr<RemoteSink> remote;
+    if (sinks) {
+        std::lock_guard<std::mutex> lock(sinks->mutex);
+        auto it = sinks->sinks.find(sink);
+        if (it != sinks->sinks.end()) {
+            remote = std::move(it->second);
+            sinks->sinks.erase(it);
+        }
+    }
+    return 0;
+}
+
+/*************************************************************************************************/
+
+int picam_motion_set(picam_camera_t camera, const picam_motion_config_t* config)
+{
+    const picam_motion_config_t disabled = {};
+    return PiCamClient::request(camera, Command::MOTION_SET, kTimeout,
+                                std::forward_as_tuple(config != nullptr, config ? *config : disabled));
+}
+
+/*************************************************************************************************/
+
+int picam_motion_callback_set(picam_camera_t camera, void* user_data, picam_motion_callback_t callback)
+{
+    if (!callback) {
+        return PiCamClient::set_callback(camera, Command::MOTION_CALLBACK_SET, kTimeout, nullptr);
+    }
+
+    return PiCamClient::set_callback(camera, Command::MOTION_CALLBACK_SET, kTimeout,
+        [user_data, callback](InputBuffer message) {
+            picam_motion_t motion = {};
+            read(message, motion);
+            callback(user_data, &motion);
+        });
+}
+
+/*************************************************************************************************/
+
+int picam_stats_set(picam_camera_t camera, const picam_stats_config_t* config)
+{
+    const picam_stats_config_t disabled = {};
+    return PiCamClient::request(camera, Command::STATS_SET, kTimeout,
+                                std::forward_as_tuple(config != nullptr, config ? *config : disabled));
+}
+
+/*************************************************************************************************/
+
+int picam_stats_callback_set(picam_camera_t camera, void* user_data, picam_stats_callback_t callback)
+{
+    if (!callback) {
+        return PiCamClient::set_callback(camera, Command::STATS_CALLBACK_SET, kTimeout, nullptr);
+    }
+
+    return PiCamClient::set_callback(camera, Command::STATS_CALLBACK_SET, kTimeout,
+        [user_data, callback](InputBuffer message) {
+            picam_stats_t stats = {};
+            read(message, stats);
+            callback(user_data, &stats);
+        });
+}
+
+/*************************************************************************************************/
+
+int picam_features_set(picam_camera_t camera, const picam_features_config_t* config)
+{
+    const picam_features_config_t disabled = {};
+    return PiCamClient::request(camera, Command::FEATURES_SET, kTimeout,
+                                std::forward_as_tuple(config != nullptr, config ? *config : disabled));
+}
+
+/*************************************************************************************************/
+
+int picam_features_callback_set(picam_camera_t camera, void* user_data, picam_features_callback_t callback)
+{
+    if (!callback) {
+        return PiCamClient::set_callback(camera, Command::FEATURES_CALLBACK_SET, kTimeout, nullptr);
+    }
+
+    return PiCamClient::set_callback(camera, Command::FEATURES_CALLBACK_SET, kTimeout,
+        [user_data, callback](InputBuffer message) {
+            picam_features_t features = {};
+            read(message, features);
+            callback(user_data, &features);
+        });
+}
+
+/*************************************************************************************************/
+
+int picam_frame_acquire(const picam_image_t* image, picam_image_t** frame)
+{
+    if (!image || !frame) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return protected_call([&image, &frame]() {
+        *frame = acquire_frame(*image);
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+int picam_frame_release(picam_image_t* frame)
+{
+    if (!frame) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return protected_call([&frame]() {
+        release_frame(frame);
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+int picam_format_set(picam_camera_t camera, picam_image_format_t format)
+{
+    return PiCamClient::request(camera, Command::FORMAT_SET, kTimeout, std::forward_as_tuple(format));
+}
+
+/*************************************************************************************************/
+
 int picam_params_get(picam_camera_t camera, picam_params_t *params)
 {
     if (!params) {
@@ -66,3 +411,24 @@ int picam_params_set(picam_camera_t camera, picam_params_t* params)
 }
 
 /*************************************************************************************************/
+
+int picam_encoding_set(picam_camera_t camera, picam_encoding_t encoding)
+{
+    return PiCamClient::request(camera, Command::ENCODING_SET, kTimeout, std::forward_as_tuple(encoding));
+}
+
+/*************************************************************************************************/
+
+int picam_events_fd_get(picam_camera_t camera, int* fd)
+{
+    return PiCamClient::events_fd(camera, fd);
+}
+
+/*************************************************************************************************/
+
+int picam_process_events(picam_camera_t camera)
+{
+    return PiCamClient::process_events(camera);
+}
+
+/*************************************************************************************************/
@@ -3,9 +3,18 @@
 
 #include "picam_defines.h"
 #include <memory>
+#include <string>
 
 namespace PiCam {
 
+class Pyramid;
+class Cropper;
+class Converter;
+class Sinks;
+class MotionDetector;
+class FrameStats;
+class FeatureExtractor;
+
 /*************************************************************************************************/
 
 // Access camera connected to Neato Robot.
@@ -22,15 +31,71 @@ public:
     // Set callback that will be called every time a new frame is availabe.
     void set_callback(void* user_data, picam_callback_t callback);
 
+    // Set callback that will receive new frames reduced to specified pyramid level.
+    void set_level_callback(picam_level_t level, void* user_data, picam_callback_t callback);
+
+    // Add named region cropped from every frame, replacing any region with the same name.
+    void add_crop(const std::string& name, const picam_roi_t& roi);
+
+    // Remove named region.
+    void remove_crop(const std::string& name);
+
+    // Set callback that will receive named regions.
+    void set_crop_callback(void* user_data, picam_crop_callback_t callback);
+
+    // Add sink receiving delivered frames from its own thread, returning its identifier.
+    picam_sink_t add_sink(const picam_sink_config_t& config, void* user_data, picam_callback_t callback);
+
+    // Remove sink waiting for the frame being delivered.
+    void remove_sink(picam_sink_t sink);
+
+    // Enable motion detection with supplied configuration, disabling it when null.
+    void set_motion(const picam_motion_config_t* config);
+
+    // Set callback that will receive motion events.
+    void set_motion_callback(void* user_data, picam_motion_callback_t callback);
+
+    // Enable frame statistics with supplied configuration, disabling them when null.
+    void set_stats(const picam_stats_config_t* config);
+
+    // Set callback that will receive frame statistics.
+    void set_stats_callback(void* user_data, picam_stats_callback_t callback);
+
+    // Enable feature extraction with supplied configuration, disabling it when null.
+    void set_features(const picam_features_config_t* config);
+
+    // Set callback that will receive features.
+    void set_features_callback(void* user_data, picam_features_callback_t callback);
+
+    // Set format of delivered frames, converting them if needed.
+    void set_format(picam_image_format_t format);
+
     // Get current parameters.
     const picam_params_t& parameters();
 
     // Update parameters to new value.
     void set_parameters(const picam_params_t& params);
 
+    // Backend capturing the frames, selected when camera is constructed.
+    class Impl;
+
 private:
+    // Receive frames from implementation forwarding them to processing stages.
+    static void frame_callback(void* user_data, picam_image_t* image);
+
+    // Processing stages applied to captured frames.
+    std::unique_ptr<Cropper> cropper_;
+    std::unique_ptr<Converter> converter_;
+    std::unique_ptr<FrameStats> stats_;
+    std::unique_ptr<FeatureExtractor> features_;
+    std::unique_ptr<MotionDetector> motion_;
+    std::unique_ptr<Pyramid> pyramid_;
+    std::unique_ptr<Sinks> sinks_;
+
+    // Parameters reported to the user.
+    picam_params_t params_;
+
     // Hides class implementation
-    class Impl;
     std::unique_ptr<Impl> pimpl_;
 };
 
@@ -1,5 +1,14 @@
 #include "picam_camera.hpp"
 #include "picam_camera_impl.hpp"
+#include "picam_pyramid.hpp"
+#include "picam_crop.hpp"
+#include "picam_converter.hpp"
+#include "picam_sinks.hpp"
+#include "picam_motion.hpp"
+#include "picam_stats.hpp"
+#include "picam_features.hpp"
+
+#include "jaw_exception.hpp"
 
 #include <iostream>
 
@@ -8,8 +17,17 @@ namespace PiCam {
 /*************************************************************************************************/
 
 Camera::Camera(const picam_config_t& config)
-    : pimpl_(std::make_unique<Camera::Impl>(config))
+    : cropper_(std::make_unique<Cropper>())
+    , converter_(std::make_unique<Converter>(config))
+    , stats_(std::make_unique<FrameStats>())
+    , features_(std::make_unique<FeatureExtractor>())
+    , motion_(std::make_unique<MotionDetector>())
+    , pyramid_(std::make_unique<Pyramid>())
+    , sinks_(std::make_unique<Sinks>())
+    , params_()
+    , pimpl_(Camera::Impl::create(config))
 {
+    pimpl_->set_callback(this, &Camera::frame_callback);
     std::cout << "Created Camera" << std::endl;
 }
 
@@ -25,21 +43,139 @@ Camera::~Camera()
 
 void Camera::set_callback(void* user_data, picam_callback_t callback)
 {
-    pimpl_->set_callback(user_data, callback);
+    pyramid_->set_callback(PICAM_LEVEL_FULL, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_level_callback(picam_level_t level, void* user_data, picam_callback_t callback)
+{
+    pyramid_->set_callback(level, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+void Camera::add_crop(const std::string& name, const picam_roi_t& roi)
+{
+    cropper_->add(name, roi);
+}
+
+/*************************************************************************************************/
+
+void Camera::remove_crop(const std::string& name)
+{
+    cropper_->remove(name);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_crop_callback(void* user_data, picam_crop_callback_t callback)
+{
+    cropper_->set_callback(user_data, callback);
+}
+
+/*************************************************************************************************/
+
+picam_sink_t Camera::add_sink(const picam_sink_config_t& config, void* user_data, picam_callback_t callback)
+{
+    return sinks_->add(config, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+void Camera::remove_sink(picam_sink_t sink)
+{
+    sinks_->remove(sink);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_motion(const picam_motion_config_t* config)
+{
+    motion_->set_config(config);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_motion_callback(void* user_data, picam_motion_callback_t callback)
+{
+    motion_->set_callback(user_data, callback);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_stats(const picam_stats_config_t* config)
+{
+    stats_->set_config(config);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_stats_callback(void* user_data, picam_stats_callback_t callback)
+{
+    stats_->set_callback(user_data, callback);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_features(const picam_features_config_t* config)
+{
+    features_->set_config(config);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_features_callback(void* user_data, picam_features_callback_t callback)
+{
+    features_->set_callback(user_data, callback);
+}
+
+/*************************************************************************************************/
+
+void Camera::set_format(picam_image_format_t format)
+{
+    converter_->set_format(format);
 }
 
 /*************************************************************************************************/
 
 const picam_params_t& Camera::parameters()
 {
-    return pimpl_->parameters();
+    // Crop is applied after capture, so implementation is not aware of it.
+    params_ = pimpl_->parameters();
+    params_.crop = cropper_->main_region();
+    return params_;
 }
 
 /*************************************************************************************************/
 
 void Camera::set_parameters(const picam_params_t& params)
 {
+    if (!Cropper::valid(params.crop)) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid crop region");
+    }
     pimpl_->set_parameters(params);
+    cropper_->set_main_region(params.crop);
+}
+
+/*************************************************************************************************/
+
+void Camera::frame_callback(void* user_data, picam_image_t* image)
+{
+    Camera* camera = static_cast<Camera*>(user_data);
+    image = camera->cropper_->apply_main_region(image, camera->converter_->format());
+    image = camera->converter_->process(image);
+    if (!image) {
+        return;
+    }
+    camera->stats_->process(image);
+    camera->features_->process(image);
+    if (!camera->motion_->process(image)) {
+        return;
+    }
+    camera->pyramid_->process(image);
+    camera->sinks_->process(image);
+    camera->cropper_->process(image);
 }
 
 /*************************************************************************************************/
@@ -1,4 +1,7 @@
 #include "picam_camera_dummy.hpp"
+#include "picam_pipeline.hpp"
+#include "picam_frame.hpp"
+#include "picam_imgproc.hpp"
 
 #include <vector>
 #include <algorithm>
@@ -11,14 +14,14 @@ namespace PiCam {
 
 /*************************************************************************************************/
 
-Camera::Impl::Impl(const picam_config_t& config)
+DummyCamera::DummyCamera(const picam_config_t& config)
     : config_(config)
     , params_()
     , user_data_(nullptr)
     , user_callback_(nullptr)
     , user_mutex_()
     , keep_running_(true)
-    , main_thread_(&Impl::main_loop, this)
+    , main_thread_(&DummyCamera::main_loop, this)
 {
     params_.sharpness = 0;
     params_.contrast = 0;
@@ -31,7 +34,7 @@ Camera::Impl::Impl(const picam_config_t& config)
 
 /*************************************************************************************************/
 
-Camera::Impl::~Impl()
+DummyCamera::~DummyCamera()
 {
     keep_running_ = false;
     main_thread_.join();
@@ -39,7 +42,7 @@ Camera::Impl::~Impl()
 
 /*************************************************************************************************/
 
-void Camera::Impl::set_callback(void* user_data, picam_callback_t callback)
+void DummyCamera::set_callback(void* user_data, picam_callback_t callback)
 {
     std::lock_guard<std::mutex> lock(user_mutex_);
     user_data_ = user_data;
@@ -48,129 +51,339 @@ void Camera::Impl::set_callback(void* user_data, picam_callback_t callback)
 
 /*************************************************************************************************/
 
-const picam_params_t& Camera::Impl::parameters()
+const picam_params_t& DummyCamera::parameters()
 {
     return params_;
 }
 
 /*************************************************************************************************/
 
-void Camera::Impl::set_parameters(const picam_params_t& params)
+void DummyCamera::set_parameters(const picam_params_t& params)
 {
     params_ = params;
 }
 
 /*************************************************************************************************/
 
-void Camera::Impl::main_loop()
+// Size in bytes of the stamp written at the beginning of each frame.
+static const unsigned int kStampSize = 2 * sizeof(std::uint64_t);
+
+/*************************************************************************************************/
+
+// Allocate buffer for a frame of supplied layout without padding.
+static picam_image_t allocate(picam_image_format_t format, unsigned int width, unsigned int height,
+                              std::vector<unsigned char>& buffer)
 {
-    using namespace std::chrono;
+    picam_image_t image = {};
+    image.format = format;
+    image.width = width;
+    image.height = height;
+    image.bytes_per_line = width * bytes_per_pixel(format);
+    image.data_size = image_size(format, width, height);
+    buffer.resize(image.data_size);
+    image.data = buffer.data();
+    set_planes(image);
+    return image;
+}
 
-    // Create image that will be randonly filled.
-    picam_image_t image;
-    image.format = config_.format;
-    image.width = config_.width;
-    image.height = config_.height;
+/*************************************************************************************************/
 
-    std::vector<unsigned char> buffer;
+// Replace RGB image by the same image converted to the configured planar format.
+static picam_image_t to_planar(const picam_image_t& rgb, picam_image_format_t format,
+                               std::vector<unsigned char>& buffer)
+{
+    std::vector<unsigned char> planar;
+    picam_image_t image = allocate(format, rgb.width, rgb.height, planar);
+    if (!convert(rgb, format, image)) {
+        std::cout << "Invalid image size for YUV format..." << std::endl;
+        return rgb;
+    }
+    buffer.swap(planar);
+    return image;
+}
+
+/*************************************************************************************************/
 
-    switch (config_.format) {
-        case PICAM_IMAGE_FORMAT_GRAY: {
-            buffer.resize(image.width * image.height);
-            image.bytes_per_line = image.width;
+// Create frame with vertical stripes (GRAY) or a hue gradient (color formats).
+static picam_image_t make_gradient(const picam_config_t& config, std::vector<unsigned char>& buffer)
+{
+    if (config.format == PICAM_IMAGE_FORMAT_GRAY) {
+        picam_image_t image = allocate(config.format, config.width, config.height, buffer);
 
-            // Determine how large the gradient stripes will be
-            int col_width = image.width / 10;
+        // Determine how large the gradient stripes will be
+        int col_width = std::max(1u, image.width / 10);
 
-            // Image line that will be repeated
-            unsigned char line[image.bytes_per_line];
+        // Image line that will be repeated
+        unsigned char* line = image.data;
 
-            for (int j = 0; j < image.width; j++) {
-                line[j] = 255 * (j % col_width) / (double) col_width;
-            }
-            for (int i = 0; i < image.height; i++) {
-                std::memcpy(buffer.data() + i * image.bytes_per_line, line, image.bytes_per_line);
-            }
-            break;
+        for (int j = 0; j < image.width; j++) {
+            line[j] = 255 * (j % col_width) / (double) col_width;
+        }
+        for (int i = 1; i < image.height; i++) {
+            std::memcpy(image.data + i * image.bytes_per_line, line, image.bytes_per_line);
         }
-        case PICAM_IMAGE_FORMAT_RGB:
-        case PICAM_IMAGE_FORMAT_BGR: {
-            buffer.resize(image.width * image.height * 3);
-            image.bytes_per_line = image.width * 3;
+        return image;
+    }
 
-            // Image line that will be repeated.
-            unsigned char line[image.bytes_per_line];
+    // Planar formats are converted from RGB.
+    const picam_image_format_t format = is_planar(config.format) ? PICAM_IMAGE_FORMAT_RGB : config.format;
+    picam_image_t image = allocate(format, config.width, config.height, buffer);
 
-            int red = 0, green = 1, blue = 2;
-            if (config_.format == PICAM_IMAGE_FORMAT_BGR) {
-                std::swap(red, blue);
-            }
+    // Image line that will be repeated.
+    unsigned char* line = image.data;
 
-            for (int j = 0; j < image.width; j++) {
-                unsigned char r, g, b;
-                double value = j / (double) image.width;
-
-                // Calculate the hue based on a value between 0 and 1.0
-
-                if (value < 0.3334) {
-                    r = static_cast<unsigned char>(255.0 * (1.0 - value * 3.0));
-                    g = static_cast<unsigned char>(255.0 * value * 3.0);
-                    b = 0;
-                }
-                else if (value < 0.6667) {
-                    r = 0;
-                    g = static_cast<unsigned char>(255.0 * (0.6667 - value) * 3.0);
-                    b = static_cast<unsigned char>(255.0 * (value - 0.3334) * 3.0);
-                }
-                else {
-                    r = static_cast<unsigned char>(255.0 * (value - 0.6667) * 3.0);
-                    g = 0;
-                    b = static_cast<unsigned char>(255.0 * (1.0 - value) * 3.0);
-                }
-
-                line[j * 3 + red] = std::min<unsigned char>(127, r) * 2;
-                line[j * 3 + green] = std::min<unsigned char>(127, g) * 2;
-                line[j * 3 + blue] = std::min<unsigned char>(127, b) * 2;
-            }
-            for (int i = 0; i < image.height; i++) {
-                std::memcpy(buffer.data() + i * image.bytes_per_line, line, image.bytes_per_line);
+    int red = 0, green = 1, blue = 2;
+    if (format == PICAM_IMAGE_FORMAT_BGR) {
+        std::swap(red, blue);
+    }
+
+    for (int j = 0; j < image.width; j++) {
+        unsigned char r, g, b;
+        double value = j / (double) image.width;
+
+        // Calculate the hue based on a value between 0 and 1.0
+
+        if (value < 0.3334) {
+            r = static_cast<unsigned char>(255.0 * (1.0 - value * 3.0));
+            g = static_cast<unsigned char>(255.0 * value * 3.0);
+            b = 0;
+        }
+        else if (value < 0.6667) {
+            r = 0;
+            g = static_cast<unsigned char>(255.0 * (0.6667 - value) * 3.0);
+            b = static_cast<unsigned char>(255.0 * (value - 0.3334) * 3.0);
+        }
+        else {
+            r = static_cast<unsigned char>(255.0 * (value - 0.6667) * 3.0);
+            g = 0;
+            b = static_cast<unsigned char>(255.0 * (1.0 - value) * 3.0);
+        }
+
+        line[j * 3 + red] = std::min<unsigned char>(127, r) * 2;
+        line[j * 3 + green] = std::min<unsigned char>(127, g) * 2;
+        line[j * 3 + blue] = std::min<unsigned char>(127, b) * 2;
+    }
+    for (int i = 1; i < image.height; i++) {
+        std::memcpy(image.data + i * image.bytes_per_line, line, image.bytes_per_line);
+    }
+
+    return (format == config.format) ? image : to_planar(image, config.format, buffer);
+}
+
+/*************************************************************************************************/
+
+// Create uniform dark frame used as background of the moving box.
+static picam_image_t make_background(const picam_config_t& config, std::vector<unsigned char>& buffer)
+{
+    const picam_image_format_t format = is_planar(config.format) ? PICAM_IMAGE_FORMAT_RGB : config.format;
+    picam_image_t image = allocate(format, config.width, config.height, buffer);
+    std::memset(image.data, 32, image.data_size);
+    return (format == config.format) ? image : to_planar(image, config.format, buffer);
+}
+
+/*************************************************************************************************/
+
+// Copy pattern into frame with every line rotated left by phase pixels.
+static void render_gradient(const picam_image_t& pattern, unsigned int phase, picam_image_t& frame)
+{
+    Plane source[3];
+    Plane destination[3];
+    const unsigned int count = image_planes(pattern, source);
+    image_planes(frame, destination);
+
+    for (unsigned int p = 0; p < count; p++) {
+        const Plane& from = source[p];
+        const Plane& to = destination[p];
+        const unsigned int line_size = from.width * from.channels;
+        const unsigned int shift = ((p == 0 ? phase : phase / 2) % from.width) * from.channels;
+
+        // Each line is copied in two pieces instead of being rotated in place.
+        for (unsigned int i = 0; i < from.height; i++) {
+            const unsigned char* line = from.data + i * from.bytes_per_line;
+            unsigned char* out = to.data + i * to.bytes_per_line;
+            std::memcpy(out, line + shift, line_size - shift);
+            std::memcpy(out + line_size - shift, line, shift);
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+// Position of an object bouncing between 0 and range moving step pixels per frame.
+static unsigned int bounce(std::uint64_t sequence, unsigned int step, unsigned int range)
+{
+    if (range == 0) {
+        return 0;
+    }
+    const std::uint64_t position = (sequence * step) % (2 * range);
+    return static_cast<unsigned int>(position <= range ? position : 2 * range - position);
+}
+
+// Copy background into frame and draw a white box bouncing around it.
+static void render_box(const picam_image_t& background, std::uint64_t sequence, picam_image_t& frame)
+{
+    std::memcpy(frame.data, background.data, background.data_size);
+
+    // Box covers 1/8 of the height, with even position and size so chroma is aligned.
+    const unsigned int size = std::min(frame.width, std::max(2u, frame.height / 8)) & ~1u;
+    const unsigned int x = bounce(sequence, 4, frame.width - size) & ~1u;
+    const unsigned int y = bounce(sequence, 2, frame.height - size) & ~1u;
+
+    Plane planes[3];
+    const unsigned int count = image_planes(frame, planes);
+
+    for (unsigned int p = 0; p < count; p++) {
+        const Plane& plane = planes[p];
+        const unsigned int scale = (p == 0) ? 1 : 2;
+
+        // Neutral chroma so the box is white in every format.
+        const unsigned char value = (p == 0) ? 255 : 128;
+
+        for (unsigned int i = y / scale; i < (y + size) / scale; i++) {
+            std::memset(plane.data + i * plane.bytes_per_line + (x / scale) * plane.channels, value,
+                        (size / scale) * plane.channels);
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+// Copy frame sized block of random bytes taken at a random position of the pool.
+static void render_noise(const std::vector<unsigned char>& pool, std::mt19937& generator, picam_image_t& frame)
+{
+    // Keep source aligned so the copy runs at full speed.
+    const std::size_t positions = (pool.size() - frame.data_size) / 64;
+    const std::size_t offset = 64 * (generator() % (positions + 1));
+    std::memcpy(frame.data, pool.data() + offset, frame.data_size);
+}
+
+/*************************************************************************************************/
+
+// Write sequence number and capture time at the beginning of the first line.
+static void write_stamp(picam_image_t& frame, std::uint64_t sequence, std::uint64_t timestamp)
+{
+    if (frame.width * bytes_per_pixel(frame.format) >= kStampSize) {
+        std::memcpy(frame.data, &sequence, sizeof(sequence));
+        std::memcpy(frame.data + sizeof(sequence), &timestamp, sizeof(timestamp));
+    }
+}
+
+/*************************************************************************************************/
+
+void DummyCamera::main_loop()
+{
+    using namespace std::chrono;
+
+    // Pattern rendered once and copied into the ring for each frame.
+    std::vector<unsigned char> pattern_buffer;
+    picam_image_t pattern;
+
+    switch (config_.pattern) {
+        case PICAM_PATTERN_NOISE: {
+            // Pool is larger than a frame so each one starts at a different position.
+            pattern = allocate(config_.format, config_.width, config_.height, pattern_buffer);
+            pattern_buffer.resize(2 * pattern.data_size);
+            std::mt19937 generator;
+            std::uniform_int_distribution<int> distribution(0, 255);
+            for (unsigned char& value : pattern_buffer) {
+                value = static_cast<unsigned char>(distribution(generator));
             }
             break;
         }
+        case PICAM_PATTERN_BOX:
+            pattern = make_background(config_, pattern_buffer);
+            break;
         default:
-            std::cout << "Invalid image format..." << std::endl;
+            pattern = make_gradient(config_, pattern_buffer);
             break;
     }
 
-    image.data_size = static_cast<unsigned int>(buffer.size());
-    image.data = &buffer[0];
+    // Frames are rendered in turn into preallocated buffers, enough for the ones waiting in the
+    // pipeline plus the one being delivered and the one being rendered.
+    const unsigned int ring_size = (config_.queue_depth ? config_.queue_depth : FramePipeline::DEFAULT_DEPTH) + 2;
+    std::vector<std::vector<unsigned char>> buffers(ring_size);
+    std::vector<picam_image_t> ring(ring_size);
+    for (unsigned int i = 0; i < ring_size; i++) {
+        ring[i] = allocate(pattern.format, pattern.width, pattern.height, buffers[i]);
+    }
+
+    // Buffers held by the pipeline or acquired by consumers can't be rendered into.
+    std::unique_ptr<FrameBuffer[]> frames(new FrameBuffer[ring_size]);
+    for (unsigned int i = 0; i < ring_size; i++) {
+        ring[i].buffer = &frames[i];
+    }
+
+    FramePipeline pipeline(config_.queue_depth, config_.delivery,
+        [this](FramePipeline::Frame& frame) {
+            std::lock_guard<std::mutex> lock(user_mutex_);
+            if (user_callback_ ) {
+                user_callback_(user_data_, &frame.image);
+            }
+        },
+        [](void* handle) {
+            static_cast<FrameBuffer*>(handle)->release();
+        });
+
+    // Without framerate frames are produced as fast as possible.
+    const bool throttled = config_.framerate > 0.0;
 
     // Interval to sleep derived from framerate.
-    microseconds interval = microseconds(static_cast<int64_t>((1.0 / config_.framerate) * 1.0e6));
+    nanoseconds interval = throttled ? nanoseconds(static_cast<int64_t>(1.0e9 / config_.framerate)) : nanoseconds(0);
     auto wake_at = steady_clock::now();
 
     // Determine how many cols we shift per frame based on the framerate.
-    const unsigned int bits_per_pixel = image.bytes_per_line / image.width;
-    const unsigned int shift = bits_per_pixel * 60.0 / std::min(config_.framerate, 60.0);
+    unsigned int cols = throttled ? static_cast<unsigned int>(60.0 / std::min(config_.framerate, 60.0)) : 1;
 
-    while (keep_running_) {
+    // Chroma planes have half the width, keep it even so they move with the luma.
+    if (is_planar(pattern.format)) {
+        cols = (cols + 1) & ~1u;
+    }
+
+    std::mt19937 generator;
+    std::uint32_t dropped = 0;
+    unsigned int next = 0;
 
-        unsigned char temp[shift];
+    for (std::uint64_t sequence = 0; keep_running_; sequence++) {
 
-        for (int i = 0; i < image.height; i++) {
-            unsigned char* line = buffer.data() + i * image.bytes_per_line;
-            std::memcpy(temp, line, shift);
-            std::memmove(line, line + shift, image.bytes_per_line - shift);
-            std::memcpy(line + image.bytes_per_line - shift, temp, shift);
+        // Find a free buffer, otherwise the frame is dropped as a real camera would do.
+        unsigned int index = next;
+        for (unsigned int i = 0; i < ring_size && frames[index].busy(); i++) {
+            index = (index + 1) % ring_size;
         }
 
-        std::lock_guard<std::mutex> lock(user_mutex_);
-        if (user_callback_ ) {
-            user_callback_(user_data_, &image);
+        const std::uint64_t timestamp = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+
+        if (frames[index].busy()) {
+            dropped++;
+        } else {
+            next = (index + 1) % ring_size;
+            picam_image_t& image = ring[index];
+
+            switch (config_.pattern) {
+                case PICAM_PATTERN_NOISE:
+                    render_noise(pattern_buffer, generator, image);
+                    break;
+                case PICAM_PATTERN_BOX:
+                    render_box(pattern, sequence, image);
+                    break;
+                default:
+                    render_gradient(pattern, static_cast<unsigned int>((sequence * cols) % pattern.width), image);
+                    break;
+            }
+            write_stamp(image, sequence, timestamp);
+            image.timestamp = timestamp;
+            image.sequence = sequence;
+            image.dropped = dropped;
+
+            frames[index].acquire();
+            pipeline.push(&frames[index], image);
         }
 
-        wake_at += interval;
-        std::this_thread::sleep_until(wake_at);
+        if (throttled) {
+            // Don't try to catch up when the consumers are slower than the framerate.
+            wake_at = std::max(wake_at + interval, steady_clock::now() - interval);
+            std::this_thread::sleep_until(wake_at);
+        }
     }
 }
 
@@ -1,7 +1,7 @@
-#ifndef PICAM_CAMERA_IMPL_H
-#define PICAM_CAMERA_IMPL_H
+#ifndef PICAM_CAMERA_DUMMY_H
+#define PICAM_CAMERA_DUMMY_H
 
-#include "picam_camera.hpp"
+#include "picam_camera_impl.hpp"
 
 #include <thread>
 #include <mutex>
@@ -11,28 +11,29 @@ namespace PiCam {
 
 /*************************************************************************************************/
 
-// Dummy camera implementation to use when MMAL is not found.
-class Camera::Impl
+// Synthetic camera implementation, default when MMAL is not available.
+// Renders the configured pattern at the configured framerate, or as fast as possible if it is zero.
+class DummyCamera : public Camera::Impl
 {
 public:
     // Construct camera using supplied configuration.
-    Impl(const picam_config_t& config);
+    DummyCamera(const picam_config_t& config);
 
     // Stop capturing.
-    ~Impl();
+    ~DummyCamera();
 
     // Set callback that will be called every time a new frame is availabe.
-    void set_callback(void* user_data, picam_callback_t callback);
+    void set_callback(void* user_data, picam_callback_t callback) override;
 
     // Get current parameters.
-    const picam_params_t& parameters();
+    const picam_params_t& parameters() override;
 
     // Update parameters to new value.
-    void set_parameters(const picam_params_t& params);
+    void set_parameters(const picam_params_t& params) override;
 
 private:
 
-    // Loop that will periodically provide random images.
+    // Loop that will periodically provide synthetic images.
     void main_loop();
 
     // Configuration supplied during construction.
@@ -57,4 +58,4 @@ private:
 
 }
 
-#endif //PICAM_CAMERA_IMPL_H
+#endif //PICAM_CAMERA_DUMMY_H
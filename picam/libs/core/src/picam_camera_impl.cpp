@@ -0,0 +1,94 @@
+#include "picam_camera_impl.hpp"
+#include "picam_camera_dummy.hpp"
+#include "picam_camera_replay.hpp"
+#ifdef USE_MMAL
+#include "picam_camera_mmal.hpp"
+#endif
+
+#include "jaw_exception.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Backend that can be selected on creation.
+struct Backend
+{
+    picam_backend_t id;
+    std::unique_ptr<Camera::Impl> (*create)(const picam_config_t& config);
+};
+
+// Names used by PICAM_BACKEND, indexed by picam_backend_t.
+static const char* const backend_names[] = { "default", "mmal", "synthetic", "replay" };
+
+/*************************************************************************************************/
+
+// Replay recording named by PICAM_REPLAY.
+static std::unique_ptr<Camera::Impl> create_replay(const picam_config_t& config)
+{
+    const char* path = std::getenv("PICAM_REPLAY");
+    if (!path || !*path) {
+        throw Jaw::Exception(std::errc::invalid_argument, "PICAM_REPLAY must name the recording to replay");
+    }
+    return std::make_unique<ReplayCamera>(config, path);
+}
+
+/*************************************************************************************************/
+
+// Every backend built in, the first one is the default.
+static const Backend backends[] = {
+#ifdef USE_MMAL
+    { PICAM_BACKEND_MMAL, [](const picam_config_t& config) -> std::unique_ptr<Camera::Impl> {
+        return std::make_unique<MmalCamera>(config);
+    }},
+#endif
+    { PICAM_BACKEND_SYNTHETIC, [](const picam_config_t& config) -> std::unique_ptr<Camera::Impl> {
+        return std::make_unique<DummyCamera>(config);
+    }},
+    { PICAM_BACKEND_REPLAY, &create_replay },
+};
+
+/*************************************************************************************************/
+
+// Resolve default backend from the environment.
+static picam_backend_t default_backend()
+{
+    const char* name = std::getenv("PICAM_BACKEND");
+    if (name && *name) {
+        for (int id = PICAM_BACKEND_MMAL; id <= PICAM_BACKEND_REPLAY; id++) {
+            if (std::strcmp(backend_names[id], name) == 0) {
+                return static_cast<picam_backend_t>(id);
+            }
+        }
+        throw Jaw::Exception(std::errc::invalid_argument, std::string("Unknown camera backend ") + name);
+    }
+
+    const char* replay = std::getenv("PICAM_REPLAY");
+    return (replay && *replay) ? PICAM_BACKEND_REPLAY : backends[0].id;
+}
+
+/*************************************************************************************************/
+
+std::unique_ptr<Camera::Impl> Camera::Impl::create(const picam_config_t& config)
+{
+    const picam_backend_t id = (config.backend == PICAM_BACKEND_DEFAULT) ? default_backend() : config.backend;
+    if (id < PICAM_BACKEND_MMAL || id > PICAM_BACKEND_REPLAY) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Unknown camera backend");
+    }
+
+    for (const Backend& backend : backends) {
+        if (backend.id == id) {
+            std::cout << "Using " << backend_names[id] << " camera backend" << std::endl;
+            return backend.create(config);
+        }
+    }
+    throw Jaw::Exception(std::errc::not_supported, "Camera backend not available");
+}
+
+/*************************************************************************************************/
+
+}
@@ -1,5 +1,37 @@
-#ifdef USE_MMAL
-#include "picam_camera_mmal.hpp"
-#else
-#include "picam_camera_dummy.hpp"
-#endif
+#ifndef PICAM_CAMERA_IMPL_H
+#define PICAM_CAMERA_IMPL_H
+
+#include "picam_camera.hpp"
+
+#include <memory>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Source of the frames delivered by Camera (hardware, synthetic or replayed).
+// Backends start capturing on construction and stop on destruction.
+class Camera::Impl
+{
+public:
+    // Create backend selected by config.backend (see picam_backend_t).
+    // Throws Jaw::Exception if it is unknown or not available in this build.
+    static std::unique_ptr<Impl> create(const picam_config_t& config);
+
+    virtual ~Impl() = default;
+
+    // Set callback that will be called every time a new frame is availabe.
+    virtual void set_callback(void* user_data, picam_callback_t callback) = 0;
+
+    // Get current parameters.
+    virtual const picam_params_t& parameters() = 0;
+
+    // Update parameters to new value.
+    virtual void set_parameters(const picam_params_t& params) = 0;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif //PICAM_CAMERA_IMPL_H
@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <chrono>
 
 using namespace Jaw;
 
@@ -67,6 +68,15 @@ static void assert_mmal_status(MMAL_STATUS_T status, std::string message)
 
 /*************************************************************************************************/
 
+// Current steady clock time in nanoseconds.
+static std::uint64_t steady_time()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/*************************************************************************************************/
+
 int mmal_encoding_from_image_format(picam_image_format_t format)
 {
     // Note: In Camera Module v2 the formats RGB and BGR are no longer inverted.
@@ -77,6 +87,10 @@ int mmal_encoding_from_image_format(picam_image_format_t format)
         return MMAL_ENCODING_RGB24;
     case PICAM_IMAGE_FORMAT_BGR:
         return MMAL_ENCODING_BGR24;
+    case PICAM_IMAGE_FORMAT_I420:
+        return MMAL_ENCODING_I420;
+    case PICAM_IMAGE_FORMAT_NV12:
+        return MMAL_ENCODING_NV12;
     default:
         throw Exception(std::errc::invalid_argument, "Invalid image format");
     }
@@ -84,12 +98,16 @@ int mmal_encoding_from_image_format(picam_image_format_t format)
 
 /*************************************************************************************************/
 
-Camera::Impl::Impl(const picam_config_t& config)
+MmalCamera::MmalCamera(const picam_config_t& config)
     : config_(config)
     , user_data_(nullptr)
     , callback_(nullptr)
-    , callback_work_()
+    , pipeline_()
+    , port_buffers_()
     , image_()
+    , start_time_(0)
+    , sequence_(0)
+    , dropped_(0)
     , picam_parameters_()
     , mmal_parameters_()
     , camera_component_(nullptr)
@@ -102,8 +120,39 @@ Camera::Impl::Impl(const picam_config_t& config)
     image_.format = config_.format;
     image_.width = config_.width;
     image_.height = config_.height;
-    image_.bytes_per_line = image_.width * (image_.format == PICAM_IMAGE_FORMAT_GRAY ? 1 : 3);
-    image_.data_size = image_.height * image_.bytes_per_line;
+    if (image_.format == PICAM_IMAGE_FORMAT_RGB || image_.format == PICAM_IMAGE_FORMAT_BGR) {
+        image_.bytes_per_line = image_.width * 3;
+        image_.data_size = image_.height * image_.bytes_per_line;
+        image_.num_planes = 1;
+        image_.planes[0] = { 0, image_.bytes_per_line };
+    } else {
+        // YUV buffers have lines aligned to 32 bytes and planes aligned to 16 lines.
+        // GRAY exposes only the Y plane.
+        const unsigned int stride = VCOS_ALIGN_UP(image_.width, 32);
+        const unsigned int luma_size = stride * VCOS_ALIGN_UP(image_.height, 16);
+        const unsigned int chroma_size = luma_size / 4;
+
+        image_.bytes_per_line = stride;
+        image_.planes[0] = { 0, stride };
+
+        switch (image_.format) {
+        case PICAM_IMAGE_FORMAT_I420:
+            image_.num_planes = 3;
+            image_.planes[1] = { luma_size, stride / 2 };
+            image_.planes[2] = { luma_size + chroma_size, stride / 2 };
+            image_.data_size = luma_size + 2 * chroma_size;
+            break;
+        case PICAM_IMAGE_FORMAT_NV12:
+            image_.num_planes = 2;
+            image_.planes[1] = { luma_size, stride };
+            image_.data_size = luma_size + 2 * chroma_size;
+            break;
+        default:
+            image_.num_planes = 1;
+            image_.data_size = stride * image_.height;
+            break;
+        }
+    }
 
     // Will be set during video_port_callback with MMAL buffer.
     image_.data = nullptr;
@@ -181,20 +230,33 @@ Camera::Impl::Impl(const picam_config_t& config)
         // Default is to not crop the image.
 	picam_parameters_.crop = { 0.0, 0.0, 1.0, 1.0 };
 
-        // Ensure there are enough buffers to avoid dropping frames.
+        // Ensure there are enough buffers to avoid dropping frames, including the ones held by
+        // the pipeline (waiting frames plus the one being delivered).
+        const unsigned int depth = config_.queue_depth ? config_.queue_depth : FramePipeline::DEFAULT_DEPTH;
         video_port_->buffer_size = video_port_->buffer_size_recommended;
-        video_port_->buffer_num = std::max<uint32_t>(3, video_port_->buffer_num_recommended);
+        video_port_->buffer_num = std::max<uint32_t>(3, video_port_->buffer_num_recommended) + depth + 1;
 
         video_pool_ = mmal_port_pool_create(video_port_, video_port_->buffer_num, video_port_->buffer_size);
         if (!video_pool_) {
             throw Exception(std::errc::state_not_recoverable, "Failed to create buffer header pool for video output port");
         }
 
+        // Headers are shared with consumers that acquire frames, so they are reference counted.
+        for (unsigned int i = 0; i < video_pool_->headers_num; i++) {
+            port_buffers_.emplace_back(new PortBuffer(this, video_pool_->header[i]));
+            video_pool_->header[i]->user_data = port_buffers_.back().get();
+        }
+
+        // Buffers are delivered from a persistent worker and given back to the port once released.
+        pipeline_.reset(new FramePipeline(depth, config_.delivery,
+            [this](FramePipeline::Frame& frame) { call_callback(frame); },
+            [](void* handle) { static_cast<FrameBuffer*>(handle)->release(); }));
+
         // Set this instance as user data for the callback.
         video_port_->userdata = reinterpret_cast<struct MMAL_PORT_USERDATA_T*>(this);
 
         // Enable video port.
-        status = mmal_port_enable(video_port_, &Impl::video_port_callback);
+        status = mmal_port_enable(video_port_, &MmalCamera::video_port_callback);
         assert_mmal_status(status, "Failed to enable video port.");
 
         // Send all the buffers to the camera video port
@@ -227,7 +289,7 @@ Camera::Impl::Impl(const picam_config_t& config)
 
 /*************************************************************************************************/
 
-Camera::Impl::~Impl()
+MmalCamera::~MmalCamera()
 {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
 
@@ -235,6 +297,10 @@ Camera::Impl::~Impl()
         if (video_port_->is_enabled ) {
             mmal_port_disable(video_port_);
         }
+
+        // Stop delivery only after port is disabled, so no more buffers are pushed.
+        pipeline_.reset();
+
         if (video_pool_) {
             mmal_port_pool_destroy(video_port_, video_pool_);
         }
@@ -247,11 +313,14 @@ Camera::Impl::~Impl()
 
 /*************************************************************************************************/
 
-void Camera::Impl::set_callback(void* user_data, picam_callback_t callback)
+void MmalCamera::set_callback(void* user_data, picam_callback_t callback)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
 
     if (callback) {
+        // Timestamps are reset when capture starts.
+        start_time_ = steady_time();
+
         // Start capturing.
         MMAL_STATUS_T status = mmal_port_parameter_set_boolean(video_port_, MMAL_PARAMETER_CAPTURE, true);
         assert_mmal_status(status, "Failed to start capturing on video port");
@@ -270,7 +339,7 @@ void Camera::Impl::set_callback(void* user_data, picam_callback_t callback)
 
 /*************************************************************************************************/
 
-const picam_params_t& Camera::Impl::parameters()
+const picam_params_t& MmalCamera::parameters()
 {
     // Returning a reference might break thread-safety...
     // Nevertheless, as it is a const reference, only read operations are allowed.
@@ -279,7 +348,7 @@ const picam_params_t& Camera::Impl::parameters()
 
 /*************************************************************************************************/
 
-void Camera::Impl::set_parameters(const picam_params_t& params)
+void MmalCamera::set_parameters(const picam_params_t& params)
 {
     // Save desired values to temporary parameters.
     static Parameters temp_params(mmal_parameters_);
@@ -291,10 +360,10 @@ void Camera::Impl::set_parameters(const picam_params_t& params)
 
 /*************************************************************************************************/
 
-void Camera::Impl::video_port_callback(MMAL_PORT_T* port, MMAL_BUFFER_HEADER_T* buffer)
+void MmalCamera::video_port_callback(MMAL_PORT_T* port, MMAL_BUFFER_HEADER_T* buffer)
 {
     // We passed a reference to this as userdata.
-    Impl* camera = (Impl*) port->userdata;
+    MmalCamera* camera = (MmalCamera*) port->userdata;
     if (!camera) {
         mmal_buffer_header_release(buffer);
         return;
@@ -302,43 +371,39 @@ void Camera::Impl::video_port_callback(MMAL_PORT_T* port, MMAL_BUFFER_HEADER_T*
 
     // Callback was called for clean-up.
     if (!port->is_enabled) {
-        if (camera->callback_work_.valid()) {
-           MMAL_BUFFER_HEADER_T* old_buffer = camera->callback_work_.get();
-           mmal_buffer_header_release(old_buffer);
-        }
         mmal_buffer_header_release(buffer);
         return; 
     }
 
-    // For the first frame the std::future is empty, no point checking it.
-    if (!camera->callback_work_.valid()) {
-        // Request callback execution and don't release this buffer.
-        camera->callback_work_ = std::async(std::launch::async, &Camera::Impl::call_callback, camera, buffer);
-        return;
-    } else {
-        // Verify if the last callback execution have finished.
-        auto status = camera->callback_work_.wait_for(std::chrono::seconds(0));
-        if (status == std::future_status::ready) {
-            // Get buffer that was used on last execution.
-            MMAL_BUFFER_HEADER_T* old_buffer = camera->callback_work_.get();
-            camera->callback_work_ = std::async(std::launch::async, &Camera::Impl::call_callback, camera, buffer);
-
-            // Set buffer to the one returned so we can release it and not the one that will be used by the callback.
-            buffer = old_buffer;
-        } else {
-            std::cout << "Already running callback, skip buffer." << std::endl;
-        }
-    }
+    // Every buffer gets a number, so consumers can detect skipped ones.
+    PortBuffer* frame = static_cast<PortBuffer*>(buffer->user_data);
+    picam_image_t image = camera->image_;
+    image.sequence = camera->sequence_++;
+    image.buffer = frame;
+
+    // Pipeline takes a reference to the buffer, releasing it right away if it is full.
+    frame->acquire();
+    camera->pipeline_->push(frame, image);
+}
+
+/*************************************************************************************************/
 
+void MmalCamera::release_buffer(MMAL_BUFFER_HEADER_T* buffer)
+{
     // Release buffer back to the pool.
     mmal_buffer_header_release(buffer);
 
+    // Port is disabled during destruction.
+    if (!video_port_->is_enabled) {
+        return;
+    }
+
     // Send one back to the port.
     MMAL_STATUS_T status = MMAL_SUCCESS;
-    MMAL_BUFFER_HEADER_T* new_buffer = mmal_queue_get(camera->video_pool_->queue);
+    MMAL_BUFFER_HEADER_T* new_buffer = mmal_queue_get(video_pool_->queue);
 
     if (new_buffer) {
-        status = mmal_port_send_buffer(port, new_buffer);
+        status = mmal_port_send_buffer(video_port_, new_buffer);
     }
     if (!new_buffer || status != MMAL_SUCCESS) {
         std::cerr << "Unable to return a buffer to the camera port" << std::endl;
@@ -347,33 +412,40 @@ void Camera::Impl::video_port_callback(MMAL_PORT_T* port, MMAL_BUFFER_HEADER_T*
 
 /*************************************************************************************************/
 
-MMAL_BUFFER_HEADER_T* Camera::Impl::call_callback(MMAL_BUFFER_HEADER_T* buffer)
+void MmalCamera::call_callback(FramePipeline::Frame& frame)
 {
+    MMAL_BUFFER_HEADER_T* buffer = static_cast<PortBuffer*>(frame.handle)->header();
+
     // Tries to acquire lock to avoid changes in the camera during execution.
     std::unique_lock<std::recursive_mutex> lock(mutex_, std::try_to_lock);
     if (!lock) {
-       return buffer;
+       dropped_++;
+       return;
     }
 
-    if (callback_ && buffer->length >= image_.data_size) {
+    if (callback_ && buffer->length >= frame.image.data_size) {
         mmal_buffer_header_mem_lock(buffer);
 
         try {
-            image_.data = buffer->data;
-            callback_(user_data_, &image_);
+            picam_image_t& image = frame.image;
+            image.data = buffer->data;
+
+            // Presentation time is in microseconds since capture started.
+            image.timestamp = (buffer->pts != MMAL_TIME_UNKNOWN) ? start_time_ + 1000 * buffer->pts : steady_time();
+            image.dropped += dropped_;
+
+            callback_(user_data_, &image);
         } catch (...) {
             std::cerr << "Bad, bad boy. Callback triggered an exception." << std::endl;
         }
 
         mmal_buffer_header_mem_unlock(buffer);
     }
-
-    return buffer;
 }
 
 /*************************************************************************************************/
 
-void Camera::Impl::check_hardware()
+void MmalCamera::check_hardware()
 {
     char response[80] = "";
 
@@ -429,7 +501,7 @@ static bool is_valid_roi(const picam_roi_t& roi)
 
 /*************************************************************************************************/
 
-void Camera::Impl::update_camera_parameters(const Parameters& new_params, bool force)
+void MmalCamera::update_camera_parameters(const Parameters& new_params, bool force)
 {
     if (camera_component_ == nullptr) {
         throw Exception(std::errc::operation_not_permitted, "Can't set parameters without component");
@@ -745,7 +817,7 @@ void Camera::Impl::update_camera_parameters(const Parameters& new_params, bool f
 
 /*************************************************************************************************/
 
-Camera::Impl::Parameters::Parameters()
+MmalCamera::Parameters::Parameters()
     : sharpness(0)
     , contrast(0)
     , brightness(50)
@@ -769,7 +841,7 @@ Camera::Impl::Parameters::Parameters()
 
 /*************************************************************************************************/
 
-void Camera::Impl::Parameters::import_from(const picam_params_t& params)
+void MmalCamera::Parameters::import_from(const picam_params_t& params)
 {
     sharpness = params.sharpness;
     contrast = params.contrast;
@@ -781,7 +853,7 @@ void Camera::Impl::Parameters::import_from(const picam_params_t& params)
 
 /*************************************************************************************************/
 
-void Camera::Impl::Parameters::export_to(picam_params_t& params) const
+void MmalCamera::Parameters::export_to(picam_params_t& params) const
 {
     params.sharpness = sharpness;
     params.contrast = contrast;
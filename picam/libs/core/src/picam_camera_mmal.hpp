@@ -1,4 +1,6 @@
-#include "picam_camera.hpp"
+#include "picam_camera_impl.hpp"
+#include "picam_pipeline.hpp"
+#include "picam_frame.hpp"
 
 #include "interface/mmal/mmal.h"
 #include "interface/mmal/mmal_logging.h"
@@ -9,7 +11,10 @@
 #include "interface/mmal/util/mmal_connection.h"
 
 #include <mutex>
-#include <future>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstdint>
 
 namespace PiCam {
 
@@ -25,25 +30,25 @@ struct MMAL_PARAM_COLOURFX_T
 
 /*************************************************************************************************/
 
-// The actual camera implementation.
+// Camera implementation capturing from the Raspberry Pi camera.
 // It hides MMAL avoiding unecessary include files to the final user.
-class Camera::Impl
+class MmalCamera : public Camera::Impl
 {
 public:
     // Construct camera using supplied configuration.
-    Impl(const picam_config_t& config);
+    MmalCamera(const picam_config_t& config);
 
     // Stop capturing.
-    ~Impl();
+    ~MmalCamera();
 
     // Set callback that will be called every time a new frame is availabe.
-    void set_callback(void* user_data, picam_callback_t callback);
+    void set_callback(void* user_data, picam_callback_t callback) override;
 
     // Get current parameters.
-    const picam_params_t& parameters();
+    const picam_params_t& parameters() override;
 
     // Update parameters to new value.
-    void set_parameters(const picam_params_t& params);
+    void set_parameters(const picam_params_t& params) override;
 
 private:
     // Struct holding camera parameters for MMAL.
@@ -86,8 +91,36 @@ private:
     // Callback called when a new buffer is available.
     static void video_port_callback(MMAL_PORT_T* port, MMAL_BUFFER_HEADER_T* buffer);
 
-    // Method used to execute set callback asynchronously.
-    MMAL_BUFFER_HEADER_T* call_callback(MMAL_BUFFER_HEADER_T* buffer);
+    // Method used to execute set callback from the delivery pipeline.
+    void call_callback(FramePipeline::Frame& frame);
+
+    // Give buffer back to the pool and send a new one to the port.
+    void release_buffer(MMAL_BUFFER_HEADER_T* buffer);
+
+    // Frame buffer wrapping a buffer header of the pool, released once nobody holds it.
+    class PortBuffer : public FrameBuffer
+    {
+    public:
+        PortBuffer(MmalCamera* camera, MMAL_BUFFER_HEADER_T* header)
+            : camera_(camera)
+            , header_(header)
+        {}
+
+        MMAL_BUFFER_HEADER_T* header() const
+        {
+            return header_;
+        }
+
+    protected:
+        void recycle() override
+        {
+            camera_->release_buffer(header_);
+        }
+
+    private:
+        MmalCamera* camera_;
+        MMAL_BUFFER_HEADER_T* header_;
+    };
 
     // Check that hardware is properly configured.
     // An exception is thrown if something is wrong.
@@ -107,12 +140,24 @@ private:
     // Callback registered with this Camera.
     picam_callback_t callback_;
 
-    // Store result of of asynchronous callback execution.
-    std::future<MMAL_BUFFER_HEADER_T*> callback_work_;
+    // Deliver buffers to callback from a separate thread.
+    std::unique_ptr<FramePipeline> pipeline_;
+
+    // Frame buffer of each header in the pool, referenced by header user data.
+    std::vector<std::unique_ptr<PortBuffer>> port_buffers_;
 
     // Image that will be passed to callback.
     picam_image_t image_;
 
+    // Steady clock time (in nanoseconds) when capture started, buffer timestamps are relative to it.
+    std::uint64_t start_time_;
+
+    // Number of next buffer received from camera.
+    std::uint64_t sequence_;
+
+    // Buffers skipped because the camera was busy (pipeline counts its own drops).
+    std::atomic<std::uint32_t> dropped_;
+
     // Camera parameters store in PiCam and MMAL formats.
     picam_params_t picam_parameters_;
     Parameters mmal_parameters_;
@@ -0,0 +1,127 @@
+#include "picam_camera_replay.hpp"
+#include "picam_pipeline.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+ReplayCamera::ReplayCamera(const picam_config_t& config, const std::string& path)
+    : config_(config)
+    , params_()
+    , recording_(path)
+    , mapping_()
+    , user_data_(nullptr)
+    , user_callback_(nullptr)
+    , user_mutex_()
+    , keep_running_(true)
+    , main_thread_()
+{
+    if (recording_.size() == 0) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Recording has no frames " + path);
+    }
+
+    params_.sharpness = 0;
+    params_.contrast = 0;
+    params_.brightness = 50;
+    params_.saturation = 0;
+    params_.exposure_compensation = 0;
+    params_.crop = { 0.f, 0.f, 1.f, 1.f };
+    params_.zoom = { 0.f, 0.f, 1.f, 1.f };
+
+    main_thread_ = std::thread(&ReplayCamera::main_loop, this);
+}
+
+/*************************************************************************************************/
+
+ReplayCamera::~ReplayCamera()
+{
+    keep_running_ = false;
+    main_thread_.join();
+}
+
+/*************************************************************************************************/
+
+void ReplayCamera::set_callback(void* user_data, picam_callback_t callback)
+{
+    std::lock_guard<std::mutex> lock(user_mutex_);
+    user_data_ = user_data;
+    user_callback_ = callback;
+}
+
+/*************************************************************************************************/
+
+const picam_params_t& ReplayCamera::parameters()
+{
+    return params_;
+}
+
+/*************************************************************************************************/
+
+void ReplayCamera::set_parameters(const picam_params_t& params)
+{
+    params_ = params;
+}
+
+/*************************************************************************************************/
+
+void ReplayCamera::main_loop()
+{
+    using namespace std::chrono;
+
+    FramePipeline pipeline(config_.queue_depth, config_.delivery,
+        [this](FramePipeline::Frame& frame) {
+            std::lock_guard<std::mutex> lock(user_mutex_);
+            if (user_callback_) {
+                user_callback_(user_data_, &frame.image);
+            }
+        },
+        [](void* handle) {
+            static_cast<FrameBuffer*>(handle)->release();
+        });
+
+    // Without framerate frames are replayed as fast as possible.
+    const bool throttled = config_.framerate > 0.0;
+
+    // Recorded time of the first frame of the current pass and when it was replayed.
+    std::uint64_t recorded_start = 0;
+    auto replay_start = steady_clock::now();
+
+    for (std::uint64_t sequence = 0; keep_running_; sequence++) {
+        const std::size_t index = static_cast<std::size_t>(sequence % recording_.size());
+        picam_image_t image = recording_.frame(index);
+
+        if (throttled) {
+            // Each pass starts right away, frames inside it keep their recorded spacing.
+            if (index == 0) {
+                recorded_start = image.timestamp;
+                replay_start = steady_clock::now();
+            }
+            const std::uint64_t offset = image.timestamp > recorded_start ? image.timestamp - recorded_start : 0;
+
+            // Sleep in short steps, so long pauses in the recording don't delay destruction.
+            const auto due = replay_start + nanoseconds(offset);
+            while (keep_running_ && steady_clock::now() < due) {
+                std::this_thread::sleep_until(std::min(due, steady_clock::now() + milliseconds(100)));
+            }
+        }
+
+        image.timestamp = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        image.sequence = sequence;
+        image.dropped = 0;
+        image.lost = 0;
+        image.buffer = &mapping_;
+
+        mapping_.acquire();
+        pipeline.push(&mapping_, image);
+    }
+}
+
+/*************************************************************************************************/
+
+}
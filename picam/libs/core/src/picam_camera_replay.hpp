@@ -0,0 +1,70 @@
+#ifndef PICAM_CAMERA_REPLAY_H
+#define PICAM_CAMERA_REPLAY_H
+
+#include "picam_camera_impl.hpp"
+#include "picam_recording.hpp"
+#include "picam_frame.hpp"
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <string>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Camera implementation serving frames of a recording made with picam_recorder, over and over.
+// Frames follow the recorded timestamps, or come as fast as possible if framerate is zero.
+// They point straight into the mapped file and are stamped again with the replay time and sequence.
+class ReplayCamera : public Camera::Impl
+{
+public:
+    // Map recording and start replaying it. Throws Jaw::Exception if it has no valid frames.
+    ReplayCamera(const picam_config_t& config, const std::string& path);
+
+    // Stop replaying.
+    ~ReplayCamera();
+
+    // Set callback that will be called every time a new frame is availabe.
+    void set_callback(void* user_data, picam_callback_t callback) override;
+
+    // Get current parameters.
+    const picam_params_t& parameters() override;
+
+    // Update parameters to new value.
+    void set_parameters(const picam_params_t& params) override;
+
+private:
+    // Loop that will push recorded frames to the pipeline.
+    void main_loop();
+
+    // Configuration supplied during construction.
+    picam_config_t config_;
+
+    // Parameters for image. Ignored as frames were already captured.
+    picam_params_t params_;
+
+    // Frames replayed.
+    Recording recording_;
+
+    // Mapping shared by every frame, it only counts references as it is never reused.
+    FrameBuffer mapping_;
+
+    // Callback set by the user and associated mutex.
+    void* user_data_;
+    picam_callback_t user_callback_;
+    std::mutex user_mutex_;
+
+    // Used to indicate if thread should keep running or stop.
+    std::atomic<bool> keep_running_;
+
+    // Threads responsible for asynchronous execution.
+    std::thread main_thread_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_CAMERA_REPLAY_H
@@ -0,0 +1,67 @@
+#include "picam_converter.hpp"
+#include "picam_imgproc.hpp"
+
+#include "jaw_exception.hpp"
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+Converter::Converter(const picam_config_t& config)
+    : captured_(config.format)
+    , width_(config.width)
+    , height_(config.height)
+    , format_(config.format)
+    , image_()
+    , buffer_()
+    , mutex_()
+{}
+
+/*************************************************************************************************/
+
+picam_image_format_t Converter::format()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return format_;
+}
+
+/*************************************************************************************************/
+
+void Converter::set_format(picam_image_format_t format)
+{
+    if (!can_convert(captured_, format)) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Unsupported format conversion");
+    }
+    if (format != captured_ && is_planar(format) && (width_ % 2 != 0 || height_ % 2 != 0)) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Planar formats need even frame dimensions");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    format_ = format;
+}
+
+/*************************************************************************************************/
+
+picam_image_t* Converter::process(picam_image_t* image)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (format_ == image->format) {
+        return image;
+    }
+
+    const std::size_t size = image_size(format_, image->width, image->height);
+    if (buffer_.size() < size) {
+        buffer_.resize(size);
+    }
+    image_.data = buffer_.data();
+
+    // Frame dimensions were validated and main region keeps planar targets even.
+    if (!convert(*image, format_, image_)) {
+        return nullptr;
+    }
+    return &image_;
+}
+
+/*************************************************************************************************/
+
+}
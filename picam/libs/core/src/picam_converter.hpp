@@ -0,0 +1,51 @@
+#ifndef PICAM_CONVERTER_H
+#define PICAM_CONVERTER_H
+
+#include "picam_defines.h"
+
+#include <mutex>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Convert captured frames to the format requested by the user.
+// Conversion happens once per frame and the result is shared by all following stages.
+class Converter
+{
+public:
+    // Construct converter delivering frames in the captured format.
+    Converter(const picam_config_t& config);
+
+    // Get format of delivered frames.
+    picam_image_format_t format();
+
+    // Set format of delivered frames. Throws Jaw::Exception if conversion is not supported
+    // or format is planar and captured frames have odd dimensions.
+    void set_format(picam_image_format_t format);
+
+    // Convert image returning the converted image or image itself if formats are the same.
+    // Returned pointer is valid until next call.
+    picam_image_t* process(picam_image_t* image);
+
+private:
+    // Format and dimensions of captured frames.
+    picam_image_format_t captured_;
+    unsigned int width_;
+    unsigned int height_;
+
+    // Requested format and storage for converted image.
+    picam_image_format_t format_;
+    picam_image_t image_;
+    std::vector<unsigned char> buffer_;
+
+    // Protect access to requested format.
+    std::mutex mutex_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_CONVERTER_H
@@ -4,6 +4,7 @@
 
 #include "jaw_member_call.hpp"
 #include "picam_camera.hpp"
+#include "picam_frame.hpp"
 
 using namespace PiCam;
 using namespace Jaw;
@@ -45,6 +46,134 @@ int picam_callback_set(picam_camera_t camera, void* user_data, picam_callback_t
 
 /*************************************************************************************************/
 
+int picam_level_callback_set(picam_camera_t camera, picam_level_t level, void* user_data,
+                             picam_callback_t callback)
+{
+    return member_call(camera, &Camera::set_level_callback, level, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+int picam_crop_add(picam_camera_t camera, const char* name, const picam_roi_t* roi)
+{
+    if (!name || !roi) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return member_call(camera, &Camera::add_crop, std::string(name), *roi);
+}
+
+/*************************************************************************************************/
+
+int picam_crop_remove(picam_camera_t camera, const char* name)
+{
+    if (!name) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return member_call(camera, &Camera::remove_crop, std::string(name));
+}
+
+/*************************************************************************************************/
+
+int picam_crop_callback_set(picam_camera_t camera, void* user_data, picam_crop_callback_t callback)
+{
+    return member_call(camera, &Camera::set_crop_callback, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+int picam_sink_add(picam_camera_t camera, const picam_sink_config_t* config, void* user_data,
+                   picam_callback_t callback, picam_sink_t* sink)
+{
+    if (!config || !sink) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return member_call(camera, &Camera::add_sink, sink, *config, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+int picam_sink_remove(picam_camera_t camera, picam_sink_t sink)
+{
+    return member_call(camera, &Camera::remove_sink, sink);
+}
+
+/*************************************************************************************************/
+
+int picam_motion_set(picam_camera_t camera, const picam_motion_config_t* config)
+{
+    return member_call(camera, &Camera::set_motion, config);
+}
+
+/*************************************************************************************************/
+
+int picam_motion_callback_set(picam_camera_t camera, void* user_data, picam_motion_callback_t callback)
+{
+    return member_call(camera, &Camera::set_motion_callback, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+int picam_stats_set(picam_camera_t camera, const picam_stats_config_t* config)
+{
+    return member_call(camera, &Camera::set_stats, config);
+}
+
+/*************************************************************************************************/
+
+int picam_stats_callback_set(picam_camera_t camera, void* user_data, picam_stats_callback_t callback)
+{
+    return member_call(camera, &Camera::set_stats_callback, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+int picam_features_set(picam_camera_t camera, const picam_features_config_t* config)
+{
+    return member_call(camera, &Camera::set_features, config);
+}
+
+/*************************************************************************************************/
+
+int picam_features_callback_set(picam_camera_t camera, void* user_data, picam_features_callback_t callback)
+{
+    return member_call(camera, &Camera::set_features_callback, user_data, callback);
+}
+
+/*************************************************************************************************/
+
+int picam_frame_acquire(const picam_image_t* image, picam_image_t** frame)
+{
+    if (!image || !frame) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return protected_call([&image, &frame]() {
+        *frame = acquire_frame(*image);
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+int picam_frame_release(picam_image_t* frame)
+{
+    if (!frame) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return protected_call([&frame]() {
+        release_frame(frame);
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+int picam_format_set(picam_camera_t camera, picam_image_format_t format)
+{
+    return member_call(camera, &Camera::set_format, format);
+}
+
+/*************************************************************************************************/
+
 int picam_params_get(picam_camera_t camera, picam_params_t* params)
 {
     return member_call(camera, &Camera::parameters, params);
@@ -54,7 +183,33 @@ int picam_params_get(picam_camera_t camera, picam_params_t* params)
 
 int picam_params_set(picam_camera_t camera, picam_params_t* params)
 {
+    if (!params) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
     return member_call(camera, &Camera::set_parameters, *params);
 }
 
 /*************************************************************************************************/
+
+int picam_encoding_set(picam_camera_t camera, picam_encoding_t)
+{
+    // Images are not transmitted locally, so there is nothing to encode.
+    return camera ? 0 : static_cast<int>(std::errc::invalid_argument);
+}
+
+/*************************************************************************************************/
+
+int picam_events_fd_get(picam_camera_t, int*)
+{
+    // Local callbacks are always delivered by the camera thread.
+    return static_cast<int>(std::errc::function_not_supported);
+}
+
+/*************************************************************************************************/
+
+int picam_process_events(picam_camera_t)
+{
+    return static_cast<int>(std::errc::function_not_supported);
+}
+
+/*************************************************************************************************/
@@ -0,0 +1,147 @@
+#include "picam_crop.hpp"
+
+#include <algorithm>
+
+#include "jaw_exception.hpp"
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+Cropper::Cropper()
+    : main_({ 0.f, 0.f, 1.f, 1.f })
+    , main_image_()
+    , main_buffer_()
+    , regions_()
+    , buffer_()
+    , rects_()
+    , user_data_(nullptr)
+    , callback_(nullptr)
+    , mutex_()
+{}
+
+/*************************************************************************************************/
+
+picam_roi_t Cropper::main_region()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return main_;
+}
+
+/*************************************************************************************************/
+
+void Cropper::set_main_region(const picam_roi_t& roi)
+{
+    if (!valid(roi)) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid crop region");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    main_ = roi;
+}
+
+/*************************************************************************************************/
+
+picam_image_t* Cropper::apply_main_region(picam_image_t* image, picam_image_format_t target)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    PixelRect rect = roi_to_rect(main_, target, image->width, image->height);
+    if (rect.width == image->width && rect.height == image->height) {
+        return image;
+    }
+
+    const std::size_t size = image_size(image->format, rect.width, rect.height);
+    if (main_buffer_.size() < size) {
+        main_buffer_.resize(size);
+    }
+    main_image_.data = main_buffer_.data();
+    crop(*image, rect, main_image_);
+    return &main_image_;
+}
+
+/*************************************************************************************************/
+
+void Cropper::add(const std::string& name, const picam_roi_t& roi)
+{
+    if (!valid(roi)) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid crop region");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = std::find_if(regions_.begin(), regions_.end(),
+                              [&name](const Region& region) { return region.name == name; });
+    if (found != regions_.end()) {
+        found->roi = roi;
+    } else {
+        regions_.push_back({ name, roi, picam_image_t() });
+    }
+}
+
+/*************************************************************************************************/
+
+void Cropper::remove(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = std::find_if(regions_.begin(), regions_.end(),
+                              [&name](const Region& region) { return region.name == name; });
+    if (found == regions_.end()) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Unknown crop region: " + name);
+    }
+    regions_.erase(found);
+}
+
+/*************************************************************************************************/
+
+void Cropper::set_callback(void* user_data, picam_crop_callback_t callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    user_data_ = user_data;
+    callback_ = callback;
+}
+
+/*************************************************************************************************/
+
+void Cropper::process(picam_image_t* image)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!callback_ || regions_.empty()) {
+        return;
+    }
+
+    // Compute all regions first so a single buffer can be sized for them.
+    rects_.resize(regions_.size());
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < regions_.size(); i++) {
+        rects_[i] = roi_to_rect(regions_[i].roi, image->format, image->width, image->height);
+        total += image_size(image->format, rects_[i].width, rects_[i].height);
+    }
+    if (buffer_.size() < total) {
+        buffer_.resize(total);
+    }
+
+    unsigned char* data = buffer_.data();
+    for (std::size_t i = 0; i < regions_.size(); i++) {
+        regions_[i].image.data = data;
+        crop(*image, rects_[i], regions_[i].image);
+        data += regions_[i].image.data_size;
+    }
+
+    for (auto& region : regions_) {
+        callback_(user_data_, region.name.c_str(), &region.image);
+    }
+}
+
+/*************************************************************************************************/
+
+bool Cropper::valid(const picam_roi_t& roi)
+{
+    // Allow small rounding errors when regions are computed by the user.
+    const float tolerance = 1e-4f;
+    return roi.x >= 0.f && roi.y >= 0.f && roi.width > 0.f && roi.height > 0.f &&
+           roi.x + roi.width <= 1.f + tolerance && roi.y + roi.height <= 1.f + tolerance;
+}
+
+/*************************************************************************************************/
+
+}
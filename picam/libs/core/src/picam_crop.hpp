@@ -0,0 +1,83 @@
+#ifndef PICAM_CROP_H
+#define PICAM_CROP_H
+
+#include "picam_defines.h"
+#include "picam_imgproc.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Crop regions from captured frames.
+// The main region (params.crop) replaces the frame delivered to following stages while
+// named regions are delivered to their own callback, one call per region.
+class Cropper
+{
+public:
+    // Construct cropper covering whole frame and without named regions.
+    Cropper();
+
+    // Get region applied to every frame.
+    picam_roi_t main_region();
+
+    // Set region applied to every frame. Throws Jaw::Exception if roi is invalid.
+    void set_main_region(const picam_roi_t& roi);
+
+    // Apply main region returning the cropped image or image itself if it covers the whole frame.
+    // Region is aligned as required by the format frames will be converted to.
+    // Returned pointer is valid until next call.
+    picam_image_t* apply_main_region(picam_image_t* image, picam_image_format_t target);
+
+    // Add named region, replacing any region with the same name. Throws Jaw::Exception if roi is invalid.
+    void add(const std::string& name, const picam_roi_t& roi);
+
+    // Remove named region. Throws Jaw::Exception if region doesn't exist.
+    void remove(const std::string& name);
+
+    // Set callback that will receive named regions.
+    void set_callback(void* user_data, picam_crop_callback_t callback);
+
+    // Crop all named regions from image and deliver them.
+    void process(picam_image_t* image);
+
+    // Returns true if roi is normalized and not empty.
+    static bool valid(const picam_roi_t& roi);
+
+private:
+    // Named region and its image.
+    struct Region
+    {
+        std::string name;
+        picam_roi_t roi;
+        picam_image_t image;
+    };
+
+    // Main region and storage for its image.
+    picam_roi_t main_;
+    picam_image_t main_image_;
+    std::vector<unsigned char> main_buffer_;
+
+    // Named regions, all of them sharing the same buffer.
+    std::vector<Region> regions_;
+    std::vector<unsigned char> buffer_;
+
+    // Regions converted to pixels for current frame.
+    std::vector<PixelRect> rects_;
+
+    // Callback for named regions.
+    void* user_data_;
+    picam_crop_callback_t callback_;
+
+    // Protect access to regions and callback.
+    std::mutex mutex_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_CROP_H
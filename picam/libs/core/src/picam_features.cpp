@@ -0,0 +1,244 @@
+#include "picam_features.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Threshold used when configuration leaves it at zero.
+static const unsigned int kDefaultThreshold = 20;
+
+// Stripes used at most, even on machines with more cores.
+static const unsigned int kMaxThreads = 8;
+
+/*************************************************************************************************/
+
+FeatureExtractor::FeatureExtractor()
+    : config_()
+    , enabled_(false)
+    , user_data_(nullptr)
+    , callback_(nullptr)
+    , gray_()
+    , scores_()
+    , corners_(1)
+    , keypoints_()
+    , descriptors_()
+    , mutex_()
+    , workers_()
+    , job_(nullptr)
+    , generation_(0)
+    , pending_(0)
+    , stopping_(false)
+    , work_mutex_()
+    , work_started_()
+    , work_done_()
+{}
+
+/*************************************************************************************************/
+
+FeatureExtractor::~FeatureExtractor()
+{
+    stop_workers();
+}
+
+/*************************************************************************************************/
+
+void FeatureExtractor::set_config(const picam_features_config_t* config)
+{
+    if (config && config->threshold > 255) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid features configuration");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = (config != nullptr);
+    stop_workers();
+    if (!config) {
+        return;
+    }
+
+    config_ = *config;
+    if (!config_.threshold) {
+        config_.threshold = kDefaultThreshold;
+    }
+    unsigned int threads = config_.threads ? config_.threads : std::thread::hardware_concurrency();
+    threads = std::min(std::max(threads, 1u), kMaxThreads);
+    corners_.resize(threads);
+    start_workers(threads - 1);
+}
+
+/*************************************************************************************************/
+
+void FeatureExtractor::set_callback(void* user_data, picam_features_callback_t callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    user_data_ = user_data;
+    callback_ = callback;
+}
+
+/*************************************************************************************************/
+
+void FeatureExtractor::process(const picam_image_t* image)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_ || !callback_) {
+        return;
+    }
+
+    const Plane gray = luma(*image);
+    scores_.resize(static_cast<std::size_t>(gray.width) * gray.height);
+
+    // Non maxima suppression looks at lines of the other stripes, so it starts once all are scored.
+    const unsigned int stripes = static_cast<unsigned int>(corners_.size());
+    run([&](unsigned int stripe) {
+        fast_scores(gray, config_.threshold, gray.height * stripe / stripes, gray.height * (stripe + 1) / stripes,
+                    scores_.data());
+    });
+    run([&](unsigned int stripe) {
+        corners_[stripe].clear();
+        suppress_non_maxima(scores_.data(), gray.width, gray.height, gray.height * stripe / stripes,
+                            gray.height * (stripe + 1) / stripes, corners_[stripe]);
+    });
+
+    std::vector<Corner>& corners = corners_[0];
+    for (unsigned int stripe = 1; stripe < stripes; stripe++) {
+        corners.insert(corners.end(), corners_[stripe].begin(), corners_[stripe].end());
+    }
+
+    // Position breaks ties, so the same frame always gives the same list.
+    auto stronger = [](const Corner& a, const Corner& b) {
+        return a.score != b.score ? a.score > b.score : (a.y != b.y ? a.y < b.y : a.x < b.x);
+    };
+    if (config_.max_features && corners.size() > config_.max_features) {
+        std::nth_element(corners.begin(), corners.begin() + config_.max_features, corners.end(), stronger);
+        corners.resize(config_.max_features);
+    }
+    std::sort(corners.begin(), corners.end(), stronger);
+
+    keypoints_.resize(corners.size());
+    for (std::size_t i = 0; i < corners.size(); i++) {
+        keypoints_[i].x = static_cast<std::uint16_t>(corners[i].x);
+        keypoints_[i].y = static_cast<std::uint16_t>(corners[i].y);
+        keypoints_[i].score = static_cast<std::uint16_t>(corners[i].score);
+    }
+
+    // Corners are never closer than kFeatureBorder to the borders, so patches are inside the frame.
+    const unsigned int half = PICAM_PATCH_SIZE / 2;
+    if (config_.descriptors) {
+        descriptors_.resize(corners.size() * PICAM_PATCH_SIZE * PICAM_PATCH_SIZE);
+        std::uint8_t* patch = descriptors_.data();
+        for (const Corner& corner : corners) {
+            for (unsigned int y = corner.y - half; y < corner.y + half; y++) {
+                std::memcpy(patch, gray.data + static_cast<std::size_t>(y) * gray.bytes_per_line + corner.x - half,
+                            PICAM_PATCH_SIZE);
+                patch += PICAM_PATCH_SIZE;
+            }
+        }
+    }
+
+    picam_features_t features = {};
+    features.timestamp = image->timestamp;
+    features.sequence = image->sequence;
+    features.width = gray.width;
+    features.height = gray.height;
+    features.num_keypoints = static_cast<unsigned int>(keypoints_.size());
+    features.keypoints = keypoints_.data();
+    features.descriptors = config_.descriptors ? descriptors_.data() : nullptr;
+    callback_(user_data_, &features);
+}
+
+/*************************************************************************************************/
+
+Plane FeatureExtractor::luma(const picam_image_t& image)
+{
+    Plane planes[3];
+    if (bytes_per_pixel(image.format) == 1) {
+        image_planes(image, planes);
+        return planes[0];
+    }
+
+    // Buffer only grows, so there are no allocations after the first frame.
+    const std::size_t size = image_size(PICAM_IMAGE_FORMAT_GRAY, image.width, image.height);
+    if (gray_.size() < size) {
+        gray_.resize(size);
+    }
+    picam_image_t gray = {};
+    gray.data = gray_.data();
+    convert(image, PICAM_IMAGE_FORMAT_GRAY, gray);
+    image_planes(gray, planes);
+    return planes[0];
+}
+
+/*************************************************************************************************/
+
+void FeatureExtractor::run(const std::function<void(unsigned int)>& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(work_mutex_);
+        job_ = &job;
+        pending_ = static_cast<unsigned int>(workers_.size());
+        generation_++;
+    }
+    work_started_.notify_all();
+
+    job(0);
+
+    std::unique_lock<std::mutex> lock(work_mutex_);
+    work_done_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+/*************************************************************************************************/
+
+void FeatureExtractor::start_workers(unsigned int count)
+{
+    stopping_ = false;
+    for (unsigned int i = 1; i <= count; i++) {
+        workers_.emplace_back(&FeatureExtractor::worker_loop, this, i, generation_);
+    }
+}
+
+/*************************************************************************************************/
+
+void FeatureExtractor::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(work_mutex_);
+        stopping_ = true;
+    }
+    work_started_.notify_all();
+
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+/*************************************************************************************************/
+
+void FeatureExtractor::worker_loop(unsigned int stripe, unsigned int generation)
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(work_mutex_);
+            work_started_.wait(lock, [this, generation]() { return stopping_ || generation_ != generation; });
+            if (stopping_) {
+                return;
+            }
+            generation = generation_;
+        }
+
+        (*job_)(stripe);
+
+        std::lock_guard<std::mutex> lock(work_mutex_);
+        if (--pending_ == 0) {
+            work_done_.notify_one();
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,87 @@
+#ifndef PICAM_FEATURES_H
+#define PICAM_FEATURES_H
+
+#include "picam_defines.h"
+#include "picam_imgproc.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Find FAST-9 corners on the luma of frames, reporting the strongest ones to a callback.
+// Frames are split in horizontal stripes, each one processed by a different thread.
+class FeatureExtractor
+{
+public:
+    // Construct extractor disabled.
+    FeatureExtractor();
+
+    // Stop worker threads.
+    ~FeatureExtractor();
+
+    // Enable extraction with supplied configuration, disabling it when null.
+    // Throws Jaw::Exception if configuration is invalid.
+    void set_config(const picam_features_config_t* config);
+
+    // Set callback that will receive features.
+    void set_callback(void* user_data, picam_features_callback_t callback);
+
+    // Extract features of image if enabled.
+    void process(const picam_image_t* image);
+
+private:
+    // Gray plane analysed for image, converting color images.
+    Plane luma(const picam_image_t& image);
+
+    // Execute job for every stripe, the first one from the calling thread, waiting for all of them.
+    void run(const std::function<void(unsigned int)>& job);
+
+    // Start or stop threads processing stripes other than the first one.
+    void start_workers(unsigned int count);
+    void stop_workers();
+
+    // Wait for jobs newer than generation executing them for supplied stripe.
+    void worker_loop(unsigned int stripe, unsigned int generation);
+
+    // Configuration and whether extraction is enabled.
+    picam_features_config_t config_;
+    bool enabled_;
+
+    // Callback set by the user.
+    void* user_data_;
+    picam_features_callback_t callback_;
+
+    // Luma of color frames, and score of every pixel.
+    std::vector<unsigned char> gray_;
+    std::vector<std::uint16_t> scores_;
+
+    // Corners of each stripe, and the features reported.
+    std::vector<std::vector<Corner>> corners_;
+    std::vector<picam_keypoint_t> keypoints_;
+    std::vector<std::uint8_t> descriptors_;
+
+    // Protect access to configuration and callback.
+    std::mutex mutex_;
+
+    // Workers processing stripes, they wait for a new generation of job.
+    std::vector<std::thread> workers_;
+    const std::function<void(unsigned int)>* job_;
+    unsigned int generation_;
+    unsigned int pending_;
+    bool stopping_;
+    std::mutex work_mutex_;
+    std::condition_variable work_started_;
+    std::condition_variable work_done_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_FEATURES_H
@@ -0,0 +1,258 @@
+#include "picam_motion.hpp"
+#include "picam_imgproc.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Images are reduced until their width is not larger than this.
+static const unsigned int kAnalysisWidth = 320;
+
+// Side of the blocks compared (see block_differences).
+static const unsigned int kBlock = 8;
+
+// Threshold used when configuration leaves it at zero.
+static const unsigned int kDefaultThreshold = 12;
+
+/*************************************************************************************************/
+
+MotionDetector::MotionDetector()
+    : config_()
+    , enabled_(false)
+    , user_data_(nullptr)
+    , callback_(nullptr)
+    , buffers_()
+    , reduced_()
+    , background_()
+    , width_(0)
+    , height_(0)
+    , sums_()
+    , changed_()
+    , stack_()
+    , moving_(false)
+    , hold_left_(0)
+    , mutex_()
+{}
+
+/*************************************************************************************************/
+
+void MotionDetector::set_config(const picam_motion_config_t* config)
+{
+    if (config && (config->threshold > 255 || !(config->min_area >= 0.0f && config->min_area <= 1.0f))) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid motion configuration");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = (config != nullptr);
+    if (config) {
+        config_ = *config;
+        if (!config_.threshold) {
+            config_.threshold = kDefaultThreshold;
+        }
+    }
+
+    // Background is learned again, so changes while disabled aren't reported as motion.
+    width_ = 0;
+    height_ = 0;
+    moving_ = false;
+    hold_left_ = 0;
+}
+
+/*************************************************************************************************/
+
+void MotionDetector::set_callback(void* user_data, picam_motion_callback_t callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    user_data_ = user_data;
+    callback_ = callback;
+}
+
+/*************************************************************************************************/
+
+bool MotionDetector::process(const picam_image_t* image)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_) {
+        return true;
+    }
+
+    Plane planes[3];
+    image_planes(reduce(*image), planes);
+    const Plane& frame = planes[0];
+
+    const unsigned int blocks_x = frame.width / kBlock;
+    const unsigned int blocks_y = frame.height / kBlock;
+    if (blocks_x == 0 || blocks_y == 0) {
+        return true;
+    }
+
+    // First frame (or a new size) becomes the background.
+    Plane background = { nullptr, frame.width, frame.height, frame.width, 1 };
+    if (frame.width != width_ || frame.height != height_) {
+        background_.resize(static_cast<std::size_t>(frame.width) * frame.height);
+        background.data = background_.data();
+        for (unsigned int y = 0; y < frame.height; y++) {
+            std::memcpy(background.data + y * background.bytes_per_line,
+                        frame.data + static_cast<std::size_t>(y) * frame.bytes_per_line, frame.width);
+        }
+        width_ = frame.width;
+        height_ = frame.height;
+        return true;
+    }
+    background.data = background_.data();
+
+    sums_.resize(blocks_x * blocks_y);
+    changed_.resize(blocks_x * blocks_y);
+    block_differences(frame, background, sums_.data());
+    follow_background(frame, background);
+
+    const unsigned int limit = config_.threshold * kBlock * kBlock;
+    unsigned int count = 0;
+    for (std::size_t i = 0; i < sums_.size(); i++) {
+        changed_[i] = sums_[i] > limit;
+        count += changed_[i];
+    }
+
+    picam_motion_t motion = {};
+    motion.timestamp = image->timestamp;
+    motion.sequence = image->sequence;
+    motion.changed = static_cast<float>(count) / sums_.size();
+    if (count) {
+        find_regions(blocks_x, blocks_y, motion);
+    }
+
+    // Report frames with motion and the first one without it.
+    const bool moving = motion.num_regions > 0;
+    if (callback_ && (moving || moving_)) {
+        callback_(user_data_, &motion);
+    }
+    moving_ = moving;
+
+    if (moving) {
+        hold_left_ = config_.hold;
+        return true;
+    }
+    if (!config_.suppress_static) {
+        return true;
+    }
+    if (hold_left_) {
+        hold_left_--;
+        return true;
+    }
+    return false;
+}
+
+/*************************************************************************************************/
+
+picam_image_t MotionDetector::reduce(const picam_image_t& image)
+{
+    // Luma of planar formats is already a gray image.
+    Plane planes[3];
+    image_planes(image, planes);
+
+    picam_image_t source = {};
+    source.format = is_planar(image.format) ? PICAM_IMAGE_FORMAT_GRAY : image.format;
+    source.width = image.width;
+    source.height = image.height;
+    source.bytes_per_line = planes[0].bytes_per_line;
+    source.data = planes[0].data;
+    source.data_size = planes[0].bytes_per_line * planes[0].height;
+
+    // Color images are reduced first, so fewer pixels are converted.
+    const picam_image_t* current = &source;
+    int next = 0;
+    while (current->width > kAnalysisWidth || current->format != PICAM_IMAGE_FORMAT_GRAY) {
+        const bool halve = current->width > kAnalysisWidth;
+        const unsigned int width = halve ? current->width / 2 : current->width;
+        const unsigned int height = halve ? current->height / 2 : current->height;
+        const picam_image_format_t format = halve ? current->format : PICAM_IMAGE_FORMAT_GRAY;
+
+        // Buffers only grow, so there are no allocations after the first frame.
+        std::vector<unsigned char>& buffer = buffers_[next];
+        const std::size_t size = image_size(format, width, height);
+        if (buffer.size() < size) {
+            buffer.resize(size);
+        }
+        picam_image_t& output = reduced_[next];
+        output.data = buffer.data();
+
+        if (halve) {
+            downscale_half(*current, output);
+        } else {
+            convert(*current, PICAM_IMAGE_FORMAT_GRAY, output);
+        }
+        current = &output;
+        next = 1 - next;
+    }
+    return *current;
+}
+
+/*************************************************************************************************/
+
+void MotionDetector::find_regions(unsigned int blocks_x, unsigned int blocks_y, picam_motion_t& motion)
+{
+    struct Region
+    {
+        unsigned int left, top, right, bottom, blocks;
+    };
+    std::vector<Region> regions;
+
+    // Group changed blocks touching each other (diagonals included), clearing them once visited.
+    for (unsigned int start = 0; start < changed_.size(); start++) {
+        if (!changed_[start]) {
+            continue;
+        }
+        Region region = { start % blocks_x, start / blocks_x, start % blocks_x, start / blocks_x, 0 };
+        changed_[start] = 0;
+        stack_.assign(1, start);
+
+        while (!stack_.empty()) {
+            const unsigned int block = stack_.back();
+            stack_.pop_back();
+            const unsigned int bx = block % blocks_x;
+            const unsigned int by = block / blocks_x;
+            region.left = std::min(region.left, bx);
+            region.right = std::max(region.right, bx);
+            region.top = std::min(region.top, by);
+            region.bottom = std::max(region.bottom, by);
+            region.blocks++;
+
+            for (unsigned int y = (by ? by - 1 : by); y <= std::min(by + 1, blocks_y - 1); y++) {
+                for (unsigned int x = (bx ? bx - 1 : bx); x <= std::min(bx + 1, blocks_x - 1); x++) {
+                    const unsigned int neighbour = y * blocks_x + x;
+                    if (changed_[neighbour]) {
+                        changed_[neighbour] = 0;
+                        stack_.push_back(neighbour);
+                    }
+                }
+            }
+        }
+
+        if (region.blocks >= config_.min_area * blocks_x * blocks_y) {
+            regions.push_back(region);
+        }
+    }
+
+    std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) {
+        return a.blocks > b.blocks;
+    });
+
+    // Regions are relative to the whole frame, including pixels past the last block.
+    motion.num_regions = std::min<unsigned int>(regions.size(), PICAM_MAX_MOTION_REGIONS);
+    for (unsigned int i = 0; i < motion.num_regions; i++) {
+        const Region& region = regions[i];
+        motion.regions[i].x = static_cast<float>(region.left * kBlock) / width_;
+        motion.regions[i].y = static_cast<float>(region.top * kBlock) / height_;
+        motion.regions[i].width = static_cast<float>((region.right - region.left + 1) * kBlock) / width_;
+        motion.regions[i].height = static_cast<float>((region.bottom - region.top + 1) * kBlock) / height_;
+    }
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,74 @@
+#ifndef PICAM_MOTION_H
+#define PICAM_MOTION_H
+
+#include "picam_defines.h"
+
+#include <mutex>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Find moving regions comparing frames with a background, optionally gating frames without motion.
+// Analysis runs on reduced luma, so its cost hardly depends on the captured resolution.
+class MotionDetector
+{
+public:
+    // Construct detector disabled.
+    MotionDetector();
+
+    // Enable detection with supplied configuration, disabling it when null.
+    // Throws Jaw::Exception if configuration is invalid.
+    void set_config(const picam_motion_config_t* config);
+
+    // Set callback that will receive motion events.
+    void set_callback(void* user_data, picam_motion_callback_t callback);
+
+    // Analyse image reporting motion. Returns false if image is static and must not be delivered.
+    bool process(const picam_image_t* image);
+
+private:
+    // Reduce image to the gray image that is analysed.
+    picam_image_t reduce(const picam_image_t& image);
+
+    // Group changed blocks into regions, filling motion with the largest ones.
+    void find_regions(unsigned int blocks_x, unsigned int blocks_y, picam_motion_t& motion);
+
+    // Configuration and whether detection is enabled.
+    picam_motion_config_t config_;
+    bool enabled_;
+
+    // Callback set by the user.
+    void* user_data_;
+    picam_motion_callback_t callback_;
+
+    // Storage of the reduced images, used in turn.
+    std::vector<unsigned char> buffers_[2];
+    picam_image_t reduced_[2];
+
+    // Background compared to each frame and its dimensions (zero until first frame).
+    std::vector<unsigned char> background_;
+    unsigned int width_;
+    unsigned int height_;
+
+    // Difference and changed flag of each block, plus stack used to group them.
+    std::vector<unsigned int> sums_;
+    std::vector<unsigned char> changed_;
+    std::vector<unsigned int> stack_;
+
+    // Motion was found on previous frame.
+    bool moving_;
+
+    // Frames still delivered after motion stopped.
+    unsigned int hold_left_;
+
+    // Protect access to configuration and callback.
+    std::mutex mutex_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_MOTION_H
@@ -0,0 +1,67 @@
+#include "picam_pyramid.hpp"
+#include "picam_imgproc.hpp"
+
+#include "jaw_exception.hpp"
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+Pyramid::Pyramid()
+    : levels_()
+    , mutex_()
+{}
+
+/*************************************************************************************************/
+
+void Pyramid::set_callback(picam_level_t level, void* user_data, picam_callback_t callback)
+{
+    if (level < PICAM_LEVEL_FULL || level >= PICAM_LEVEL_COUNT) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid pyramid level");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    levels_[level].user_data = user_data;
+    levels_[level].callback = callback;
+}
+
+/*************************************************************************************************/
+
+void Pyramid::process(picam_image_t* image)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Find smallest level someone is interested in.
+    int last = -1;
+    for (int i = 0; i < PICAM_LEVEL_COUNT; i++) {
+        if (levels_[i].callback) {
+            last = i;
+        }
+    }
+
+    const picam_image_t* source = image;
+    for (int i = 0; i <= last; i++) {
+        Level& level = levels_[i];
+
+        if (i == PICAM_LEVEL_FULL) {
+            level.image = *image;
+        } else {
+            // Buffer only grows, so there are no allocations after the first frame.
+            const std::size_t size = image_size(source->format, source->width / 2, source->height / 2);
+            if (level.buffer.size() < size) {
+                level.buffer.resize(size);
+            }
+            level.image.data = level.buffer.data();
+            downscale_half(*source, level.image);
+        }
+
+        if (level.callback) {
+            level.callback(level.user_data, &level.image);
+        }
+        source = &level.image;
+    }
+}
+
+/*************************************************************************************************/
+
+}
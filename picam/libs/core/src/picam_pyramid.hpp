@@ -0,0 +1,50 @@
+#ifndef PICAM_PYRAMID_H
+#define PICAM_PYRAMID_H
+
+#include "picam_defines.h"
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Deliver captured frames to the callbacks registered for each pyramid level.
+// Reduced levels are computed from the previous one, only up to the smallest level in use.
+class Pyramid
+{
+public:
+    // Construct pyramid without any callback.
+    Pyramid();
+
+    // Set callback that will receive images from specified level.
+    // Throws Jaw::Exception if level is invalid.
+    void set_callback(picam_level_t level, void* user_data, picam_callback_t callback);
+
+    // Process captured image delivering it and its reductions.
+    void process(picam_image_t* image);
+
+private:
+    // Callback and image storage for each level.
+    struct Level
+    {
+        void* user_data;
+        picam_callback_t callback;
+        std::vector<unsigned char> buffer;
+        picam_image_t image;
+    };
+
+    // Levels indexed by picam_level_t.
+    std::array<Level, PICAM_LEVEL_COUNT> levels_;
+
+    // Protect access to callbacks.
+    std::mutex mutex_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_PYRAMID_H
@@ -0,0 +1,58 @@
+#include "picam_sinks.hpp"
+
+#include "jaw_exception.hpp"
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+Sinks::Sinks()
+    : sinks_()
+    , next_id_(1)
+    , mutex_()
+{}
+
+/*************************************************************************************************/
+
+picam_sink_t Sinks::add(const picam_sink_config_t& config, void* user_data, picam_callback_t callback)
+{
+    std::unique_ptr<Sink> sink(new Sink(config, user_data, callback));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const picam_sink_t id = next_id_++;
+    sinks_[id] = std::move(sink);
+    return id;
+}
+
+/*************************************************************************************************/
+
+void Sinks::remove(picam_sink_t id)
+{
+    std::unique_ptr<Sink> sink;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sinks_.find(id);
+        if (it == sinks_.end()) {
+            throw Jaw::Exception(std::errc::invalid_argument, "Sink doesn't exist");
+        }
+        sink = std::move(it->second);
+        sinks_.erase(it);
+    }
+
+    // Sink is destroyed outside the lock, so other sinks keep receiving frames meanwhile.
+    sink.reset();
+}
+
+/*************************************************************************************************/
+
+void Sinks::process(picam_image_t* image)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& sink : sinks_) {
+        sink.second->offer(*image);
+    }
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,48 @@
+#ifndef PICAM_SINKS_H
+#define PICAM_SINKS_H
+
+#include "picam_defines.h"
+#include "picam_sink.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Registry of sinks that receive every frame delivered by the camera.
+// Sinks copy accepted frames and deliver them from their own thread, so offering a frame never
+// waits for a callback.
+class Sinks
+{
+public:
+    // Construct registry without any sink.
+    Sinks();
+
+    // Add sink returning its identifier. Throws Jaw::Exception if config or callback are invalid.
+    picam_sink_t add(const picam_sink_config_t& config, void* user_data, picam_callback_t callback);
+
+    // Remove sink waiting for its delivery thread. Throws Jaw::Exception if sink doesn't exist.
+    void remove(picam_sink_t sink);
+
+    // Offer image to all sinks.
+    void process(picam_image_t* image);
+
+private:
+    // Sinks indexed by identifier.
+    std::map<picam_sink_t, std::unique_ptr<Sink>> sinks_;
+
+    // Identifier of next sink added.
+    picam_sink_t next_id_;
+
+    // Protect access to sinks.
+    std::mutex mutex_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_SINKS_H
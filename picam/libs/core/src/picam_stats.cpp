@@ -0,0 +1,119 @@
+#include "picam_stats.hpp"
+#include "picam_imgproc.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+FrameStats::FrameStats()
+    : config_()
+    , enabled_(false)
+    , user_data_(nullptr)
+    , callback_(nullptr)
+    , skip_(0)
+    , stats_()
+    , mutex_()
+{}
+
+/*************************************************************************************************/
+
+void FrameStats::set_config(const picam_stats_config_t* config)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = (config != nullptr);
+    if (config) {
+        config_ = *config;
+    }
+    skip_ = 0;
+}
+
+/*************************************************************************************************/
+
+void FrameStats::set_callback(void* user_data, picam_stats_callback_t callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    user_data_ = user_data;
+    callback_ = callback;
+}
+
+/*************************************************************************************************/
+
+void FrameStats::process(const picam_image_t* image)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_ || !callback_) {
+        return;
+    }
+    if (skip_) {
+        skip_--;
+        return;
+    }
+    skip_ = config_.decimation ? config_.decimation - 1 : 0;
+
+    std::memset(&stats_, 0, sizeof(stats_));
+    stats_.timestamp = image->timestamp;
+    stats_.sequence = image->sequence;
+    stats_.format = image->format;
+
+    // Channels of each plane follow the ones of the previous plane.
+    Plane planes[3];
+    const unsigned int count = image_planes(*image, planes);
+    for (unsigned int i = 0; i < count; i++) {
+        std::uint32_t* histograms[PICAM_MAX_CHANNELS];
+        for (unsigned int c = 0; c < planes[i].channels; c++) {
+            histograms[c] = stats_.channels[stats_.num_channels + c].histogram;
+        }
+        count_values(planes[i], config_.step, histograms);
+        stats_.num_channels += planes[i].channels;
+    }
+
+    for (unsigned int c = 0; c < stats_.num_channels; c++) {
+        summarize(stats_.channels[c]);
+    }
+
+    const picam_channel_stats_t* channels = stats_.channels;
+    switch (image->format) {
+        case PICAM_IMAGE_FORMAT_BGR:
+            stats_.luma = 0.114f * channels[0].mean + 0.587f * channels[1].mean + 0.299f * channels[2].mean;
+            break;
+        case PICAM_IMAGE_FORMAT_RGB:
+            stats_.luma = 0.299f * channels[0].mean + 0.587f * channels[1].mean + 0.114f * channels[2].mean;
+            break;
+        default:
+            stats_.luma = channels[0].mean;
+            break;
+    }
+
+    callback_(user_data_, &stats_);
+}
+
+/*************************************************************************************************/
+
+void FrameStats::summarize(picam_channel_stats_t& channel)
+{
+    std::uint64_t total = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t squares = 0;
+    for (std::uint64_t value = 0; value < 256; value++) {
+        const std::uint64_t count = channel.histogram[value];
+        total += count;
+        sum += count * value;
+        squares += count * value * value;
+    }
+    if (!total) {
+        return;
+    }
+
+    const double mean = static_cast<double>(sum) / total;
+    channel.mean = static_cast<float>(mean);
+    channel.variance = static_cast<float>(std::max(0.0, static_cast<double>(squares) / total - mean * mean));
+    channel.clipped_low = static_cast<float>(100.0 * channel.histogram[0] / total);
+    channel.clipped_high = static_cast<float>(100.0 * channel.histogram[255] / total);
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,54 @@
+#ifndef PICAM_STATS_H
+#define PICAM_STATS_H
+
+#include "picam_defines.h"
+
+#include <mutex>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Compute histograms and derived statistics of frames, reporting them to a callback.
+class FrameStats
+{
+public:
+    // Construct stage disabled.
+    FrameStats();
+
+    // Enable statistics with supplied configuration, disabling them when null.
+    void set_config(const picam_stats_config_t* config);
+
+    // Set callback that will receive statistics.
+    void set_callback(void* user_data, picam_stats_callback_t callback);
+
+    // Compute statistics of image if enabled and selected by decimation.
+    void process(const picam_image_t* image);
+
+private:
+    // Derive mean, variance and clipping of a channel from its histogram.
+    static void summarize(picam_channel_stats_t& channel);
+
+    // Configuration and whether statistics are enabled.
+    picam_stats_config_t config_;
+    bool enabled_;
+
+    // Callback set by the user.
+    void* user_data_;
+    picam_stats_callback_t callback_;
+
+    // Frames skipped before the next one is analysed.
+    unsigned int skip_;
+
+    // Statistics reused for each frame (they hold several histograms).
+    picam_stats_t stats_;
+
+    // Protect access to configuration and callback.
+    std::mutex mutex_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_STATS_H
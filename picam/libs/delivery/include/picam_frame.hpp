@@ -0,0 +1,53 @@
+#ifndef PICAM_FRAME_H
+#define PICAM_FRAME_H
+
+#include "picam_defines.h"
+
+#include <atomic>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Buffer holding the data of a frame, shared by its producer and the consumers that acquired it.
+// Images point to their buffer (image.buffer) so it can be acquired while the callback runs.
+class FrameBuffer
+{
+public:
+    // Construct buffer without references.
+    FrameBuffer();
+
+    virtual ~FrameBuffer();
+
+    // Add a reference, the buffer won't be recycled until it is released.
+    void acquire();
+
+    // Remove a reference, recycling buffer when it was the last one.
+    void release();
+
+    // Returns true while there are references to the buffer.
+    bool busy() const;
+
+protected:
+    // Called when the last reference is released. Buffer might be deleted here.
+    // Default does nothing, so the producer can reuse the buffer once it is not busy.
+    virtual void recycle();
+
+private:
+    std::atomic<unsigned int> references_;
+};
+
+/*************************************************************************************************/
+
+// Keep buffer of image alive returning an image with the same content, valid until release_frame.
+// Images without buffer are copied into a new one.
+picam_image_t* acquire_frame(const picam_image_t& image);
+
+// Release image returned by acquire_frame.
+void release_frame(picam_image_t* frame);
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_FRAME_H
@@ -0,0 +1,91 @@
+#ifndef PICAM_PIPELINE_H
+#define PICAM_PIPELINE_H
+
+#include "picam_defines.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Deliver frames produced by a camera implementation from a persistent worker thread.
+// Frames wait in a lock-free ring with a single producer (the camera) and a single consumer
+// (the worker). The producer never blocks: frames that don't fit are discarded and counted.
+class FramePipeline
+{
+public:
+    // Frame waiting for delivery. Handle identifies the producer buffer holding its pixels.
+    struct Frame
+    {
+        void* handle;
+        picam_image_t image;
+    };
+
+    // Called from the worker thread to deliver a frame. Image data may be set here.
+    typedef std::function<void(Frame& frame)> Deliver;
+
+    // Called when producer buffer is no longer used, either delivered or discarded.
+    typedef std::function<void(void* handle)> Release;
+
+    // Start worker thread. Depth is the number of frames that can wait for delivery (0 uses the
+    // default) and policy defines which ones are discarded when the worker is late.
+    FramePipeline(unsigned int depth, picam_delivery_t policy, Deliver deliver, Release release);
+
+    // Stop worker thread releasing frames that were not delivered.
+    ~FramePipeline();
+
+    // Queue frame for delivery, returning false (after releasing it) if it was discarded.
+    // Must be called always from the same thread.
+    bool push(void* handle, const picam_image_t& image);
+
+    // Frames discarded since construction.
+    std::uint32_t dropped() const;
+
+    // Depth used when none is specified.
+    static const unsigned int DEFAULT_DEPTH = 2;
+
+private:
+    // Loop delivering frames until destruction.
+    void main_loop();
+
+    // Take next frame to deliver, waiting until there is one. Returns false when stopping.
+    bool pop(Frame& frame);
+
+    // Ring of frames, one slot is kept empty to tell full from empty.
+    std::vector<Frame> ring_;
+    std::atomic<std::size_t> head_;
+    std::atomic<std::size_t> tail_;
+
+    // Delivery policy and functions.
+    picam_delivery_t policy_;
+    Deliver deliver_;
+    Release release_;
+
+    // Frames discarded by the producer and skipped by the worker.
+    std::atomic<std::uint32_t> discarded_;
+    std::atomic<std::uint32_t> skipped_;
+
+    // Used to sleep while the ring is empty. Producer only locks when worker is sleeping.
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> sleeping_;
+
+    // Used to indicate if thread should keep running or stop.
+    std::atomic<bool> keep_running_;
+
+    // Thread responsible for delivery.
+    std::thread worker_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_PIPELINE_H
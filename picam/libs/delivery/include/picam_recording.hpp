@@ -0,0 +1,133 @@
+#ifndef PICAM_RECORDING_H
+#define PICAM_RECORDING_H
+
+#include "picam_defines.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+class File;
+
+/*************************************************************************************************/
+
+// Frames are recorded into a single file made of (all values native endian):
+//   - RecordingHeader.
+//   - Frames appended one after the other, each one a FrameRecord followed by its data.
+//   - Index with the offset of every frame, written when the recorder is closed.
+// Records and data are aligned to 64 bytes, so mapped frames keep the alignment of camera buffers.
+// Files without index (recorder not closed) are indexed on open by walking the records.
+
+struct RecordingHeader
+{
+    char magic[8];                  // "PICAMREC"
+    std::uint32_t version;
+    std::uint32_t header_size;      // Offset of first frame.
+    std::uint64_t frame_count;      // Entries of the index, zero if there isn't one.
+    std::uint64_t index_offset;     // Offset of the index, zero if there isn't one.
+};
+
+struct FrameRecord
+{
+    std::uint32_t magic;            // "PCFR"
+    std::uint32_t record_size;      // Header and data with padding, offset of next record.
+    std::uint32_t format;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t bytes_per_line;
+    std::uint32_t data_size;
+    std::uint32_t num_planes;
+    std::uint32_t planes[2 * PICAM_MAX_PLANES];
+    std::uint64_t timestamp;
+    std::uint64_t sequence;
+    std::uint32_t dropped;
+    std::uint32_t lost;
+};
+
+/*************************************************************************************************/
+
+// Stream frames into a new recording file through a memory mapped window that slides over it,
+// so the address space used doesn't depend on the length of the recording.
+class Recorder
+{
+public:
+    // Create file, replacing any existing one. Throws Jaw::Exception if it can't be written.
+    Recorder(const std::string& path);
+
+    // Write index and close file.
+    ~Recorder();
+
+    // Append image to the file. Throws Jaw::Exception if file can't grow.
+    // Must be called always from the same thread.
+    void write(const picam_image_t& image);
+
+    // Sink callback writing image into the recorder passed as user data.
+    static void callback(void* user_data, picam_image_t* image);
+
+private:
+    // Map a window of at least size bytes starting at the end of the file written so far.
+    void map_window(std::size_t size);
+
+    // Unmap current window, if any.
+    void unmap_window();
+
+    // File written.
+    std::unique_ptr<File> file_;
+
+    // Window mapped and its position in the file.
+    unsigned char* window_;
+    std::uint64_t window_offset_;
+    std::size_t window_size_;
+
+    // Bytes written so far.
+    std::uint64_t size_;
+
+    // Offset of every frame written.
+    std::vector<std::uint64_t> index_;
+};
+
+/*************************************************************************************************/
+
+// Recording file mapped in memory, frames point to the mapping and are never copied.
+// Mapping is private, so consumers writing into frames don't change the file.
+class Recording
+{
+public:
+    // Map file and load its index. Throws Jaw::Exception if it isn't a valid recording.
+    Recording(const std::string& path);
+
+    // Unmap file, frames returned are no longer valid.
+    ~Recording();
+
+    // Number of frames.
+    std::size_t size() const;
+
+    // Image of frame at index, pointing to the mapping.
+    picam_image_t frame(std::size_t index) const;
+
+private:
+    // Find frames walking the records, used when the index is missing or invalid.
+    void scan();
+
+    // Returns true if a valid record starts at offset.
+    bool valid_record(std::uint64_t offset) const;
+
+    // File mapped in memory.
+    unsigned char* data_;
+    std::size_t size_;
+
+    // Offset of every frame.
+    std::vector<std::uint64_t> index_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_RECORDING_H
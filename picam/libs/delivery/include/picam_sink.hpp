@@ -0,0 +1,71 @@
+#ifndef PICAM_SINK_H
+#define PICAM_SINK_H
+
+#include "picam_defines.h"
+#include "picam_pipeline.hpp"
+#include "picam_frame.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Consumer of frames with its own rate limit and delivery thread.
+// Accepted frames are copied into buffers owned by the sink, so a slow callback only makes this
+// sink drop frames and never stalls whoever offers them.
+class Sink
+{
+public:
+    // Start delivery thread. Throws Jaw::Exception if callback is missing or rate is invalid.
+    Sink(const picam_sink_config_t& config, void* user_data, picam_callback_t callback);
+
+    // Stop delivery thread, waiting for the frame being delivered.
+    ~Sink();
+
+    // Offer frame to the sink, copying it if accepted by the rate limits.
+    // Must be called always from the same thread.
+    void offer(const picam_image_t& image);
+
+private:
+    // Returns true if frame should be delivered according to decimation and max_fps.
+    bool accept(const picam_image_t& image);
+
+    // Rate limits and delivery configuration.
+    picam_sink_config_t config_;
+
+    // User supplied data and callback.
+    void* user_data_;
+    picam_callback_t callback_;
+
+    // Frames offered so far, used for decimation.
+    std::uint64_t offered_;
+
+    // Timestamp from which next frame can be delivered when max_fps is set.
+    std::uint64_t next_timestamp_;
+
+    // Frames not accepted by rate limits or without free buffer.
+    std::uint32_t skipped_;
+
+    // Buffer accepted frames are copied into.
+    struct Buffer : public FrameBuffer
+    {
+        std::vector<unsigned char> data;
+    };
+
+    // Buffers used in turn, skipping the ones still delivered or acquired.
+    std::unique_ptr<Buffer[]> buffers_;
+    unsigned int num_buffers_;
+    unsigned int next_buffer_;
+
+    // Deliver copied frames. Destroyed first, so buffers are released before being freed.
+    std::unique_ptr<FramePipeline> pipeline_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_SINK_H
@@ -0,0 +1,64 @@
+#ifndef PICAM_FILE_H
+#define PICAM_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// File accessed by offset and through memory mappings, hiding the system calls of each platform.
+// Methods throw Jaw::Exception if the system call fails.
+class File
+{
+public:
+    // How the file is opened.
+    enum class Mode
+    {
+        CREATE,     // Create file for reading and writing, replacing any existing one.
+        READ,       // Open existing file for reading.
+    };
+
+    // Open file at path.
+    File(const std::string& path, Mode mode);
+
+    // Close file, mappings remain valid until unmapped.
+    ~File();
+
+    // Can't copy file.
+    File(const File&) = delete;
+
+    // Current size of the file.
+    std::uint64_t size() const;
+
+    // Grow or shrink file to size. Must not be mapped while shrinking.
+    void resize(std::uint64_t size);
+
+    // Write size bytes of data at offset.
+    void write(const void* data, std::size_t size, std::uint64_t offset);
+
+    // Map size bytes starting at offset, which must be a multiple of granularity().
+    // Files created are mapped shared, so writes reach the file. Files opened for reading are mapped
+    // copy on write, so writes to the mapping never change the file.
+    unsigned char* map(std::uint64_t offset, std::size_t size);
+
+    // Unmap data returned by map, sequential hints that it will be read in order.
+    static void unmap(unsigned char* data, std::size_t size);
+    static void sequential(unsigned char* data, std::size_t size);
+
+    // Alignment required for offsets of mappings.
+    static std::uint64_t granularity();
+
+private:
+    // Descriptor or handle of the file, depending on the platform.
+    std::intptr_t handle_;
+    Mode mode_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_FILE_H
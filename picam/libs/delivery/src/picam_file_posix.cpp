@@ -0,0 +1,108 @@
+#include "picam_file.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Exception built from errno of the last system call.
+static Jaw::Exception system_error(const std::string& detail)
+{
+    return Jaw::Exception(static_cast<std::errc>(errno), detail);
+}
+
+/*************************************************************************************************/
+
+File::File(const std::string& path, Mode mode)
+    : handle_(-1)
+    , mode_(mode)
+{
+    const int flags = (mode == Mode::CREATE) ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY;
+    const int fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        throw system_error("Unable to open " + path);
+    }
+    handle_ = fd;
+}
+
+/*************************************************************************************************/
+
+File::~File()
+{
+    ::close(static_cast<int>(handle_));
+}
+
+/*************************************************************************************************/
+
+std::uint64_t File::size() const
+{
+    struct stat status;
+    if (::fstat(static_cast<int>(handle_), &status) != 0) {
+        throw system_error("Unable to get file size");
+    }
+    return static_cast<std::uint64_t>(status.st_size);
+}
+
+/*************************************************************************************************/
+
+void File::resize(std::uint64_t size)
+{
+    if (::ftruncate(static_cast<int>(handle_), static_cast<off_t>(size)) != 0) {
+        throw system_error("Unable to resize file");
+    }
+}
+
+/*************************************************************************************************/
+
+void File::write(const void* data, std::size_t size, std::uint64_t offset)
+{
+    if (::pwrite(static_cast<int>(handle_), data, size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size)) {
+        throw system_error("Unable to write file");
+    }
+}
+
+/*************************************************************************************************/
+
+unsigned char* File::map(std::uint64_t offset, std::size_t size)
+{
+    const int sharing = (mode_ == Mode::CREATE) ? MAP_SHARED : MAP_PRIVATE;
+    void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, sharing, static_cast<int>(handle_),
+                        static_cast<off_t>(offset));
+    if (data == MAP_FAILED) {
+        throw system_error("Unable to map file");
+    }
+    return static_cast<unsigned char*>(data);
+}
+
+/*************************************************************************************************/
+
+void File::unmap(unsigned char* data, std::size_t size)
+{
+    ::munmap(data, size);
+}
+
+/*************************************************************************************************/
+
+void File::sequential(unsigned char* data, std::size_t size)
+{
+    ::madvise(data, size, MADV_SEQUENTIAL);
+}
+
+/*************************************************************************************************/
+
+std::uint64_t File::granularity()
+{
+    return static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,122 @@
+#include "picam_file.hpp"
+
+#include "jaw_exception.hpp"
+
+#ifndef NOMINMAX
+# define NOMINMAX
+#endif
+#include <windows.h>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Exception for the last system call, Windows error codes don't map to errno values.
+static Jaw::Exception system_error(const std::string& detail)
+{
+    return Jaw::Exception(std::errc::io_error, detail + " (error " + std::to_string(::GetLastError()) + ")");
+}
+
+/*************************************************************************************************/
+
+File::File(const std::string& path, Mode mode)
+    : handle_(reinterpret_cast<std::intptr_t>(INVALID_HANDLE_VALUE))
+    , mode_(mode)
+{
+    const DWORD access = (mode == Mode::CREATE) ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+    const DWORD disposition = (mode == Mode::CREATE) ? CREATE_ALWAYS : OPEN_EXISTING;
+    HANDLE file = ::CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr, disposition,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw system_error("Unable to open " + path);
+    }
+    handle_ = reinterpret_cast<std::intptr_t>(file);
+}
+
+/*************************************************************************************************/
+
+File::~File()
+{
+    ::CloseHandle(reinterpret_cast<HANDLE>(handle_));
+}
+
+/*************************************************************************************************/
+
+std::uint64_t File::size() const
+{
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(reinterpret_cast<HANDLE>(handle_), &size)) {
+        throw system_error("Unable to get file size");
+    }
+    return static_cast<std::uint64_t>(size.QuadPart);
+}
+
+/*************************************************************************************************/
+
+void File::resize(std::uint64_t size)
+{
+    FILE_END_OF_FILE_INFO info;
+    info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+    if (!::SetFileInformationByHandle(reinterpret_cast<HANDLE>(handle_), FileEndOfFileInfo, &info, sizeof(info))) {
+        throw system_error("Unable to resize file");
+    }
+}
+
+/*************************************************************************************************/
+
+void File::write(const void* data, std::size_t size, std::uint64_t offset)
+{
+    OVERLAPPED position = {};
+    position.Offset = static_cast<DWORD>(offset);
+    position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD written = 0;
+    if (!::WriteFile(reinterpret_cast<HANDLE>(handle_), data, static_cast<DWORD>(size), &written, &position) ||
+        written != size) {
+        throw system_error("Unable to write file");
+    }
+}
+
+/*************************************************************************************************/
+
+unsigned char* File::map(std::uint64_t offset, std::size_t size)
+{
+    // View keeps the mapping alive, so its handle is closed right away.
+    const bool shared = (mode_ == Mode::CREATE);
+    HANDLE mapping = ::CreateFileMappingA(reinterpret_cast<HANDLE>(handle_), nullptr,
+                                          shared ? PAGE_READWRITE : PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!mapping) {
+        throw system_error("Unable to map file");
+    }
+    void* data = ::MapViewOfFile(mapping, shared ? FILE_MAP_WRITE : FILE_MAP_COPY,
+                                 static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), size);
+    ::CloseHandle(mapping);
+    if (!data) {
+        throw system_error("Unable to map file");
+    }
+    return static_cast<unsigned char*>(data);
+}
+
+/*************************************************************************************************/
+
+void File::unmap(unsigned char* data, std::size_t)
+{
+    ::UnmapViewOfFile(data);
+}
+
+/*************************************************************************************************/
+
+void File::sequential(unsigned char*, std::size_t)
+{}
+
+/*************************************************************************************************/
+
+std::uint64_t File::granularity()
+{
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+
+/*************************************************************************************************/
+
+}
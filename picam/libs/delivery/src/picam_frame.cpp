@@ -0,0 +1,98 @@
+#include "picam_frame.hpp"
+#include "picam_imgproc.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+FrameBuffer::FrameBuffer()
+    : references_(0)
+{}
+
+/*************************************************************************************************/
+
+FrameBuffer::~FrameBuffer()
+{}
+
+/*************************************************************************************************/
+
+void FrameBuffer::acquire()
+{
+    references_++;
+}
+
+/*************************************************************************************************/
+
+void FrameBuffer::release()
+{
+    // Nothing can be accessed after recycle, as buffer might be gone.
+    if (--references_ == 0) {
+        recycle();
+    }
+}
+
+/*************************************************************************************************/
+
+bool FrameBuffer::busy() const
+{
+    return references_ > 0;
+}
+
+/*************************************************************************************************/
+
+void FrameBuffer::recycle()
+{}
+
+/*************************************************************************************************/
+
+// Buffer holding a copy of an image that has no buffer of its own.
+class CopyBuffer : public FrameBuffer
+{
+public:
+    CopyBuffer(std::size_t size)
+        : data(size)
+    {}
+
+    std::vector<unsigned char> data;
+
+protected:
+    void recycle() override
+    {
+        delete this;
+    }
+};
+
+/*************************************************************************************************/
+
+picam_image_t* acquire_frame(const picam_image_t& image)
+{
+    std::unique_ptr<picam_image_t> frame(new picam_image_t(image));
+
+    FrameBuffer* buffer = static_cast<FrameBuffer*>(image.buffer);
+    if (buffer) {
+        buffer->acquire();
+        return frame.release();
+    }
+
+    std::unique_ptr<CopyBuffer> copy(new CopyBuffer(image_size(image.format, image.width, image.height)));
+    frame->data = copy->data.data();
+    crop(image, { 0, 0, image.width, image.height }, *frame);
+    frame->buffer = copy.get();
+    copy.release()->acquire();
+    return frame.release();
+}
+
+/*************************************************************************************************/
+
+void release_frame(picam_image_t* frame)
+{
+    static_cast<FrameBuffer*>(frame->buffer)->release();
+    delete frame;
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,130 @@
+#include "picam_pipeline.hpp"
+
+#include <iostream>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+FramePipeline::FramePipeline(unsigned int depth, picam_delivery_t policy, Deliver deliver, Release release)
+    : ring_((depth ? depth : DEFAULT_DEPTH) + 1)
+    , head_(0)
+    , tail_(0)
+    , policy_(policy)
+    , deliver_(deliver)
+    , release_(release)
+    , discarded_(0)
+    , skipped_(0)
+    , mutex_()
+    , wake_()
+    , sleeping_(false)
+    , keep_running_(true)
+    , worker_(&FramePipeline::main_loop, this)
+{}
+
+/*************************************************************************************************/
+
+FramePipeline::~FramePipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        keep_running_ = false;
+        wake_.notify_one();
+    }
+    worker_.join();
+
+    // Give back buffers of frames still waiting.
+    for (std::size_t tail = tail_; tail != head_; tail = (tail + 1) % ring_.size()) {
+        release_(ring_[tail].handle);
+    }
+}
+
+/*************************************************************************************************/
+
+bool FramePipeline::push(void* handle, const picam_image_t& image)
+{
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t next = (head + 1) % ring_.size();
+
+    // Worker is late and ring is full, newest frames are discarded here.
+    // With NEWEST policy the worker skips to the last frame, so it only happens while it is busy.
+    if (next == tail_.load(std::memory_order_acquire)) {
+        discarded_++;
+        release_(handle);
+        return false;
+    }
+
+    // Frames carry the drops that happened before them, so counts are exact for consumers.
+    ring_[head].handle = handle;
+    ring_[head].image = image;
+    ring_[head].image.dropped += discarded_;
+    head_.store(next);
+
+    // Only wake worker if it is waiting for frames.
+    if (sleeping_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_.notify_one();
+    }
+    return true;
+}
+
+/*************************************************************************************************/
+
+std::uint32_t FramePipeline::dropped() const
+{
+    return discarded_ + skipped_;
+}
+
+/*************************************************************************************************/
+
+bool FramePipeline::pop(Frame& frame)
+{
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+    while (tail == head_.load()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!keep_running_) {
+            return false;
+        }
+        sleeping_ = true;
+        if (tail == head_.load()) {
+            wake_.wait(lock);
+        }
+        sleeping_ = false;
+    }
+
+    // Skip to the newest frame, releasing older ones.
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    if (policy_ == PICAM_DELIVERY_NEWEST) {
+        const std::size_t last = (head + ring_.size() - 1) % ring_.size();
+        for (; tail != last; tail = (tail + 1) % ring_.size()) {
+            skipped_++;
+            release_(ring_[tail].handle);
+        }
+    }
+
+    frame = ring_[tail];
+    tail_.store((tail + 1) % ring_.size(), std::memory_order_release);
+    return true;
+}
+
+/*************************************************************************************************/
+
+void FramePipeline::main_loop()
+{
+    Frame frame;
+    while (keep_running_ && pop(frame)) {
+        // Skipped frames are older than the one being delivered.
+        frame.image.dropped += skipped_;
+        try {
+            deliver_(frame);
+        } catch (...) {
+            std::cerr << "Frame delivery triggered an exception." << std::endl;
+        }
+        release_(frame.handle);
+    }
+}
+
+/*************************************************************************************************/
+
+}
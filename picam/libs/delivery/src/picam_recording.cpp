@@ -0,0 +1,292 @@
+#include "picam_recording.hpp"
+#include "picam_file.hpp"
+#include "picam_imgproc.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+static const char kRecordingMagic[8] = { 'P', 'I', 'C', 'A', 'M', 'R', 'E', 'C' };
+static const std::uint32_t kRecordingVersion = 1;
+static const std::uint32_t kFrameMagic = 0x52464350; // "PCFR"
+
+// Alignment of records and frame data.
+static const std::size_t kAlignment = 64;
+
+// Minimum size of the window mapped while recording.
+static const std::size_t kWindowSize = 32 * 1024 * 1024;
+
+/*************************************************************************************************/
+
+static std::uint64_t align(std::uint64_t value)
+{
+    return (value + kAlignment - 1) & ~static_cast<std::uint64_t>(kAlignment - 1);
+}
+
+/*************************************************************************************************/
+
+// Image described by record with its data.
+static picam_image_t record_image(const FrameRecord& record, unsigned char* data)
+{
+    picam_image_t image = {};
+    image.format = static_cast<picam_image_format_t>(record.format);
+    image.width = record.width;
+    image.height = record.height;
+    image.bytes_per_line = record.bytes_per_line;
+    image.data_size = record.data_size;
+    image.data = data;
+    image.num_planes = record.num_planes;
+    for (unsigned int i = 0; i < PICAM_MAX_PLANES; i++) {
+        image.planes[i].offset = record.planes[2 * i];
+        image.planes[i].bytes_per_line = record.planes[2 * i + 1];
+    }
+    image.timestamp = record.timestamp;
+    image.sequence = record.sequence;
+    image.dropped = record.dropped;
+    image.lost = record.lost;
+    return image;
+}
+
+/*************************************************************************************************/
+
+Recorder::Recorder(const std::string& path)
+    : file_(new File(path, File::Mode::CREATE))
+    , window_(nullptr)
+    , window_offset_(0)
+    , window_size_(0)
+    , size_(align(sizeof(RecordingHeader)))
+    , index_()
+{
+    // Header is completed on close, files left without index are still readable.
+    RecordingHeader header = {};
+    std::memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+    header.version = kRecordingVersion;
+    header.header_size = static_cast<std::uint32_t>(size_);
+    file_->write(&header, sizeof(header), 0);
+}
+
+/*************************************************************************************************/
+
+Recorder::~Recorder()
+{
+    unmap_window();
+
+    // Append index and point header to it, file is still readable without them if that fails.
+    try {
+        const std::uint64_t index_offset = size_;
+        const std::size_t index_size = index_.size() * sizeof(std::uint64_t);
+        file_->write(index_.data(), index_size, index_offset);
+        file_->resize(index_offset + index_size);
+
+        RecordingHeader header = {};
+        std::memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+        header.version = kRecordingVersion;
+        header.header_size = static_cast<std::uint32_t>(align(sizeof(RecordingHeader)));
+        header.frame_count = index_.size();
+        header.index_offset = index_offset;
+        file_->write(&header, sizeof(header), 0);
+    } catch (const Jaw::Exception&) {
+    }
+}
+
+/*************************************************************************************************/
+
+void Recorder::write(const picam_image_t& image)
+{
+    const std::size_t data_size = image.data_size ? image.data_size : image_size(image.format, image.width, image.height);
+    const std::size_t header_size = align(sizeof(FrameRecord));
+    const std::size_t record_size = header_size + align(data_size);
+
+    if (!window_ || size_ + record_size > window_offset_ + window_size_) {
+        map_window(record_size);
+    }
+
+    unsigned char* record = window_ + (size_ - window_offset_);
+
+    FrameRecord header = {};
+    header.magic = kFrameMagic;
+    header.record_size = static_cast<std::uint32_t>(record_size);
+    header.format = image.format;
+    header.width = image.width;
+    header.height = image.height;
+    header.bytes_per_line = image.bytes_per_line;
+    header.data_size = static_cast<std::uint32_t>(data_size);
+    header.num_planes = image.num_planes;
+    for (unsigned int i = 0; i < PICAM_MAX_PLANES; i++) {
+        header.planes[2 * i] = image.planes[i].offset;
+        header.planes[2 * i + 1] = image.planes[i].bytes_per_line;
+    }
+    header.timestamp = image.timestamp;
+    header.sequence = image.sequence;
+    header.dropped = image.dropped;
+    header.lost = image.lost;
+
+    std::memcpy(record + header_size, image.data, data_size);
+    std::memcpy(record, &header, sizeof(header));
+
+    index_.push_back(size_);
+    size_ += record_size;
+}
+
+/*************************************************************************************************/
+
+void Recorder::callback(void* user_data, picam_image_t* image)
+{
+    static_cast<Recorder*>(user_data)->write(*image);
+}
+
+/*************************************************************************************************/
+
+void Recorder::map_window(std::size_t size)
+{
+    unmap_window();
+
+    // Window starts at the page holding the end of the file.
+    const std::uint64_t page = File::granularity();
+    const std::uint64_t offset = size_ - size_ % page;
+    const std::size_t window_size = std::max(kWindowSize, static_cast<std::size_t>(size + page));
+
+    // File grows a window at a time and is truncated to the written size on close.
+    file_->resize(offset + window_size);
+    window_ = file_->map(offset, window_size);
+    window_offset_ = offset;
+    window_size_ = window_size;
+}
+
+/*************************************************************************************************/
+
+void Recorder::unmap_window()
+{
+    if (window_) {
+        File::unmap(window_, window_size_);
+        window_ = nullptr;
+    }
+}
+
+/*************************************************************************************************/
+
+Recording::Recording(const std::string& path)
+    : data_(nullptr)
+    , size_(0)
+    , index_()
+{
+    {
+        // Mapping stays valid after closing the file.
+        File file(path, File::Mode::READ);
+        const std::uint64_t size = file.size();
+        if (size < sizeof(RecordingHeader) || size > std::numeric_limits<std::size_t>::max()) {
+            throw Jaw::Exception(std::errc::invalid_argument, "Invalid recording " + path);
+        }
+        size_ = static_cast<std::size_t>(size);
+        data_ = file.map(0, size_);
+    }
+    File::sequential(data_, size_);
+
+    RecordingHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, kRecordingMagic, sizeof(header.magic)) != 0 ||
+        header.version != kRecordingVersion) {
+        File::unmap(data_, size_);
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid recording " + path);
+    }
+
+    // Use index if it is consistent with the file, otherwise find the frames again.
+    const std::uint64_t index_size = header.frame_count * sizeof(std::uint64_t);
+    if (header.index_offset && header.index_offset <= size_ && index_size <= size_ - header.index_offset) {
+        index_.resize(header.frame_count);
+        std::memcpy(index_.data(), data_ + header.index_offset, index_size);
+    }
+    if (!std::all_of(index_.begin(), index_.end(), [this](std::uint64_t offset) { return valid_record(offset); })) {
+        index_.clear();
+    }
+    if (index_.empty()) {
+        scan();
+    }
+}
+
+/*************************************************************************************************/
+
+Recording::~Recording()
+{
+    File::unmap(data_, size_);
+}
+
+/*************************************************************************************************/
+
+std::size_t Recording::size() const
+{
+    return index_.size();
+}
+
+/*************************************************************************************************/
+
+picam_image_t Recording::frame(std::size_t index) const
+{
+    FrameRecord record;
+    std::memcpy(&record, data_ + index_[index], sizeof(record));
+    return record_image(record, data_ + index_[index] + align(sizeof(FrameRecord)));
+}
+
+/*************************************************************************************************/
+
+void Recording::scan()
+{
+    RecordingHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+
+    // Stop at the first invalid record, which is the end of a recording that wasn't closed.
+    for (std::uint64_t offset = align(header.header_size); valid_record(offset);) {
+        index_.push_back(offset);
+        FrameRecord record;
+        std::memcpy(&record, data_ + offset, sizeof(record));
+        offset += record.record_size;
+    }
+}
+
+/*************************************************************************************************/
+
+bool Recording::valid_record(std::uint64_t offset) const
+{
+    if (offset % kAlignment != 0 || offset > size_ || size_ - offset < sizeof(FrameRecord)) {
+        return false;
+    }
+
+    FrameRecord record;
+    std::memcpy(&record, data_ + offset, sizeof(record));
+    if (record.magic != kFrameMagic ||
+        record.record_size < align(sizeof(FrameRecord)) + record.data_size ||
+        record.record_size > size_ - offset ||
+        record.format > PICAM_IMAGE_FORMAT_NV12 ||
+        record.num_planes > PICAM_MAX_PLANES ||
+        record.data_size < image_size(static_cast<picam_image_format_t>(record.format), record.width, record.height)) {
+        return false;
+    }
+
+    // Every line of every plane must be inside the data, so playback never reads past the mapping.
+    unsigned char* data = data_ + offset + align(sizeof(FrameRecord));
+    const picam_image_t image = record_image(record, data);
+    Plane planes[3];
+    const unsigned int count = image_planes(image, planes);
+    auto inside = [&record](std::uint64_t start, std::uint64_t line, unsigned int bytes_per_line, unsigned int height) {
+        return height == 0 ||
+               (bytes_per_line >= line && start + std::uint64_t(bytes_per_line) * (height - 1) + line <= record.data_size);
+    };
+    for (unsigned int i = 0; i < count; i++) {
+        const std::uint64_t line = std::uint64_t(planes[i].width) * planes[i].channels;
+        if (!inside(planes[i].data - data, line, planes[i].bytes_per_line, planes[i].height)) {
+            return false;
+        }
+    }
+    const std::uint64_t line = std::uint64_t(record.width) * bytes_per_pixel(image.format);
+    return inside(0, line, record.bytes_per_line, record.height);
+}
+
+/*************************************************************************************************/
+
+}
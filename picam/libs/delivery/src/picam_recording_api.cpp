@@ -0,0 +1,54 @@
+#include "picam_api.h"
+
+#include <system_error>
+
+#include "jaw_protected_call.hpp"
+#include "picam_recording.hpp"
+
+using namespace PiCam;
+using namespace Jaw;
+
+// Recorder entry points are the same for local and remote cameras, so both libraries link these.
+
+/*************************************************************************************************/
+
+int picam_recorder_create(picam_recorder_t* recorder, const char* path)
+{
+    if (!recorder || !path) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return protected_call([&recorder, &path]() {
+        *recorder = static_cast<picam_recorder_t>(new Recorder(path));
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+int picam_recorder_destroy(picam_recorder_t recorder)
+{
+    Recorder* precorder = static_cast<Recorder*>(recorder);
+    if (precorder == nullptr) {
+        return static_cast<int>(std::errc::invalid_argument);
+    }
+    return protected_call([&precorder]() {
+        delete precorder;
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
+
+void picam_recorder_callback(void* recorder, picam_image_t* image)
+{
+    // Exceptions can't cross the C boundary, a frame that can't be written is reported and dropped.
+    if (!recorder || !image) {
+        return;
+    }
+    protected_call([&recorder, &image]() {
+        Recorder::callback(recorder, image);
+        return 0;
+    });
+}
+
+/*************************************************************************************************/
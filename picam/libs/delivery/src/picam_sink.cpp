@@ -0,0 +1,116 @@
+#include "picam_sink.hpp"
+#include "picam_imgproc.hpp"
+
+#include "jaw_exception.hpp"
+
+#include <algorithm>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+Sink::Sink(const picam_sink_config_t& config, void* user_data, picam_callback_t callback)
+    : config_(config)
+    , user_data_(user_data)
+    , callback_(callback)
+    , offered_(0)
+    , next_timestamp_(0)
+    , skipped_(0)
+    , buffers_()
+    , num_buffers_(0)
+    , next_buffer_(0)
+    , pipeline_()
+{
+    if (!callback_) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Sink requires a callback");
+    }
+    if (config_.max_fps < 0.0) {
+        throw Jaw::Exception(std::errc::invalid_argument, "Invalid sink frame rate");
+    }
+
+    // Enough buffers for the frames waiting, the one being delivered and the one being copied.
+    const unsigned int depth = config_.queue_depth ? config_.queue_depth : FramePipeline::DEFAULT_DEPTH;
+    num_buffers_ = depth + 2;
+    buffers_.reset(new Buffer[num_buffers_]);
+
+    pipeline_.reset(new FramePipeline(depth, config_.delivery,
+        [this](FramePipeline::Frame& frame) {
+            callback_(user_data_, &frame.image);
+        },
+        [](void* handle) {
+            static_cast<FrameBuffer*>(handle)->release();
+        }));
+}
+
+/*************************************************************************************************/
+
+Sink::~Sink()
+{
+    pipeline_.reset();
+}
+
+/*************************************************************************************************/
+
+void Sink::offer(const picam_image_t& image)
+{
+    if (!accept(image)) {
+        skipped_++;
+        return;
+    }
+
+    // Find a free buffer, there is always one unless consumers hold acquired frames.
+    unsigned int index = next_buffer_;
+    for (unsigned int i = 0; i < num_buffers_ && buffers_[index].busy(); i++) {
+        index = (index + 1) % num_buffers_;
+    }
+    if (buffers_[index].busy()) {
+        skipped_++;
+        return;
+    }
+    next_buffer_ = (index + 1) % num_buffers_;
+
+    // Buffer only grows, so there are no allocations after the first frame.
+    Buffer& buffer = buffers_[index];
+    const std::size_t size = image_size(image.format, image.width, image.height);
+    if (buffer.data.size() < size) {
+        buffer.data.resize(size);
+    }
+
+    picam_image_t copy;
+    copy.data = buffer.data.data();
+    crop(image, { 0, 0, image.width, image.height }, copy);
+    copy.buffer = &buffer;
+
+    // Frames skipped here are reported as dropped, the same as the ones dropped by the camera.
+    copy.dropped += skipped_;
+
+    buffer.acquire();
+    pipeline_->push(&buffer, copy);
+}
+
+/*************************************************************************************************/
+
+bool Sink::accept(const picam_image_t& image)
+{
+    if (config_.decimation > 1 && (offered_++ % config_.decimation) != 0) {
+        return false;
+    }
+
+    if (config_.max_fps > 0.0) {
+        const std::uint64_t interval = static_cast<std::uint64_t>(1.0e9 / config_.max_fps);
+
+        // Accept frames slightly early, so timestamp jitter doesn't skip a whole frame period.
+        if (image.timestamp + interval / 8 < next_timestamp_) {
+            return false;
+        }
+
+        // Don't try to catch up after a long gap between frames.
+        next_timestamp_ = std::max(next_timestamp_ + interval, image.timestamp + interval - interval / 8);
+    }
+
+    return true;
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,131 @@
+#ifndef PICAM_IMGPROC_H
+#define PICAM_IMGPROC_H
+
+#include "picam_defines.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Number of interleaved bytes used by each pixel of supplied format (luma only for planar formats).
+unsigned int bytes_per_pixel(picam_image_format_t format);
+
+// Returns true for formats storing YUV 4:2:0 in separate planes. Their width and height must be even.
+bool is_planar(picam_image_format_t format);
+
+// Size in bytes of an image without line padding with supplied format and dimensions.
+unsigned int image_size(picam_image_format_t format, unsigned int width, unsigned int height);
+
+// Single plane of an image.
+struct Plane
+{
+    unsigned char* data;
+    unsigned int width;
+    unsigned int height;
+    unsigned int bytes_per_line;
+    unsigned int channels;
+};
+
+// Split image in its planes returning how many there are (1 for interleaved formats).
+// Uses the image plane descriptors, or the default layout when num_planes is zero.
+unsigned int image_planes(const picam_image_t& image, Plane planes[3]);
+
+// Fill plane descriptors of image with the default layout, where planes follow each other:
+//   - I420: U and V planes with half luma stride, one after another.
+//   - NV12: Interleaved UV plane with the same stride as luma.
+void set_planes(picam_image_t& image);
+
+// Returns true if lines and planes of image are stored without any padding between them.
+bool is_compact(const picam_image_t& image);
+
+// Copy frame metadata (timestamp, sequence and drop counters) between images.
+// All functions producing an image from another one keep its metadata.
+void copy_metadata(const picam_image_t& from, picam_image_t& to);
+
+/*************************************************************************************************/
+
+// Reduce input to half its width and height, averaging each block of 2x2 pixels.
+// Odd last column and row are discarded (planar images keep even dimensions). Output data must hold
+// image_size of the reduced image, remaining output fields are updated with its layout (without padding).
+void downscale_half(const picam_image_t& input, picam_image_t& output);
+
+/*************************************************************************************************/
+
+// Region of an image in pixels.
+struct PixelRect
+{
+    unsigned int x;
+    unsigned int y;
+    unsigned int width;
+    unsigned int height;
+};
+
+// Convert normalized ROI to the region it covers on an image with supplied dimensions.
+// Borders are rounded to nearest pixel and clamped to the image.
+// For planar formats the region is aligned to even coordinates.
+PixelRect roi_to_rect(const picam_roi_t& roi, picam_image_format_t format, unsigned int width, unsigned int height);
+
+// Copy region of input into output. Output data must hold image_size of the region, remaining
+// output fields are updated with the cropped image layout (without padding).
+void crop(const picam_image_t& input, const PixelRect& rect, picam_image_t& output);
+
+/*************************************************************************************************/
+
+// Returns true if images can be converted between supplied formats.
+bool can_convert(picam_image_format_t from, picam_image_format_t to);
+
+// Convert input to supplied format. Output data must hold image_size of the converted image,
+// remaining output fields are updated with its layout (without padding).
+// Colors are converted using BT.601 full range coefficients (the same as JPEG).
+// Returns false, without touching output, if conversion is not supported.
+bool convert(const picam_image_t& input, picam_image_format_t format, picam_image_t& output);
+
+/*************************************************************************************************/
+
+// Sum absolute differences between gray planes a and b (same dimensions) over blocks of 8x8 pixels,
+// storing one sum per block, row by row. Pixels past the last whole block are ignored.
+void block_differences(const Plane& a, const Plane& b, unsigned int* sums);
+
+// Move each pixel of background one level towards the same pixel of frame (both gray planes with
+// the same dimensions). Background follows slow changes like a running median, without trails.
+void follow_background(const Plane& frame, const Plane& background);
+
+/*************************************************************************************************/
+
+// Count values of each channel of plane, adding them to histograms (one per channel, 256 bins each).
+// Only one of every step pixels and lines is counted, all of them when step is zero or one.
+void count_values(const Plane& plane, unsigned int step, std::uint32_t* const* histograms);
+
+/*************************************************************************************************/
+
+// Pixels this close to the borders are never corners, leaving room for the circle and 8x8 patches.
+const unsigned int kFeatureBorder = 4;
+
+// Corner found on an image, with its score.
+struct Corner
+{
+    unsigned int x;
+    unsigned int y;
+    unsigned int score;
+};
+
+// Store FAST-9 score of lines [first, last) of gray plane in scores (one per pixel, lines without
+// padding), zero where there is no corner. Corners are pixels where 9 contiguous pixels of the circle
+// of radius 3 around them are all brighter than center + threshold or all darker than center - threshold.
+// Score is the sum of the differences beyond threshold over the circle, for the side forming the arc.
+void fast_scores(const Plane& gray, unsigned int threshold, unsigned int first, unsigned int last,
+                 std::uint16_t* scores);
+
+// Add corners of lines [first, last) whose score is greater than their 8 neighbours to corners,
+// in raster order. Scores of the lines around them must be available.
+void suppress_non_maxima(const std::uint16_t* scores, unsigned int width, unsigned int height,
+                         unsigned int first, unsigned int last, std::vector<Corner>& corners);
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_IMGPROC_H
@@ -0,0 +1,637 @@
+#include "picam_imgproc.hpp"
+#include "picam_simd.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// BT.601 full range coefficients scaled by 256.
+static const int kYR = 77, kYG = 150, kYB = 29;
+static const int kUR = -43, kUG = -85, kUB = 128;
+static const int kVR = 128, kVG = -107, kVB = -21;
+
+static inline std::uint8_t luma(int r, int g, int b)
+{
+    return static_cast<std::uint8_t>((kYR * r + kYG * g + kYB * b + 128) >> 8);
+}
+
+static inline std::uint8_t clamp(int value)
+{
+    return static_cast<std::uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+static inline std::uint8_t chroma(int r, int g, int b, int kr, int kg, int kb)
+{
+    return clamp(((kr * r + kg * g + kb * b + 128) >> 8) + 128);
+}
+
+// Inverse BT.601 full range coefficients scaled by 64, small enough for 16 bit arithmetic.
+static const int kRV = 90, kGU = -22, kGV = -46, kBU = 113;
+
+/*************************************************************************************************/
+
+#if defined(PICAM_SSE2)
+
+// One step of the SSE2 transposition of 96 interleaved bytes. After five steps the bytes of each
+// channel are gathered: v[0..1] hold channel 0, v[2..3] channel 1 and v[4..5] channel 2.
+static inline void deinterleave_step(__m128i v[6])
+{
+    __m128i a0 = _mm_unpacklo_epi8(v[0], v[3]);
+    __m128i a1 = _mm_unpackhi_epi8(v[0], v[3]);
+    __m128i a2 = _mm_unpacklo_epi8(v[1], v[4]);
+    __m128i a3 = _mm_unpackhi_epi8(v[1], v[4]);
+    __m128i a4 = _mm_unpacklo_epi8(v[2], v[5]);
+    __m128i a5 = _mm_unpackhi_epi8(v[2], v[5]);
+    v[0] = a0; v[1] = a1; v[2] = a2; v[3] = a3; v[4] = a4; v[5] = a5;
+}
+
+// Inverse of deinterleave_step.
+static inline void interleave_step(__m128i v[6])
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    __m128i a0 = _mm_packus_epi16(_mm_and_si128(v[0], mask), _mm_and_si128(v[1], mask));
+    __m128i a3 = _mm_packus_epi16(_mm_srli_epi16(v[0], 8), _mm_srli_epi16(v[1], 8));
+    __m128i a1 = _mm_packus_epi16(_mm_and_si128(v[2], mask), _mm_and_si128(v[3], mask));
+    __m128i a4 = _mm_packus_epi16(_mm_srli_epi16(v[2], 8), _mm_srli_epi16(v[3], 8));
+    __m128i a2 = _mm_packus_epi16(_mm_and_si128(v[4], mask), _mm_and_si128(v[5], mask));
+    __m128i a5 = _mm_packus_epi16(_mm_srli_epi16(v[4], 8), _mm_srli_epi16(v[5], 8));
+    v[0] = a0; v[1] = a1; v[2] = a2; v[3] = a3; v[4] = a4; v[5] = a5;
+}
+
+// Load 32 interleaved three channel pixels into planar registers.
+static inline void load_deinterleaved(const std::uint8_t* src, __m128i v[6])
+{
+    for (int i = 0; i < 6; i++) {
+        v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16 * i));
+    }
+    for (int i = 0; i < 5; i++) {
+        deinterleave_step(v);
+    }
+}
+
+// Store planar registers as 32 interleaved three channel pixels.
+static inline void store_interleaved(std::uint8_t* dst, __m128i v[6])
+{
+    for (int i = 0; i < 5; i++) {
+        interleave_step(v);
+    }
+    for (int i = 0; i < 6; i++) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16 * i), v[i]);
+    }
+}
+
+// Compute 8 luma values from 16 bit channels.
+static inline __m128i luma_epi16(__m128i r, __m128i g, __m128i b)
+{
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(kYR)), _mm_mullo_epi16(g, _mm_set1_epi16(kYG)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(kYB)));
+    // Maximum is 256 * 255 + 128, it only fits as unsigned so use logical shift.
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+// Compute 8 chroma values from 16 bit channels.
+static inline __m128i chroma_epi16(__m128i r, __m128i g, __m128i b, int kr, int kg, int kb)
+{
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(kr)), _mm_mullo_epi16(g, _mm_set1_epi16(kg)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(kb)));
+    // Sum fits in int16 but adding the rounding term doesn't, so round in two steps.
+    sum = _mm_srai_epi16(_mm_add_epi16(_mm_srai_epi16(sum, 7), _mm_set1_epi16(1)), 1);
+    return _mm_add_epi16(sum, _mm_set1_epi16(128));
+}
+
+// Compute 8 channel values from 16 bit luma scaled by 64 and centered chroma.
+static inline __m128i rgb_epi16(__m128i y, __m128i u, __m128i v, int ku, int kv)
+{
+    __m128i sum = _mm_add_epi16(y, _mm_add_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(ku)),
+                                                 _mm_mullo_epi16(v, _mm_set1_epi16(kv))));
+    return _mm_srai_epi16(_mm_add_epi16(sum, _mm_set1_epi16(32)), 6);
+}
+
+#endif
+
+/*************************************************************************************************/
+
+// Swap first and third channels of a line.
+static void swap_rb_line(const std::uint8_t* src, std::uint8_t* dst, unsigned int width)
+{
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    // Each byte takes its value from 2 bytes ahead (first channel), 2 bytes behind (third channel)
+    // or stays (second channel). Masks select which case applies for 16 pixels in 3 registers.
+    static const std::uint8_t kFirst[48] = {
+        0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff,
+        0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0,
+        0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0,
+    };
+    static const std::uint8_t kSecond[48] = {
+        0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0,
+        0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff,
+        0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0,
+    };
+
+    __m128i first[3], second[3], third[3];
+    for (int k = 0; k < 3; k++) {
+        first[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kFirst + 16 * k));
+        second[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kSecond + 16 * k));
+        third[k] = _mm_andnot_si128(_mm_or_si128(first[k], second[k]), _mm_set1_epi8(-1));
+    }
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i v[3];
+        for (int k = 0; k < 3; k++) {
+            v[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * x + 16 * k));
+        }
+        for (int k = 0; k < 3; k++) {
+            // Pixels cross register boundaries, so bring bytes from neighbours.
+            __m128i ahead = _mm_srli_si128(v[k], 2);
+            __m128i behind = _mm_slli_si128(v[k], 2);
+            if (k < 2) {
+                ahead = _mm_or_si128(ahead, _mm_slli_si128(v[k + 1], 14));
+            }
+            if (k > 0) {
+                behind = _mm_or_si128(behind, _mm_srli_si128(v[k - 1], 14));
+            }
+            __m128i result = _mm_or_si128(_mm_and_si128(ahead, first[k]), _mm_and_si128(v[k], second[k]));
+            result = _mm_or_si128(result, _mm_and_si128(behind, third[k]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * x + 16 * k), result);
+        }
+    }
+#elif defined(PICAM_NEON)
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x3_t v = vld3q_u8(src + 3 * x);
+        uint8x16_t temp = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = temp;
+        vst3q_u8(dst + 3 * x, v);
+    }
+#endif
+
+    for (; x < width; x++) {
+        const std::uint8_t r = src[3 * x];
+        dst[3 * x] = src[3 * x + 2];
+        dst[3 * x + 1] = src[3 * x + 1];
+        dst[3 * x + 2] = r;
+    }
+}
+
+/*************************************************************************************************/
+
+// Compute luma of a three channel line. Red is the first channel unless swap is true.
+static void luma_line(const std::uint8_t* src, std::uint8_t* dst, unsigned int width, bool swap)
+{
+    const int ri = swap ? 2 : 0;
+    const int bi = swap ? 0 : 2;
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; x + 32 <= width; x += 32) {
+        __m128i v[6];
+        load_deinterleaved(src + 3 * x, v);
+        for (int k = 0; k < 2; k++) {
+            __m128i r = v[2 * ri + k];
+            __m128i g = v[2 + k];
+            __m128i b = v[2 * bi + k];
+            __m128i lo = luma_epi16(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = luma_epi16(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(b, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x + 16 * k), _mm_packus_epi16(lo, hi));
+        }
+    }
+#elif defined(PICAM_NEON)
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x3_t v = vld3q_u8(src + 3 * x);
+        uint8x16_t r = v.val[ri];
+        uint8x16_t g = v.val[1];
+        uint8x16_t b = v.val[bi];
+        uint16x8_t lo = vmull_u8(vget_low_u8(r), vdup_n_u8(kYR));
+        lo = vmlal_u8(lo, vget_low_u8(g), vdup_n_u8(kYG));
+        lo = vmlal_u8(lo, vget_low_u8(b), vdup_n_u8(kYB));
+        uint16x8_t hi = vmull_u8(vget_high_u8(r), vdup_n_u8(kYR));
+        hi = vmlal_u8(hi, vget_high_u8(g), vdup_n_u8(kYG));
+        hi = vmlal_u8(hi, vget_high_u8(b), vdup_n_u8(kYB));
+        vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+    }
+#endif
+
+    for (; x < width; x++) {
+        dst[x] = luma(src[3 * x + ri], src[3 * x + 1], src[3 * x + bi]);
+    }
+}
+
+/*************************************************************************************************/
+
+// Replicate gray line into three channels.
+static void gray_to_rgb_line(const std::uint8_t* src, std::uint8_t* dst, unsigned int width)
+{
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    for (; x + 32 <= width; x += 32) {
+        __m128i v[6];
+        v[0] = v[2] = v[4] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        v[1] = v[3] = v[5] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + 16));
+        store_interleaved(dst + 3 * x, v);
+    }
+#elif defined(PICAM_NEON)
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x3_t v;
+        v.val[0] = v.val[1] = v.val[2] = vld1q_u8(src + x);
+        vst3q_u8(dst + 3 * x, v);
+    }
+#endif
+
+    for (; x < width; x++) {
+        dst[3 * x] = dst[3 * x + 1] = dst[3 * x + 2] = src[x];
+    }
+}
+
+/*************************************************************************************************/
+
+// Compute chroma of two three channel lines, averaging each 2x2 block.
+// Results are written to u and v with the supplied step (1 for I420, 2 for NV12).
+static void chroma_lines(const std::uint8_t* a, const std::uint8_t* b, std::uint8_t* u, std::uint8_t* v,
+                         unsigned int step, unsigned int width, bool swap)
+{
+    const int ri = swap ? 2 : 0;
+    const int bi = swap ? 0 : 2;
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    const __m128i two = _mm_set1_epi16(2);
+
+    // Each iteration consumes 32 pixels of each line producing 16 chroma samples.
+    for (; x + 16 <= width; x += 16) {
+        __m128i va[6], vb[6];
+        load_deinterleaved(a + 6 * x, va);
+        load_deinterleaved(b + 6 * x, vb);
+
+        // Average 2x2 blocks of each channel, 8 samples per register.
+        __m128i avg[3][2];
+        for (int c = 0; c < 3; c++) {
+            for (int k = 0; k < 2; k++) {
+                __m128i pa = va[2 * c + k];
+                __m128i pb = vb[2 * c + k];
+                __m128i sum = _mm_add_epi16(_mm_and_si128(pa, mask), _mm_srli_epi16(pa, 8));
+                sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_and_si128(pb, mask), _mm_srli_epi16(pb, 8)));
+                avg[c][k] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+            }
+        }
+
+        __m128i uu[2], vv[2];
+        for (int k = 0; k < 2; k++) {
+            uu[k] = chroma_epi16(avg[ri][k], avg[1][k], avg[bi][k], kUR, kUG, kUB);
+            vv[k] = chroma_epi16(avg[ri][k], avg[1][k], avg[bi][k], kVR, kVG, kVB);
+        }
+        __m128i u8 = _mm_packus_epi16(uu[0], uu[1]);
+        __m128i v8 = _mm_packus_epi16(vv[0], vv[1]);
+
+        if (step == 1) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(u + x), u8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x), v8);
+        } else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(u + 2 * x), _mm_unpacklo_epi8(u8, v8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(u + 2 * x + 16), _mm_unpackhi_epi8(u8, v8));
+        }
+    }
+#elif defined(PICAM_NEON)
+    // Each iteration consumes 16 pixels of each line producing 8 chroma samples.
+    for (; x + 8 <= width; x += 8) {
+        uint8x16x3_t va = vld3q_u8(a + 6 * x);
+        uint8x16x3_t vb = vld3q_u8(b + 6 * x);
+
+        int16x8_t avg[3];
+        for (int c = 0; c < 3; c++) {
+            uint16x8_t sum = vaddq_u16(vpaddlq_u8(va.val[c]), vpaddlq_u8(vb.val[c]));
+            avg[c] = vreinterpretq_s16_u16(vrshrq_n_u16(sum, 2));
+        }
+
+        int16x8_t uu = vmulq_n_s16(avg[ri], kUR);
+        uu = vmlaq_n_s16(uu, avg[1], kUG);
+        uu = vmlaq_n_s16(uu, avg[bi], kUB);
+        int16x8_t vv = vmulq_n_s16(avg[ri], kVR);
+        vv = vmlaq_n_s16(vv, avg[1], kVG);
+        vv = vmlaq_n_s16(vv, avg[bi], kVB);
+
+        // Rounding shift is computed without overflowing.
+        uint8x8_t u8 = vqmovun_s16(vaddq_s16(vrshrq_n_s16(uu, 8), vdupq_n_s16(128)));
+        uint8x8_t v8 = vqmovun_s16(vaddq_s16(vrshrq_n_s16(vv, 8), vdupq_n_s16(128)));
+
+        if (step == 1) {
+            vst1_u8(u + x, u8);
+            vst1_u8(v + x, v8);
+        } else {
+            uint8x8x2_t uv = { { u8, v8 } };
+            vst2_u8(u + 2 * x, uv);
+        }
+    }
+#endif
+
+    for (; x < width; x++) {
+        int sums[3];
+        for (int c = 0; c < 3; c++) {
+            sums[c] = (a[6 * x + c] + a[6 * x + 3 + c] + b[6 * x + c] + b[6 * x + 3 + c] + 2) >> 2;
+        }
+        u[step * x] = chroma(sums[ri], sums[1], sums[bi], kUR, kUG, kUB);
+        v[step * x] = chroma(sums[ri], sums[1], sums[bi], kVR, kVG, kVB);
+    }
+}
+
+/*************************************************************************************************/
+
+// Compute a three channel line from luma and a chroma line shared by two luma lines.
+// Chroma samples are read from u and v with the supplied step (1 for I420, 2 for NV12).
+static void yuv_to_rgb_line(const std::uint8_t* y, const std::uint8_t* u, const std::uint8_t* v, unsigned int step,
+                            std::uint8_t* dst, unsigned int width, bool swap)
+{
+    const int ri = swap ? 2 : 0;
+    const int bi = swap ? 0 : 2;
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    const __m128i center = _mm_set1_epi16(128);
+
+    // Each iteration produces 32 pixels from 16 chroma samples.
+    for (; x + 32 <= width; x += 32) {
+        __m128i uu, vv;
+        if (step == 1) {
+            uu = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x / 2));
+            vv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x / 2));
+        } else {
+            __m128i uv0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+            __m128i uv1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x + 16));
+            uu = _mm_packus_epi16(_mm_and_si128(uv0, mask), _mm_and_si128(uv1, mask));
+            vv = _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8));
+        }
+
+        __m128i out[6];
+        for (int k = 0; k < 2; k++) {
+            __m128i luma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x + 16 * k));
+            __m128i cu = _mm_sub_epi16(k ? _mm_unpackhi_epi8(uu, zero) : _mm_unpacklo_epi8(uu, zero), center);
+            __m128i cv = _mm_sub_epi16(k ? _mm_unpackhi_epi8(vv, zero) : _mm_unpacklo_epi8(vv, zero), center);
+
+            // Each chroma sample covers two neighbour pixels.
+            __m128i channels[3][2];
+            for (int h = 0; h < 2; h++) {
+                __m128i yy = _mm_slli_epi16(h ? _mm_unpackhi_epi8(luma, zero) : _mm_unpacklo_epi8(luma, zero), 6);
+                __m128i su = h ? _mm_unpackhi_epi16(cu, cu) : _mm_unpacklo_epi16(cu, cu);
+                __m128i sv = h ? _mm_unpackhi_epi16(cv, cv) : _mm_unpacklo_epi16(cv, cv);
+                channels[0][h] = rgb_epi16(yy, su, sv, 0, kRV);
+                channels[1][h] = rgb_epi16(yy, su, sv, kGU, kGV);
+                channels[2][h] = rgb_epi16(yy, su, sv, kBU, 0);
+            }
+            out[2 * ri + k] = _mm_packus_epi16(channels[0][0], channels[0][1]);
+            out[2 + k] = _mm_packus_epi16(channels[1][0], channels[1][1]);
+            out[2 * bi + k] = _mm_packus_epi16(channels[2][0], channels[2][1]);
+        }
+        store_interleaved(dst + 3 * x, out);
+    }
+#elif defined(PICAM_NEON)
+    // Each iteration produces 16 pixels from 8 chroma samples.
+    for (; x + 16 <= width; x += 16) {
+        uint8x8_t u8, v8;
+        if (step == 1) {
+            u8 = vld1_u8(u + x / 2);
+            v8 = vld1_u8(v + x / 2);
+        } else {
+            uint8x8x2_t uv = vld2_u8(u + x);
+            u8 = uv.val[0];
+            v8 = uv.val[1];
+        }
+        const int16x8_t center = vdupq_n_s16(128);
+        int16x8x2_t cu = vzipq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), center),
+                                   vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), center));
+        int16x8x2_t cv = vzipq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), center),
+                                   vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), center));
+
+        uint8x16_t luma = vld1q_u8(y + x);
+        uint8x8_t channels[3][2];
+        for (int h = 0; h < 2; h++) {
+            uint8x8_t half = h ? vget_high_u8(luma) : vget_low_u8(luma);
+            int16x8_t yy = vshlq_n_s16(vreinterpretq_s16_u16(vmovl_u8(half)), 6);
+            channels[0][h] = vqrshrun_n_s16(vmlaq_n_s16(yy, cv.val[h], kRV), 6);
+            channels[1][h] = vqrshrun_n_s16(vmlaq_n_s16(vmlaq_n_s16(yy, cu.val[h], kGU), cv.val[h], kGV), 6);
+            channels[2][h] = vqrshrun_n_s16(vmlaq_n_s16(yy, cu.val[h], kBU), 6);
+        }
+        uint8x16x3_t out;
+        out.val[ri] = vcombine_u8(channels[0][0], channels[0][1]);
+        out.val[1] = vcombine_u8(channels[1][0], channels[1][1]);
+        out.val[bi] = vcombine_u8(channels[2][0], channels[2][1]);
+        vst3q_u8(dst + 3 * x, out);
+    }
+#endif
+
+    for (; x < width; x++) {
+        const int luma = y[x] * 64 + 32;
+        const int cu = u[step * (x / 2)] - 128;
+        const int cv = v[step * (x / 2)] - 128;
+        dst[3 * x + ri] = clamp((luma + kRV * cv) >> 6);
+        dst[3 * x + 1] = clamp((luma + kGU * cu + kGV * cv) >> 6);
+        dst[3 * x + bi] = clamp((luma + kBU * cu) >> 6);
+    }
+}
+
+/*************************************************************************************************/
+
+// Interleave separate U and V lines into a UV line.
+static void interleave_uv_line(const std::uint8_t* u, const std::uint8_t* v, std::uint8_t* uv, unsigned int width)
+{
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    for (; x + 16 <= width; x += 16) {
+        __m128i uu = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+        __m128i vv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * x), _mm_unpacklo_epi8(uu, vv));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * x + 16), _mm_unpackhi_epi8(uu, vv));
+    }
+#elif defined(PICAM_NEON)
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x2_t pair = { { vld1q_u8(u + x), vld1q_u8(v + x) } };
+        vst2q_u8(uv + 2 * x, pair);
+    }
+#endif
+
+    for (; x < width; x++) {
+        uv[2 * x] = u[x];
+        uv[2 * x + 1] = v[x];
+    }
+}
+
+/*************************************************************************************************/
+
+// Split a UV line into separate U and V lines.
+static void deinterleave_uv_line(const std::uint8_t* uv, std::uint8_t* u, std::uint8_t* v, unsigned int width)
+{
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    for (; x + 16 <= width; x += 16) {
+        __m128i uv0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + 2 * x));
+        __m128i uv1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + 2 * x + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(u + x), _mm_packus_epi16(_mm_and_si128(uv0, mask),
+                                                                             _mm_and_si128(uv1, mask)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x), _mm_packus_epi16(_mm_srli_epi16(uv0, 8),
+                                                                             _mm_srli_epi16(uv1, 8)));
+    }
+#elif defined(PICAM_NEON)
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x2_t pair = vld2q_u8(uv + 2 * x);
+        vst1q_u8(u + x, pair.val[0]);
+        vst1q_u8(v + x, pair.val[1]);
+    }
+#endif
+
+    for (; x < width; x++) {
+        u[x] = uv[2 * x];
+        v[x] = uv[2 * x + 1];
+    }
+}
+
+/*************************************************************************************************/
+
+// Convert from planar input (layout already validated) to any supported format.
+static void convert_planar(const picam_image_t& input, const Plane* from, const Plane* to,
+                           picam_image_format_t format)
+{
+    const unsigned int width = input.width;
+    const unsigned int step = (input.format == PICAM_IMAGE_FORMAT_NV12) ? 2 : 1;
+
+    if (format == PICAM_IMAGE_FORMAT_RGB || format == PICAM_IMAGE_FORMAT_BGR) {
+        const bool swap = (format == PICAM_IMAGE_FORMAT_BGR);
+        for (unsigned int y = 0; y < input.height; y++) {
+            const std::uint8_t* u = from[1].data + static_cast<std::size_t>(y / 2) * from[1].bytes_per_line;
+            const std::uint8_t* v = (step == 1) ? from[2].data + static_cast<std::size_t>(y / 2) * from[2].bytes_per_line
+                                                : u + 1;
+            yuv_to_rgb_line(from[0].data + static_cast<std::size_t>(y) * from[0].bytes_per_line, u, v, step,
+                            to[0].data + static_cast<std::size_t>(y) * to[0].bytes_per_line, width, swap);
+        }
+        return;
+    }
+
+    // Luma is kept by all remaining formats.
+    for (unsigned int y = 0; y < input.height; y++) {
+        std::memcpy(to[0].data + static_cast<std::size_t>(y) * to[0].bytes_per_line,
+                    from[0].data + static_cast<std::size_t>(y) * from[0].bytes_per_line, width);
+    }
+    if (format == PICAM_IMAGE_FORMAT_GRAY) {
+        return;
+    }
+
+    for (unsigned int y = 0; y < input.height / 2; y++) {
+        const std::uint8_t* a = from[1].data + static_cast<std::size_t>(y) * from[1].bytes_per_line;
+        std::uint8_t* b = to[1].data + static_cast<std::size_t>(y) * to[1].bytes_per_line;
+
+        if (format == input.format) {
+            std::memcpy(b, a, to[1].width * to[1].channels);
+            if (step == 1) {
+                std::memcpy(to[2].data + static_cast<std::size_t>(y) * to[2].bytes_per_line,
+                            from[2].data + static_cast<std::size_t>(y) * from[2].bytes_per_line, to[2].width);
+            }
+        } else if (format == PICAM_IMAGE_FORMAT_NV12) {
+            interleave_uv_line(a, from[2].data + static_cast<std::size_t>(y) * from[2].bytes_per_line, b, width / 2);
+        } else {
+            deinterleave_uv_line(a, b, to[2].data + static_cast<std::size_t>(y) * to[2].bytes_per_line, width / 2);
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+bool can_convert(picam_image_format_t from, picam_image_format_t to)
+{
+    const bool valid_from = (from == PICAM_IMAGE_FORMAT_GRAY || from == PICAM_IMAGE_FORMAT_RGB ||
+                             from == PICAM_IMAGE_FORMAT_BGR || is_planar(from));
+    const bool valid_to = (to == PICAM_IMAGE_FORMAT_GRAY || to == PICAM_IMAGE_FORMAT_RGB ||
+                           to == PICAM_IMAGE_FORMAT_BGR || is_planar(to));
+    return valid_from && valid_to;
+}
+
+/*************************************************************************************************/
+
+bool convert(const picam_image_t& input, picam_image_format_t format, picam_image_t& output)
+{
+    if (!can_convert(input.format, format)) {
+        return false;
+    }
+    if ((is_planar(format) || is_planar(input.format)) && (input.width % 2 || input.height % 2)) {
+        return false;
+    }
+
+    output.format = format;
+    output.width = input.width;
+    output.height = input.height;
+    output.bytes_per_line = input.width * bytes_per_pixel(format);
+    output.data_size = image_size(format, input.width, input.height);
+    set_planes(output);
+    copy_metadata(input, output);
+
+    Plane planes[3];
+    image_planes(output, planes);
+
+    if (is_planar(input.format)) {
+        Plane source[3];
+        image_planes(input, source);
+        convert_planar(input, source, planes, format);
+        return true;
+    }
+
+    const bool gray = (input.format == PICAM_IMAGE_FORMAT_GRAY);
+    const bool swap = (input.format == PICAM_IMAGE_FORMAT_BGR);
+    const unsigned int width = input.width;
+
+    for (unsigned int y = 0; y < input.height; y++) {
+        const std::uint8_t* src = input.data + static_cast<std::size_t>(y) * input.bytes_per_line;
+        std::uint8_t* dst = planes[0].data + static_cast<std::size_t>(y) * planes[0].bytes_per_line;
+
+        if (format == input.format) {
+            std::memcpy(dst, src, output.bytes_per_line);
+        } else if (format == PICAM_IMAGE_FORMAT_RGB || format == PICAM_IMAGE_FORMAT_BGR) {
+            if (gray) {
+                gray_to_rgb_line(src, dst, width);
+            } else {
+                swap_rb_line(src, dst, width);
+            }
+        } else if (gray) {
+            // Gray is the luma plane.
+            std::memcpy(dst, src, width);
+        } else {
+            luma_line(src, dst, width, swap);
+        }
+    }
+
+    if (!is_planar(format) || format == input.format) {
+        return true;
+    }
+
+    // Chroma is computed from pairs of lines.
+    const unsigned int step = (format == PICAM_IMAGE_FORMAT_NV12) ? 2 : 1;
+    for (unsigned int y = 0; y < input.height / 2; y++) {
+        std::uint8_t* u = planes[1].data + static_cast<std::size_t>(y) * planes[1].bytes_per_line;
+        std::uint8_t* v = (step == 1) ? planes[2].data + static_cast<std::size_t>(y) * planes[2].bytes_per_line : u + 1;
+
+        if (gray) {
+            std::memset(u, 128, planes[1].width * planes[1].channels);
+            if (step == 1) {
+                std::memset(v, 128, planes[2].width);
+            }
+        } else {
+            const std::uint8_t* a = input.data + static_cast<std::size_t>(2 * y) * input.bytes_per_line;
+            chroma_lines(a, a + input.bytes_per_line, u, v, step, width / 2, swap);
+        }
+    }
+
+    return true;
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,78 @@
+#include "picam_imgproc.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Convert normalized position to pixel, clamped to [0, size].
+static unsigned int to_pixel(float position, unsigned int size)
+{
+    const long pixel = std::lround(static_cast<double>(position) * size);
+    return static_cast<unsigned int>(std::min<long>(std::max<long>(pixel, 0), size));
+}
+
+/*************************************************************************************************/
+
+PixelRect roi_to_rect(const picam_roi_t& roi, picam_image_format_t format, unsigned int width, unsigned int height)
+{
+    // Convert both borders so adjacent regions share the same edge.
+    unsigned int left = to_pixel(roi.x, width);
+    unsigned int top = to_pixel(roi.y, height);
+    unsigned int right = std::max(left, to_pixel(roi.x + roi.width, width));
+    unsigned int bottom = std::max(top, to_pixel(roi.y + roi.height, height));
+
+    // Chroma of planar formats covers 2x2 pixels, so borders must be even.
+    if (is_planar(format)) {
+        left &= ~1u;
+        top &= ~1u;
+        right &= ~1u;
+        bottom &= ~1u;
+    }
+
+    return { left, top, right - left, bottom - top };
+}
+
+/*************************************************************************************************/
+
+void crop(const picam_image_t& input, const PixelRect& rect, picam_image_t& output)
+{
+    output.format = input.format;
+    output.width = rect.width;
+    output.height = rect.height;
+    output.bytes_per_line = rect.width * bytes_per_pixel(input.format);
+    output.data_size = image_size(output.format, output.width, output.height);
+    set_planes(output);
+    copy_metadata(input, output);
+
+    Plane source[3];
+    Plane destination[3];
+    const unsigned int count = image_planes(input, source);
+    image_planes(output, destination);
+
+    for (unsigned int i = 0; i < count; i++) {
+        // Chroma planes have half the resolution of the luma plane.
+        const unsigned int scale = (i == 0) ? 1 : 2;
+        const Plane& from = source[i];
+        const Plane& to = destination[i];
+        const std::size_t line_size = to.width * to.channels;
+
+        // Lines are contiguous in both images, memcpy already uses the widest moves available.
+        const unsigned char* line = from.data + static_cast<std::size_t>(rect.y / scale) * from.bytes_per_line +
+                                    (rect.x / scale) * from.channels;
+        unsigned char* out = to.data;
+
+        for (unsigned int y = 0; y < to.height; y++) {
+            std::memcpy(out, line, line_size);
+            line += from.bytes_per_line;
+            out += to.bytes_per_line;
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,153 @@
+#include "picam_imgproc.hpp"
+#include "picam_simd.hpp"
+
+#include <cstdint>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Average 2x2 blocks of pixels from lines a and b, starting at output pixel x.
+static void downscale_line_scalar(const std::uint8_t* a, const std::uint8_t* b, std::uint8_t* out,
+                                  unsigned int x, unsigned int width, unsigned int channels)
+{
+    for (; x < width; x++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            const unsigned int i = 2 * x * channels + c;
+            out[x * channels + c] = static_cast<std::uint8_t>((a[i] + a[i + channels] +
+                                                               b[i] + b[i + channels] + 2) >> 2);
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+// Average 2x2 blocks of a single channel line, returning the number of output pixels processed.
+static unsigned int downscale_line_gray(const std::uint8_t* a, const std::uint8_t* b, std::uint8_t* out,
+                                        unsigned int width)
+{
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    const __m128i round = _mm_set1_epi16(2);
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i sums[2];
+        for (int k = 0; k < 2; k++) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 2 * x + 16 * k));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 2 * x + 16 * k));
+            __m128i even = _mm_add_epi16(_mm_and_si128(va, mask), _mm_and_si128(vb, mask));
+            __m128i odd = _mm_add_epi16(_mm_srli_epi16(va, 8), _mm_srli_epi16(vb, 8));
+            sums[k] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(even, odd), round), 2);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(sums[0], sums[1]));
+    }
+#elif defined(PICAM_NEON)
+    for (; x + 8 <= width; x += 8) {
+        uint16x8_t sum = vaddq_u16(vpaddlq_u8(vld1q_u8(a + 2 * x)), vpaddlq_u8(vld1q_u8(b + 2 * x)));
+        vst1_u8(out + x, vrshrn_n_u16(sum, 2));
+    }
+#endif
+
+    return x;
+}
+
+/*************************************************************************************************/
+
+// Average 2x2 blocks of a three channel line, returning the number of output pixels processed.
+static unsigned int downscale_line_rgb(const std::uint8_t* a, const std::uint8_t* b, std::uint8_t* out,
+                                       unsigned int width)
+{
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    // Vertical sums are vectorized, horizontal pairs are 3 bytes apart and added afterwards.
+    const __m128i zero = _mm_setzero_si128();
+    std::uint16_t sums[48];
+
+    for (; x + 8 <= width; x += 8) {
+        for (int k = 0; k < 3; k++) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 6 * x + 16 * k));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 6 * x + 16 * k));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 16 * k), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 16 * k + 8), hi);
+        }
+        std::uint8_t* dst = out + 3 * x;
+        for (int j = 0; j < 8; j++) {
+            dst[3 * j] = static_cast<std::uint8_t>((sums[6 * j] + sums[6 * j + 3] + 2) >> 2);
+            dst[3 * j + 1] = static_cast<std::uint8_t>((sums[6 * j + 1] + sums[6 * j + 4] + 2) >> 2);
+            dst[3 * j + 2] = static_cast<std::uint8_t>((sums[6 * j + 2] + sums[6 * j + 5] + 2) >> 2);
+        }
+    }
+#elif defined(PICAM_NEON)
+    // Deinterleave channels so each one is reduced exactly like a gray line.
+    for (; x + 8 <= width; x += 8) {
+        uint8x16x3_t va = vld3q_u8(a + 6 * x);
+        uint8x16x3_t vb = vld3q_u8(b + 6 * x);
+        uint8x8x3_t result;
+        for (int c = 0; c < 3; c++) {
+            uint16x8_t sum = vaddq_u16(vpaddlq_u8(va.val[c]), vpaddlq_u8(vb.val[c]));
+            result.val[c] = vrshrn_n_u16(sum, 2);
+        }
+        vst3_u8(out + 3 * x, result);
+    }
+#endif
+
+    return x;
+}
+
+/*************************************************************************************************/
+
+// Reduce a single plane to the dimensions of output plane.
+static void downscale_plane(const Plane& input, const Plane& output)
+{
+    for (unsigned int y = 0; y < output.height; y++) {
+        const std::uint8_t* a = input.data + static_cast<std::size_t>(2 * y) * input.bytes_per_line;
+        const std::uint8_t* b = a + input.bytes_per_line;
+        std::uint8_t* out = output.data + static_cast<std::size_t>(y) * output.bytes_per_line;
+
+        unsigned int x = 0;
+        if (output.channels == 1) {
+            x = downscale_line_gray(a, b, out, output.width);
+        } else if (output.channels == 3) {
+            x = downscale_line_rgb(a, b, out, output.width);
+        }
+        downscale_line_scalar(a, b, out, x, output.width, output.channels);
+    }
+}
+
+/*************************************************************************************************/
+
+void downscale_half(const picam_image_t& input, picam_image_t& output)
+{
+    output.format = input.format;
+    output.width = input.width / 2;
+    output.height = input.height / 2;
+
+    // Chroma planes of the reduced image must keep integer dimensions.
+    if (is_planar(input.format)) {
+        output.width &= ~1u;
+        output.height &= ~1u;
+    }
+
+    output.bytes_per_line = output.width * bytes_per_pixel(output.format);
+    output.data_size = image_size(output.format, output.width, output.height);
+    set_planes(output);
+    copy_metadata(input, output);
+
+    Plane source[3];
+    Plane destination[3];
+    const unsigned int count = image_planes(input, source);
+    image_planes(output, destination);
+
+    for (unsigned int i = 0; i < count; i++) {
+        downscale_plane(source[i], destination[i]);
+    }
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,267 @@
+#include "picam_imgproc.hpp"
+#include "picam_simd.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Circle of radius 3 around the tested pixel, clockwise from the top.
+static const int kCircle[16][2] = {
+    {  0, -3 }, {  1, -3 }, {  2, -2 }, {  3, -1 }, {  3,  0 }, {  3,  1 }, {  2,  2 }, {  1,  3 },
+    {  0,  3 }, { -1,  3 }, { -2,  2 }, { -3,  1 }, { -3,  0 }, { -3, -1 }, { -2, -2 }, { -1, -3 },
+};
+
+// Contiguous circle pixels that must be brighter or darker.
+static const unsigned int kArc = 9;
+
+/*************************************************************************************************/
+
+// Score of pixel, or zero if it isn't a corner. Offsets are those of the circle on its plane.
+static std::uint16_t corner_score(const std::uint8_t* pixel, const int* offsets, int threshold)
+{
+    const int center = *pixel;
+    unsigned int bright_run = 0, dark_run = 0;
+    unsigned int bright_arc = 0, dark_arc = 0;
+    int bright_sum = 0, dark_sum = 0;
+
+    // Runs wrap around, so the first kArc - 1 pixels are visited twice.
+    for (unsigned int k = 0; k < 16 + kArc - 1; k++) {
+        const int value = pixel[offsets[k % 16]];
+        const bool bright = value > center + threshold;
+        const bool dark = value < center - threshold;
+        bright_run = bright ? bright_run + 1 : 0;
+        dark_run = dark ? dark_run + 1 : 0;
+        bright_arc = std::max(bright_arc, bright_run);
+        dark_arc = std::max(dark_arc, dark_run);
+        if (k < 16) {
+            bright_sum += bright ? value - center - threshold : 0;
+            dark_sum += dark ? center - threshold - value : 0;
+        }
+    }
+
+    if (bright_arc < kArc && dark_arc < kArc) {
+        return 0;
+    }
+    return static_cast<std::uint16_t>(std::max(bright_arc >= kArc ? bright_sum : 0, dark_arc >= kArc ? dark_sum : 0));
+}
+
+/*************************************************************************************************/
+
+// Score pixels of a line 16 at a time. Returns pixels processed.
+static unsigned int score_line(const std::uint8_t* in, unsigned int width, const int* offsets,
+                               int threshold, std::uint16_t* scores)
+{
+    unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_cmpeq_epi8(zero, zero);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i arc = _mm_set1_epi8(static_cast<char>(kArc));
+
+    for (; x + 16 <= width; x += 16) {
+        const std::uint8_t* pixel = in + x;
+        const __m128i center = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel));
+        const __m128i high = _mm_adds_epu8(center, limit);
+        const __m128i low = _mm_subs_epu8(center, limit);
+
+        // Differences of circle pixels beyond high and low (saturated, so zero when not brighter or darker),
+        // and masks where they are not zero.
+        __m128i brighter[16], darker[16], bright[16], dark[16];
+        auto classify = [&](unsigned int k) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel + offsets[k]));
+            brighter[k] = _mm_subs_epu8(value, high);
+            darker[k] = _mm_subs_epu8(low, value);
+            bright[k] = _mm_xor_si128(_mm_cmpeq_epi8(brighter[k], zero), ones);
+            dark[k] = _mm_xor_si128(_mm_cmpeq_epi8(darker[k], zero), ones);
+        };
+
+        // Any arc of 9 pixels covers two neighbouring compass points, which rejects most pixels.
+        for (unsigned int k = 0; k < 16; k += 4) {
+            classify(k);
+        }
+        const __m128i maybe = _mm_or_si128(
+            _mm_and_si128(_mm_or_si128(bright[0], bright[8]), _mm_or_si128(bright[4], bright[12])),
+            _mm_and_si128(_mm_or_si128(dark[0], dark[8]), _mm_or_si128(dark[4], dark[12])));
+        if (!_mm_movemask_epi8(maybe)) {
+            std::memset(scores + x, 0, 16 * sizeof(std::uint16_t));
+            continue;
+        }
+
+        for (unsigned int k = 0; k < 16; k++) {
+            if (k % 4) {
+                classify(k);
+            }
+        }
+
+        // Length of the current run is reset where the mask is clear, keeping the longest one.
+        __m128i bright_run = zero, dark_run = zero, bright_arc = zero, dark_arc = zero;
+        for (unsigned int k = 0; k < 16 + kArc - 1; k++) {
+            bright_run = _mm_and_si128(_mm_add_epi8(bright_run, one), bright[k % 16]);
+            dark_run = _mm_and_si128(_mm_add_epi8(dark_run, one), dark[k % 16]);
+            bright_arc = _mm_max_epu8(bright_arc, bright_run);
+            dark_arc = _mm_max_epu8(dark_arc, dark_run);
+        }
+        const __m128i bright_corner = _mm_cmpeq_epi8(_mm_max_epu8(bright_arc, arc), bright_arc);
+        const __m128i dark_corner = _mm_cmpeq_epi8(_mm_max_epu8(dark_arc, arc), dark_arc);
+        if (!_mm_movemask_epi8(_mm_or_si128(bright_corner, dark_corner))) {
+            std::memset(scores + x, 0, 16 * sizeof(std::uint16_t));
+            continue;
+        }
+
+        // Sum differences of both sides in 16 bits, keeping the one forming the arc.
+        __m128i bright_low = zero, bright_high = zero, dark_low = zero, dark_high = zero;
+        for (unsigned int k = 0; k < 16; k++) {
+            bright_low = _mm_add_epi16(bright_low, _mm_unpacklo_epi8(brighter[k], zero));
+            bright_high = _mm_add_epi16(bright_high, _mm_unpackhi_epi8(brighter[k], zero));
+            dark_low = _mm_add_epi16(dark_low, _mm_unpacklo_epi8(darker[k], zero));
+            dark_high = _mm_add_epi16(dark_high, _mm_unpackhi_epi8(darker[k], zero));
+        }
+        const __m128i low_scores = _mm_or_si128(
+            _mm_and_si128(_mm_unpacklo_epi8(bright_corner, bright_corner), bright_low),
+            _mm_and_si128(_mm_unpacklo_epi8(dark_corner, dark_corner), dark_low));
+        const __m128i high_scores = _mm_or_si128(
+            _mm_and_si128(_mm_unpackhi_epi8(bright_corner, bright_corner), bright_high),
+            _mm_and_si128(_mm_unpackhi_epi8(dark_corner, dark_corner), dark_high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(scores + x), low_scores);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(scores + x + 8), high_scores);
+    }
+#elif defined(PICAM_NEON)
+    const uint8x16_t limit = vdupq_n_u8(static_cast<std::uint8_t>(threshold));
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    const uint8x16_t arc = vdupq_n_u8(kArc);
+
+    // True if any lane of mask is set.
+    auto any = [](uint8x16_t mask) {
+        const uint64x2_t lanes = vreinterpretq_u64_u8(mask);
+        return (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) != 0;
+    };
+
+    // Widen half of a byte mask to 16 bit lanes.
+    auto widen = [](uint8x8_t mask) {
+        return vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(mask)));
+    };
+
+    for (; x + 16 <= width; x += 16) {
+        const std::uint8_t* pixel = in + x;
+        const uint8x16_t center = vld1q_u8(pixel);
+        const uint8x16_t high = vqaddq_u8(center, limit);
+        const uint8x16_t low = vqsubq_u8(center, limit);
+
+        uint8x16_t brighter[16], darker[16], bright[16], dark[16];
+        auto classify = [&](unsigned int k) {
+            const uint8x16_t value = vld1q_u8(pixel + offsets[k]);
+            brighter[k] = vqsubq_u8(value, high);
+            darker[k] = vqsubq_u8(low, value);
+            bright[k] = vtstq_u8(brighter[k], brighter[k]);
+            dark[k] = vtstq_u8(darker[k], darker[k]);
+        };
+
+        for (unsigned int k = 0; k < 16; k += 4) {
+            classify(k);
+        }
+        const uint8x16_t maybe = vorrq_u8(
+            vandq_u8(vorrq_u8(bright[0], bright[8]), vorrq_u8(bright[4], bright[12])),
+            vandq_u8(vorrq_u8(dark[0], dark[8]), vorrq_u8(dark[4], dark[12])));
+        if (!any(maybe)) {
+            std::memset(scores + x, 0, 16 * sizeof(std::uint16_t));
+            continue;
+        }
+
+        for (unsigned int k = 0; k < 16; k++) {
+            if (k % 4) {
+                classify(k);
+            }
+        }
+
+        uint8x16_t bright_run = zero, dark_run = zero, bright_arc = zero, dark_arc = zero;
+        for (unsigned int k = 0; k < 16 + kArc - 1; k++) {
+            bright_run = vandq_u8(vaddq_u8(bright_run, one), bright[k % 16]);
+            dark_run = vandq_u8(vaddq_u8(dark_run, one), dark[k % 16]);
+            bright_arc = vmaxq_u8(bright_arc, bright_run);
+            dark_arc = vmaxq_u8(dark_arc, dark_run);
+        }
+        const uint8x16_t bright_corner = vcgeq_u8(bright_arc, arc);
+        const uint8x16_t dark_corner = vcgeq_u8(dark_arc, arc);
+        if (!any(vorrq_u8(bright_corner, dark_corner))) {
+            std::memset(scores + x, 0, 16 * sizeof(std::uint16_t));
+            continue;
+        }
+
+        uint16x8_t bright_low = vdupq_n_u16(0), bright_high = vdupq_n_u16(0);
+        uint16x8_t dark_low = vdupq_n_u16(0), dark_high = vdupq_n_u16(0);
+        for (unsigned int k = 0; k < 16; k++) {
+            bright_low = vaddw_u8(bright_low, vget_low_u8(brighter[k]));
+            bright_high = vaddw_u8(bright_high, vget_high_u8(brighter[k]));
+            dark_low = vaddw_u8(dark_low, vget_low_u8(darker[k]));
+            dark_high = vaddw_u8(dark_high, vget_high_u8(darker[k]));
+        }
+        vst1q_u16(scores + x, vorrq_u16(vandq_u16(widen(vget_low_u8(bright_corner)), bright_low),
+                                        vandq_u16(widen(vget_low_u8(dark_corner)), dark_low)));
+        vst1q_u16(scores + x + 8, vorrq_u16(vandq_u16(widen(vget_high_u8(bright_corner)), bright_high),
+                                            vandq_u16(widen(vget_high_u8(dark_corner)), dark_high)));
+    }
+#endif
+
+    return x;
+}
+
+/*************************************************************************************************/
+
+void fast_scores(const Plane& gray, unsigned int threshold, unsigned int first, unsigned int last,
+                 std::uint16_t* scores)
+{
+    int offsets[16];
+    for (unsigned int k = 0; k < 16; k++) {
+        offsets[k] = kCircle[k][1] * static_cast<int>(gray.bytes_per_line) + kCircle[k][0];
+    }
+
+    for (unsigned int y = first; y < last; y++) {
+        std::uint16_t* row = scores + static_cast<std::size_t>(y) * gray.width;
+        std::memset(row, 0, gray.width * sizeof(std::uint16_t));
+        if (y < kFeatureBorder || y + kFeatureBorder >= gray.height || gray.width <= 2 * kFeatureBorder) {
+            continue;
+        }
+
+        const std::uint8_t* in = gray.data + static_cast<std::size_t>(y) * gray.bytes_per_line + kFeatureBorder;
+        const unsigned int width = gray.width - 2 * kFeatureBorder;
+        std::uint16_t* out = row + kFeatureBorder;
+        for (unsigned int x = score_line(in, width, offsets, threshold, out); x < width; x++) {
+            out[x] = corner_score(in + x, offsets, threshold);
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+void suppress_non_maxima(const std::uint16_t* scores, unsigned int width, unsigned int height,
+                         unsigned int first, unsigned int last, std::vector<Corner>& corners)
+{
+    for (unsigned int y = std::max(first, 1u); y < std::min(last, height - 1); y++) {
+        const std::uint16_t* above = scores + static_cast<std::size_t>(y - 1) * width;
+        const std::uint16_t* row = above + width;
+        const std::uint16_t* below = row + width;
+
+        for (unsigned int x = 1; x + 1 < width; x++) {
+            const std::uint16_t score = row[x];
+            if (!score) {
+                continue;
+            }
+
+            // Ties are won by the pixel later in raster order, so equal neighbours keep a single corner.
+            if (score >= above[x - 1] && score >= above[x] && score >= above[x + 1] && score >= row[x - 1] &&
+                score > row[x + 1] && score > below[x - 1] && score > below[x] && score > below[x + 1]) {
+                corners.push_back({ x, y, score });
+            }
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+}
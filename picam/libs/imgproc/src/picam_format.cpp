@@ -0,0 +1,111 @@
+#include "picam_imgproc.hpp"
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+unsigned int bytes_per_pixel(picam_image_format_t format)
+{
+    return (format == PICAM_IMAGE_FORMAT_RGB || format == PICAM_IMAGE_FORMAT_BGR) ? 3 : 1;
+}
+
+/*************************************************************************************************/
+
+bool is_planar(picam_image_format_t format)
+{
+    return format == PICAM_IMAGE_FORMAT_I420 || format == PICAM_IMAGE_FORMAT_NV12;
+}
+
+/*************************************************************************************************/
+
+unsigned int image_size(picam_image_format_t format, unsigned int width, unsigned int height)
+{
+    if (is_planar(format)) {
+        return width * height + 2 * (width / 2) * (height / 2);
+    }
+    return width * height * bytes_per_pixel(format);
+}
+
+/*************************************************************************************************/
+
+// Number of planes used by format.
+static unsigned int plane_count(picam_image_format_t format)
+{
+    switch (format) {
+        case PICAM_IMAGE_FORMAT_I420: return 3;
+        case PICAM_IMAGE_FORMAT_NV12: return 2;
+        default: return 1;
+    }
+}
+
+/*************************************************************************************************/
+
+void set_planes(picam_image_t& image)
+{
+    const unsigned int luma_size = image.bytes_per_line * image.height;
+    const unsigned int chroma_stride = (image.format == PICAM_IMAGE_FORMAT_I420) ? image.bytes_per_line / 2
+                                                                                 : image.bytes_per_line;
+
+    image.num_planes = plane_count(image.format);
+    image.planes[0] = { 0, image.bytes_per_line };
+    image.planes[1] = { luma_size, chroma_stride };
+    image.planes[2] = { luma_size + chroma_stride * (image.height / 2), chroma_stride };
+}
+
+/*************************************************************************************************/
+
+unsigned int image_planes(const picam_image_t& image, Plane planes[3])
+{
+    // Images without descriptors use the default layout.
+    picam_image_t layout = image;
+    if (layout.num_planes == 0) {
+        set_planes(layout);
+    }
+
+    const unsigned int count = plane_count(image.format);
+    for (unsigned int i = 0; i < count; i++) {
+        const unsigned int scale = (i == 0) ? 1 : 2;
+        planes[i].data = image.data + layout.planes[i].offset;
+        planes[i].width = image.width / scale;
+        planes[i].height = image.height / scale;
+        planes[i].bytes_per_line = layout.planes[i].bytes_per_line;
+        planes[i].channels = bytes_per_pixel(image.format);
+    }
+
+    // Interleaved UV plane.
+    if (image.format == PICAM_IMAGE_FORMAT_NV12) {
+        planes[1].channels = 2;
+    }
+    return count;
+}
+
+/*************************************************************************************************/
+
+bool is_compact(const picam_image_t& image)
+{
+    Plane planes[3];
+    const unsigned int count = image_planes(image, planes);
+
+    const unsigned char* expected = image.data;
+    for (unsigned int i = 0; i < count; i++) {
+        if (planes[i].data != expected || planes[i].bytes_per_line != planes[i].width * planes[i].channels) {
+            return false;
+        }
+        expected += planes[i].bytes_per_line * planes[i].height;
+    }
+    return true;
+}
+
+/*************************************************************************************************/
+
+void copy_metadata(const picam_image_t& from, picam_image_t& to)
+{
+    to.timestamp = from.timestamp;
+    to.sequence = from.sequence;
+    to.dropped = from.dropped;
+    to.lost = from.lost;
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,116 @@
+#include "picam_imgproc.hpp"
+#include "picam_simd.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Side of the square blocks compared by block_differences.
+static const unsigned int kBlock = 8;
+
+/*************************************************************************************************/
+
+// Add absolute differences of one line to the sums of its blocks, starting at block bx.
+static void block_line_scalar(const std::uint8_t* a, const std::uint8_t* b, unsigned int* sums,
+                              unsigned int bx, unsigned int blocks)
+{
+    for (; bx < blocks; bx++) {
+        unsigned int sum = 0;
+        for (unsigned int x = bx * kBlock; x < (bx + 1) * kBlock; x++) {
+            sum += (a[x] > b[x]) ? a[x] - b[x] : b[x] - a[x];
+        }
+        sums[bx] += sum;
+    }
+}
+
+/*************************************************************************************************/
+
+// Add absolute differences of one line to the sums of its blocks, returning blocks processed.
+static unsigned int block_line(const std::uint8_t* a, const std::uint8_t* b, unsigned int* sums,
+                               unsigned int blocks)
+{
+    unsigned int bx = 0;
+
+#if defined(PICAM_SSE2)
+    // Each 16 bytes cover two blocks, and SAD gives one sum for each 8 bytes.
+    for (; bx + 2 <= blocks; bx += 2) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + bx * kBlock));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + bx * kBlock));
+        __m128i sad = _mm_sad_epu8(va, vb);
+        sums[bx] += static_cast<unsigned int>(_mm_cvtsi128_si32(sad));
+        sums[bx + 1] += static_cast<unsigned int>(_mm_extract_epi16(sad, 4));
+    }
+#elif defined(PICAM_NEON)
+    for (; bx + 2 <= blocks; bx += 2) {
+        uint8x16_t diff = vabdq_u8(vld1q_u8(a + bx * kBlock), vld1q_u8(b + bx * kBlock));
+        uint64x2_t sad = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(diff)));
+        sums[bx] += static_cast<unsigned int>(vgetq_lane_u64(sad, 0));
+        sums[bx + 1] += static_cast<unsigned int>(vgetq_lane_u64(sad, 1));
+    }
+#endif
+
+    return bx;
+}
+
+/*************************************************************************************************/
+
+void block_differences(const Plane& a, const Plane& b, unsigned int* sums)
+{
+    const unsigned int blocks_x = a.width / kBlock;
+    const unsigned int blocks_y = a.height / kBlock;
+
+    for (unsigned int by = 0; by < blocks_y; by++) {
+        unsigned int* row = sums + by * blocks_x;
+        std::memset(row, 0, blocks_x * sizeof(unsigned int));
+
+        for (unsigned int y = by * kBlock; y < (by + 1) * kBlock; y++) {
+            const std::uint8_t* line_a = a.data + static_cast<std::size_t>(y) * a.bytes_per_line;
+            const std::uint8_t* line_b = b.data + static_cast<std::size_t>(y) * b.bytes_per_line;
+            const unsigned int bx = block_line(line_a, line_b, row, blocks_x);
+            block_line_scalar(line_a, line_b, row, bx, blocks_x);
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+void follow_background(const Plane& frame, const Plane& background)
+{
+    for (unsigned int y = 0; y < frame.height; y++) {
+        const std::uint8_t* in = frame.data + static_cast<std::size_t>(y) * frame.bytes_per_line;
+        std::uint8_t* out = background.data + static_cast<std::size_t>(y) * background.bytes_per_line;
+        unsigned int x = 0;
+
+#if defined(PICAM_SSE2)
+        // Saturated differences are zero in the wrong direction, so each one only moves one way.
+        const __m128i one = _mm_set1_epi8(1);
+        for (; x + 16 <= frame.width; x += 16) {
+            __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+            __m128i bg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + x));
+            __m128i up = _mm_min_epu8(_mm_subs_epu8(f, bg), one);
+            __m128i down = _mm_min_epu8(_mm_subs_epu8(bg, f), one);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_subs_epu8(_mm_adds_epu8(bg, up), down));
+        }
+#elif defined(PICAM_NEON)
+        const uint8x16_t one = vdupq_n_u8(1);
+        for (; x + 16 <= frame.width; x += 16) {
+            uint8x16_t f = vld1q_u8(in + x);
+            uint8x16_t bg = vld1q_u8(out + x);
+            uint8x16_t up = vminq_u8(vqsubq_u8(f, bg), one);
+            uint8x16_t down = vminq_u8(vqsubq_u8(bg, f), one);
+            vst1q_u8(out + x, vqsubq_u8(vqaddq_u8(bg, up), down));
+        }
+#endif
+
+        for (; x < frame.width; x++) {
+            out[x] = static_cast<std::uint8_t>(out[x] + (in[x] > out[x]) - (in[x] < out[x]));
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+}
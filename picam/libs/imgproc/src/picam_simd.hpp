@@ -0,0 +1,15 @@
+#ifndef PICAM_SIMD_H
+#define PICAM_SIMD_H
+
+// Select the vector instruction set available for the target.
+// Kernels must always provide a scalar version used when none is found.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PICAM_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PICAM_NEON
+#endif
+
+#endif // PICAM_SIMD_H
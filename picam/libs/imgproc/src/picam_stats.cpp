@@ -0,0 +1,123 @@
+#include "picam_imgproc.hpp"
+#include "picam_simd.hpp"
+
+#include <cstring>
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+// Counts are spread over several tables, so repeated values don't wait for the previous increment.
+static const unsigned int kTables = 4;
+
+// Maximum number of interleaved channels of a plane.
+static const unsigned int kChannels = 3;
+
+// Partial histograms of each channel.
+typedef std::uint32_t Tables[kTables][kChannels][256];
+
+/*************************************************************************************************/
+
+// Count values of a single channel line, eight pixels at a time. Returns pixels processed.
+static unsigned int count_line(const std::uint8_t* in, unsigned int width, Tables& tables)
+{
+    // Bytes can go to any table, so their order in the word doesn't matter.
+    unsigned int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        std::uint64_t v;
+        std::memcpy(&v, in + x, sizeof(v));
+        tables[0][0][v & 0xff]++;
+        tables[1][0][(v >> 8) & 0xff]++;
+        tables[2][0][(v >> 16) & 0xff]++;
+        tables[3][0][(v >> 24) & 0xff]++;
+        tables[0][0][(v >> 32) & 0xff]++;
+        tables[1][0][(v >> 40) & 0xff]++;
+        tables[2][0][(v >> 48) & 0xff]++;
+        tables[3][0][v >> 56]++;
+    }
+    return x;
+}
+
+/*************************************************************************************************/
+
+// Count values of every step pixel of a line with C interleaved channels, starting at pixel x.
+template<unsigned int C>
+static void count_pixels(const std::uint8_t* in, unsigned int x, unsigned int width, unsigned int step,
+                         Tables& tables)
+{
+    unsigned int table = 0;
+    for (; x < width; x += step) {
+        const std::uint8_t* pixel = in + x * C;
+        for (unsigned int c = 0; c < C; c++) {
+            tables[table][c][pixel[c]]++;
+        }
+        table = (table + 1) % kTables;
+    }
+}
+
+/*************************************************************************************************/
+
+// Add partial histograms of one channel to its histogram.
+static void merge_tables(const Tables& tables, unsigned int channel, std::uint32_t* histogram)
+{
+    unsigned int i = 0;
+
+#if defined(PICAM_SSE2)
+    for (; i < 256; i += 4) {
+        __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(histogram + i));
+        for (unsigned int t = 0; t < kTables; t++) {
+            sum = _mm_add_epi32(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables[t][channel] + i)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(histogram + i), sum);
+    }
+#elif defined(PICAM_NEON)
+    for (; i < 256; i += 4) {
+        uint32x4_t sum = vld1q_u32(histogram + i);
+        for (unsigned int t = 0; t < kTables; t++) {
+            sum = vaddq_u32(sum, vld1q_u32(tables[t][channel] + i));
+        }
+        vst1q_u32(histogram + i, sum);
+    }
+#endif
+
+    for (; i < 256; i++) {
+        for (unsigned int t = 0; t < kTables; t++) {
+            histogram[i] += tables[t][channel][i];
+        }
+    }
+}
+
+/*************************************************************************************************/
+
+void count_values(const Plane& plane, unsigned int step, std::uint32_t* const* histograms)
+{
+    if (step == 0) {
+        step = 1;
+    }
+
+    Tables tables;
+    std::memset(tables, 0, sizeof(tables));
+
+    for (unsigned int y = 0; y < plane.height; y += step) {
+        const std::uint8_t* in = plane.data + static_cast<std::size_t>(y) * plane.bytes_per_line;
+        switch (plane.channels) {
+            case 1:
+                count_pixels<1>(in, (step == 1) ? count_line(in, plane.width, tables) : 0, plane.width, step, tables);
+                break;
+            case 2:
+                count_pixels<2>(in, 0, plane.width, step, tables);
+                break;
+            default:
+                count_pixels<3>(in, 0, plane.width, step, tables);
+                break;
+        }
+    }
+
+    for (unsigned int c = 0; c < plane.channels && c < kChannels; c++) {
+        merge_tables(tables, c, histograms[c]);
+    }
+}
+
+/*************************************************************************************************/
+
+}
@@ -0,0 +1,268 @@
+/*************************************************************************************************
+* Codec - Lossless fast image codec used to reduce bandwidth when publishing frames.
+*
+* The format follows the ideas of QOI (Quite OK Image format). Pixels are visited in raster
+* order and each one is encoded by the cheapest of the following operations:
+*
+*   OP_INDEX  00xxxxxx            Pixel found in the 64 entries table of recently seen pixels.
+*   OP_DIFF   01rrggbb            Small difference (-2..1) from previous pixel in each channel.
+*   OP_LUMA   10gggggg rrrrbbbb   Green difference (-32..31) and red/blue relative to green (-8..7).
+*   OP_RUN    11xxxxxx            Previous pixel repeated 1 to 62 times.
+*   OP_RAW    11111110 [c bytes]  Pixel values stored as they are.
+*
+* Single channel images (GRAY, and planar YUV through codec_view) are handled as if all color
+* channels had the same value. As there is a single difference to store, OP_DIFF uses all 6 bits
+* for it (-32..31), OP_LUMA is never used and OP_RAW stores only one byte.
+*
+* The encoded stream doesn't contain any header. Dimensions and format are serialized separately.
+*
+**************************************************************************************************/
+
+#ifndef PICAM_CODEC_H
+#define PICAM_CODEC_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "picam_defines.h"
+#include "jaw_exception.hpp"
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+namespace Codec {
+
+// Operation tags.
+static const std::uint8_t OP_INDEX = 0x00;
+static const std::uint8_t OP_DIFF = 0x40;
+static const std::uint8_t OP_LUMA = 0x80;
+static const std::uint8_t OP_RUN = 0xc0;
+static const std::uint8_t OP_RAW = 0xfe;
+static const std::uint8_t OP_MASK = 0xc0;
+
+// Maximum length of a single run.
+static const int MAX_RUN = 62;
+
+// Pixel representation used by encoder and decoder.
+struct Pixel
+{
+    std::uint8_t r, g, b;
+};
+
+inline bool operator == (const Pixel& left, const Pixel& right)
+{
+    return left.r == right.r && left.g == right.g && left.b == right.b;
+}
+
+// Position of pixel in the table of recently seen pixels.
+inline int hash(const Pixel& px)
+{
+    return (px.r * 3 + px.g * 5 + px.b * 7 + 255 * 11) % 64;
+}
+
+}
+
+/*************************************************************************************************/
+
+// Number of interleaved channels for the supplied format (3 for RGB and BGR, 1 otherwise).
+inline unsigned int codec_channels(picam_image_format_t format)
+{
+    return (format == PICAM_IMAGE_FORMAT_RGB || format == PICAM_IMAGE_FORMAT_BGR) ? 3 : 1;
+}
+
+/*************************************************************************************************/
+
+// Single channel view of an image used by encoders. Planar images (I420 and NV12) without line
+// padding are seen as a GRAY image with all planes one after another (height * 3 / 2 lines).
+inline picam_image_t codec_view(const picam_image_t& image)
+{
+    picam_image_t view = image;
+    if (image.format == PICAM_IMAGE_FORMAT_I420 || image.format == PICAM_IMAGE_FORMAT_NV12) {
+        view.format = PICAM_IMAGE_FORMAT_GRAY;
+        view.height = image.height * 3 / 2;
+    }
+    return view;
+}
+
+/*************************************************************************************************/
+
+// Maximum size in bytes that encoding an image with supplied dimensions can produce.
+inline std::size_t codec_max_size(unsigned int width, unsigned int height, unsigned int channels)
+{
+    return static_cast<std::size_t>(width) * height * (channels + 1);
+}
+
+/*************************************************************************************************/
+
+// Encode image into output, which must hold at least codec_max_size bytes.
+// Line padding (bytes_per_line) is skipped. Returns the number of bytes written.
+inline std::size_t codec_encode(const picam_image_t& image, std::uint8_t* output)
+{
+    using namespace Codec;
+
+    const unsigned int channels = codec_channels(image.format);
+
+    Pixel index[64];
+    std::memset(index, 0, sizeof(index));
+
+    Pixel prev = { 0, 0, 0 };
+    int run = 0;
+    std::uint8_t* out = output;
+
+    for (unsigned int y = 0; y < image.height; y++) {
+        const std::uint8_t* line = image.data + static_cast<std::size_t>(y) * image.bytes_per_line;
+
+        for (unsigned int x = 0; x < image.width; x++) {
+            Pixel px;
+            if (channels == 3) {
+                px.r = line[x * 3];
+                px.g = line[x * 3 + 1];
+                px.b = line[x * 3 + 2];
+            } else {
+                px.r = px.g = px.b = line[x];
+            }
+
+            if (px == prev) {
+                if (++run == MAX_RUN) {
+                    *out++ = OP_RUN | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                *out++ = OP_RUN | (run - 1);
+                run = 0;
+            }
+
+            const int pos = hash(px);
+            if (index[pos] == px) {
+                *out++ = OP_INDEX | pos;
+            } else {
+                index[pos] = px;
+
+                const std::int8_t dr = static_cast<std::int8_t>(px.r - prev.r);
+                const std::int8_t dg = static_cast<std::int8_t>(px.g - prev.g);
+                const std::int8_t db = static_cast<std::int8_t>(px.b - prev.b);
+                const std::int8_t dr_dg = static_cast<std::int8_t>(dr - dg);
+                const std::int8_t db_dg = static_cast<std::int8_t>(db - dg);
+
+                if (channels == 1) {
+                    if (dg > -33 && dg < 32) {
+                        *out++ = OP_DIFF | (dg + 32);
+                    } else {
+                        *out++ = OP_RAW;
+                        *out++ = px.g;
+                    }
+                } else if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2) {
+                    *out++ = OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+                } else if (dg > -33 && dg < 32 && dr_dg > -9 && dr_dg < 8 && db_dg > -9 && db_dg < 8) {
+                    *out++ = OP_LUMA | (dg + 32);
+                    *out++ = (dr_dg + 8) << 4 | (db_dg + 8);
+                } else {
+                    *out++ = OP_RAW;
+                    *out++ = px.r;
+                    if (channels == 3) {
+                        *out++ = px.g;
+                        *out++ = px.b;
+                    }
+                }
+            }
+            prev = px;
+        }
+    }
+
+    if (run > 0) {
+        *out++ = OP_RUN | (run - 1);
+    }
+
+    return static_cast<std::size_t>(out - output);
+}
+
+/*************************************************************************************************/
+
+// Decode size bytes from input into image.
+// Image format, width and height must be already set and data must hold height * bytes_per_line.
+// Throws Jaw::Exception if the encoded stream is inconsistent with the image dimensions.
+inline void codec_decode(const std::uint8_t* input, std::size_t size, picam_image_t& image)
+{
+    using namespace Codec;
+
+    const unsigned int channels = codec_channels(image.format);
+
+    Pixel index[64];
+    std::memset(index, 0, sizeof(index));
+
+    Pixel px = { 0, 0, 0 };
+    int run = 0;
+    const std::uint8_t* in = input;
+    const std::uint8_t* end = input + size;
+
+    for (unsigned int y = 0; y < image.height; y++) {
+        std::uint8_t* line = image.data + static_cast<std::size_t>(y) * image.bytes_per_line;
+
+        for (unsigned int x = 0; x < image.width; x++) {
+            if (run > 0) {
+                run--;
+            } else {
+                if (in >= end) {
+                    throw Jaw::Exception(std::errc::bad_message, "Encoded image is truncated");
+                }
+                const std::uint8_t op = *in++;
+
+                if (op == OP_RAW) {
+                    if (in + channels > end) {
+                        throw Jaw::Exception(std::errc::bad_message, "Encoded image is truncated");
+                    }
+                    px.r = *in++;
+                    if (channels == 3) {
+                        px.g = *in++;
+                        px.b = *in++;
+                    } else {
+                        px.g = px.b = px.r;
+                    }
+                } else if ((op & OP_MASK) == OP_INDEX) {
+                    px = index[op];
+                } else if ((op & OP_MASK) == OP_DIFF && channels == 1) {
+                    px.r = px.g = px.b = static_cast<std::uint8_t>(px.g + (op & 0x3f) - 32);
+                } else if ((op & OP_MASK) == OP_DIFF) {
+                    px.r += ((op >> 4) & 0x03) - 2;
+                    px.g += ((op >> 2) & 0x03) - 2;
+                    px.b += (op & 0x03) - 2;
+                } else if ((op & OP_MASK) == OP_LUMA) {
+                    if (in >= end) {
+                        throw Jaw::Exception(std::errc::bad_message, "Encoded image is truncated");
+                    }
+                    const std::uint8_t second = *in++;
+                    const int dg = (op & 0x3f) - 32;
+                    px.r += dg - 8 + ((second >> 4) & 0x0f);
+                    px.g += dg;
+                    px.b += dg - 8 + (second & 0x0f);
+                } else {
+                    run = op & 0x3f;
+                }
+                index[hash(px)] = px;
+            }
+
+            if (channels == 3) {
+                line[x * 3] = px.r;
+                line[x * 3 + 1] = px.g;
+                line[x * 3 + 2] = px.b;
+            } else {
+                line[x] = px.r;
+            }
+        }
+    }
+
+    if (run > 0 || in != end) {
+        throw Jaw::Exception(std::errc::bad_message, "Encoded image has unexpected length");
+    }
+}
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_CODEC_H
@@ -0,0 +1,363 @@
+/*************************************************************************************************
+* Delta - Tile based delta encoding used to publish only the regions of a frame that changed.
+*
+* Frames are split in square tiles of TILE_SIZE pixels. The encoder keeps a copy of the last
+* transmitted frame and compares each tile against it. Only tiles with at least one different
+* byte are sent. Every KEYFRAME_INTERVAL frames (or when the stream can't be continued) the
+* whole frame is sent as a keyframe.
+*
+* The decoder keeps the reconstructed frame. As messages may be lost by the transport, each frame
+* carries a sequence number. When a gap is detected the decoder discards deltas until the next
+* keyframe arrives.
+*
+* Encoded stream layout (after format, width, height):
+*
+*   sequence (uint32) | keyframe (int32) | num_tiles (uint32) | tiles...
+*
+* Keyframes contain all rows of the image without padding. Deltas contain for each changed tile
+* its index (uint32, row major) followed by its rows (clipped at the right and bottom borders).
+*
+**************************************************************************************************/
+
+#ifndef PICAM_DELTA_H
+#define PICAM_DELTA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PICAM_DELTA_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PICAM_DELTA_NEON
+#endif
+
+#include "picam_defines.h"
+#include "picam_codec.hpp"
+#include "jaw_exception.hpp"
+
+namespace PiCam {
+
+/*************************************************************************************************/
+
+namespace Delta {
+
+// Width and height of tiles in pixels.
+static const unsigned int TILE_SIZE = 16;
+
+// Number of frames between keyframes.
+static const unsigned int KEYFRAME_INTERVAL = 30;
+
+// Compare size bytes from both buffers returning true if they are equal.
+inline bool equal(const std::uint8_t* left, const std::uint8_t* right, std::size_t size)
+{
+    std::size_t i = 0;
+
+#if defined(PICAM_DELTA_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) {
+            return false;
+        }
+    }
+#elif defined(PICAM_DELTA_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(left + i), vld1q_u8(right + i));
+        uint8x8_t folded = vand_u8(vget_low_u8(eq), vget_high_u8(eq));
+        if (vget_lane_u64(vreinterpret_u64_u8(folded), 0) != ~0ULL) {
+            return false;
+        }
+    }
+#endif
+
+    return std::memcmp(left + i, right + i, size - i) == 0;
+}
+
+}
+
+/*************************************************************************************************/
+
+// Layout of the tiles for an image.
+struct TileGrid
+{
+    TileGrid(const picam_image_t& image)
+        : bytes_per_pixel(codec_channels(image.format))
+        , line_size(image.width * bytes_per_pixel)
+        , cols((image.width + Delta::TILE_SIZE - 1) / Delta::TILE_SIZE)
+        , rows((image.height + Delta::TILE_SIZE - 1) / Delta::TILE_SIZE)
+        , width(image.width)
+        , height(image.height)
+    {}
+
+    // Offset in bytes of the first pixel of the tile inside a line.
+    std::size_t tile_offset(unsigned int col) const
+    {
+        return static_cast<std::size_t>(col) * Delta::TILE_SIZE * bytes_per_pixel;
+    }
+
+    // Size in bytes of each line of the tile, considering right border.
+    std::size_t tile_line_size(unsigned int col) const
+    {
+        unsigned int x = col * Delta::TILE_SIZE;
+        unsigned int w = (x + Delta::TILE_SIZE <= width) ? Delta::TILE_SIZE : width - x;
+        return static_cast<std::size_t>(w) * bytes_per_pixel;
+    }
+
+    // Number of lines of the tile, considering bottom border.
+    unsigned int tile_lines(unsigned int row) const
+    {
+        unsigned int y = row * Delta::TILE_SIZE;
+        return (y + Delta::TILE_SIZE <= height) ? Delta::TILE_SIZE : height - y;
+    }
+
+    unsigned int bytes_per_pixel;
+    std::size_t line_size;
+    unsigned int cols;
+    unsigned int rows;
+    unsigned int width;
+    unsigned int height;
+};
+
+/*************************************************************************************************/
+
+// Produce delta encoded frames.
+class DeltaEncoder
+{
+public:
+    DeltaEncoder()
+        : previous_()
+        , changed_()
+        , format_()
+        , width_(0)
+        , height_(0)
+        , sequence_(0)
+        , since_keyframe_(0)
+    {}
+
+    // Force the next frame to be a keyframe.
+    void reset()
+    {
+        since_keyframe_ = 0;
+        width_ = height_ = 0;
+    }
+
+    // Encode image into output (replacing its contents) following the layout described above.
+    void encode(const picam_image_t& image, std::vector<std::uint8_t>& output)
+    {
+        TileGrid grid(image);
+
+        const bool keyframe = (since_keyframe_ == 0 || image.format != format_ ||
+                               image.width != width_ || image.height != height_);
+
+        format_ = image.format;
+        width_ = image.width;
+        height_ = image.height;
+        since_keyframe_ = (since_keyframe_ + 1) % Delta::KEYFRAME_INTERVAL;
+
+        output.clear();
+        if (keyframe) {
+            write_keyframe(image, grid, output);
+        } else {
+            write_delta(image, grid, output);
+        }
+        sequence_++;
+    }
+
+private:
+
+    // Append raw bytes to output.
+    static void append(std::vector<std::uint8_t>& output, const void* data, std::size_t size)
+    {
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+        output.insert(output.end(), bytes, bytes + size);
+    }
+
+    // Write header of encoded frame.
+    void write_header(bool keyframe, std::uint32_t num_tiles, std::vector<std::uint8_t>& output)
+    {
+        std::int32_t key = keyframe ? 1 : 0;
+        append(output, &sequence_, sizeof(sequence_));
+        append(output, &key, sizeof(key));
+        append(output, &num_tiles, sizeof(num_tiles));
+    }
+
+    // Write whole frame and save it as reference.
+    void write_keyframe(const picam_image_t& image, const TileGrid& grid, std::vector<std::uint8_t>& output)
+    {
+        previous_.resize(grid.line_size * grid.height);
+        for (unsigned int y = 0; y < grid.height; y++) {
+            std::memcpy(&previous_[y * grid.line_size], image.data + y * image.bytes_per_line, grid.line_size);
+        }
+
+        output.reserve(3 * sizeof(std::uint32_t) + previous_.size());
+        write_header(true, grid.cols * grid.rows, output);
+        append(output, previous_.data(), previous_.size());
+    }
+
+    // Write only the tiles that differ from reference, updating it.
+    void write_delta(const picam_image_t& image, const TileGrid& grid, std::vector<std::uint8_t>& output)
+    {
+        changed_.assign(grid.cols * grid.rows, 0);
+        std::uint32_t num_changed = 0;
+        std::size_t payload = 0;
+
+        // Scan line by line so both frames are traversed sequentially.
+        for (unsigned int row = 0; row < grid.rows; row++) {
+            std::uint8_t* changed = &changed_[row * grid.cols];
+            const unsigned int first_line = row * Delta::TILE_SIZE;
+            const unsigned int lines = grid.tile_lines(row);
+
+            for (unsigned int y = first_line; y < first_line + lines; y++) {
+                const std::uint8_t* current = image.data + y * image.bytes_per_line;
+                const std::uint8_t* reference = &previous_[y * grid.line_size];
+
+                for (unsigned int col = 0; col < grid.cols; col++) {
+                    if (!changed[col]) {
+                        std::size_t offset = grid.tile_offset(col);
+                        if (!Delta::equal(current + offset, reference + offset, grid.tile_line_size(col))) {
+                            changed[col] = 1;
+                            num_changed++;
+                            payload += grid.tile_line_size(col) * lines;
+                        }
+                    }
+                }
+            }
+        }
+
+        output.reserve(3 * sizeof(std::uint32_t) + num_changed * sizeof(std::uint32_t) + payload);
+        write_header(false, num_changed, output);
+
+        for (unsigned int row = 0; row < grid.rows; row++) {
+            const unsigned int first_line = row * Delta::TILE_SIZE;
+            const unsigned int lines = grid.tile_lines(row);
+
+            for (unsigned int col = 0; col < grid.cols; col++) {
+                if (!changed_[row * grid.cols + col]) {
+                    continue;
+                }
+                std::uint32_t tile = row * grid.cols + col;
+                append(output, &tile, sizeof(tile));
+
+                std::size_t offset = grid.tile_offset(col);
+                std::size_t size = grid.tile_line_size(col);
+                for (unsigned int y = first_line; y < first_line + lines; y++) {
+                    const std::uint8_t* source = image.data + y * image.bytes_per_line + offset;
+                    std::memcpy(&previous_[y * grid.line_size + offset], source, size);
+                    append(output, source, size);
+                }
+            }
+        }
+    }
+
+    // Last transmitted frame without line padding.
+    std::vector<std::uint8_t> previous_;
+
+    // Flags for tiles that changed in current frame.
+    std::vector<std::uint8_t> changed_;
+
+    // Layout of reference frame.
+    picam_image_format_t format_;
+    unsigned int width_;
+    unsigned int height_;
+
+    // Sequence number of next frame.
+    std::uint32_t sequence_;
+
+    // Frames encoded since last keyframe.
+    unsigned int since_keyframe_;
+};
+
+/*************************************************************************************************/
+
+// Reconstruct frames produced by DeltaEncoder.
+class DeltaDecoder
+{
+public:
+    DeltaDecoder()
+        : frame_()
+        , valid_(false)
+        , expected_(0)
+    {}
+
+    // Apply size bytes of encoded data into frame. Image format, width and height must be set.
+    // Returns false if the frame can't be reconstructed (lost messages) until next keyframe.
+    // On success image data points to the internal frame, valid until next call.
+    // Throws Jaw::Exception if data is inconsistent with image dimensions.
+    bool decode(const std::uint8_t* data, std::size_t size, picam_image_t& image)
+    {
+        TileGrid grid(image);
+        const std::uint8_t* end = data + size;
+
+        std::uint32_t sequence;
+        std::int32_t keyframe;
+        std::uint32_t num_tiles;
+        data = take(data, end, &sequence, sizeof(sequence));
+        data = take(data, end, &keyframe, sizeof(keyframe));
+        data = take(data, end, &num_tiles, sizeof(num_tiles));
+
+        image.bytes_per_line = static_cast<unsigned int>(grid.line_size);
+        image.data_size = static_cast<unsigned int>(grid.line_size * grid.height);
+
+        if (keyframe) {
+            frame_.resize(image.data_size);
+            data = take(data, end, frame_.data(), frame_.size());
+            valid_ = true;
+        } else {
+            // Can't apply delta without the previous frame.
+            if (!valid_ || sequence != expected_ || frame_.size() != image.data_size) {
+                valid_ = false;
+                return false;
+            }
+            for (std::uint32_t i = 0; i < num_tiles; i++) {
+                std::uint32_t tile;
+                data = take(data, end, &tile, sizeof(tile));
+                if (tile >= grid.cols * grid.rows) {
+                    throw Jaw::Exception(std::errc::bad_message, "Invalid tile in delta frame");
+                }
+                unsigned int row = tile / grid.cols;
+                unsigned int col = tile % grid.cols;
+                std::size_t offset = grid.tile_offset(col);
+                std::size_t line_size = grid.tile_line_size(col);
+                unsigned int first_line = row * Delta::TILE_SIZE;
+                for (unsigned int y = first_line; y < first_line + grid.tile_lines(row); y++) {
+                    data = take(data, end, &frame_[y * grid.line_size + offset], line_size);
+                }
+            }
+        }
+
+        expected_ = sequence + 1;
+        image.data = frame_.data();
+        return true;
+    }
+
+private:
+
+    // Copy size bytes from data to destination returning new reading position.
+    static const std::uint8_t* take(const std::uint8_t* data, const std::uint8_t* end, void* destination, std::size_t size)
+    {
+        if (data + size > end) {
+            throw Jaw::Exception(std::errc::bad_message, "Delta frame is truncated");
+        }
+        std::memcpy(destination, data, size);
+        return data + size;
+    }
+
+    // Reconstructed frame without line padding.
+    std::vector<std::uint8_t> frame_;
+
+    // True if frame holds the result of last received sequence.
+    bool valid_;
+
+    // Sequence number expected for the next delta.
+    std::uint32_t expected_;
+};
+
+/*************************************************************************************************/
+
+}
+
+#endif // PICAM_DELTA_H
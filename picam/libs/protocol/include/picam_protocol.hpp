@@ -1,9 +1,12 @@
 #ifndef PICAM_PROTOCOL_H
 #define PICAM_PROTOCOL_H
 
-#include <cmath>
+#include <vector>
 
 #include "picam_defines.h"
+#include "picam_codec.hpp"
+#include "picam_delta.hpp"
+#include "picam_imgproc.hpp"
 #include "jaw_serialization.hpp"
 
 namespace PiCam {
@@ -19,6 +22,108 @@ enum class Command
     CALLBACK_SET,
     PARAMETERS_GET,
     PARAMETERS_SET,
+    ENCODING_SET,
+    HALF_CALLBACK_SET,
+    QUARTER_CALLBACK_SET,
+    EIGHTH_CALLBACK_SET,
+    CROP_ADD,
+    CROP_REMOVE,
+    CROP_CALLBACK_SET,
+    FORMAT_SET,
+    SINK_ADD,
+    SINK_REMOVE,
+    SINK_CALLBACK_SET,
+    MOTION_SET,
+    MOTION_CALLBACK_SET,
+    STATS_SET,
+    STATS_CALLBACK_SET,
+    FEATURES_SET,
+    FEATURES_CALLBACK_SET,
+};
+
+// Callbacks for each pyramid level are published as a different command.
+inline Command level_command(picam_level_t level)
+{
+    switch (level) {
+        case PICAM_LEVEL_HALF: return Command::HALF_CALLBACK_SET;
+        case PICAM_LEVEL_QUARTER: return Command::QUARTER_CALLBACK_SET;
+        case PICAM_LEVEL_EIGHTH: return Command::EIGHTH_CALLBACK_SET;
+        default: return Command::CALLBACK_SET;
+    }
+}
+
+/**************************************************************************************************
+ * Encoding State *
+ *************************************************************************************************/
+
+// State kept by the publisher to encode images of a single channel.
+struct FrameEncoder
+{
+    FrameEncoder()
+        : encoding(PICAM_ENCODING_RAW)
+        , scratch()
+        , compact()
+        , delta()
+    {}
+
+    // Encoding used for last image.
+    picam_encoding_t encoding;
+
+    // Memory used by the encoder, reused between frames.
+    std::vector<std::uint8_t> scratch;
+
+    // Copy of planar images without padding, as required by the encoders.
+    std::vector<std::uint8_t> compact;
+
+    // Reference frame for delta encoding.
+    DeltaEncoder delta;
+};
+
+// State kept by the subscriber to decode images of a single channel.
+struct FrameDecoder
+{
+    FrameDecoder()
+        : encoding(PICAM_ENCODING_RAW)
+        , storage()
+        , delta()
+        , received(false)
+        , next_sequence(0)
+        , dropped(0)
+        , lost(0)
+    {}
+
+    // Count frames missing from the sequence that the camera didn't drop, storing total in image.
+    void track(picam_image_t& image)
+    {
+        if (received && image.sequence >= next_sequence) {
+            const std::uint64_t missing = image.sequence - next_sequence;
+            const std::uint64_t camera_drops = (image.dropped > dropped) ? image.dropped - dropped : 0;
+            if (missing > camera_drops) {
+                lost += static_cast<std::uint32_t>(missing - camera_drops);
+            }
+        }
+        received = true;
+        next_sequence = image.sequence + 1;
+        dropped = image.dropped;
+        image.lost = lost;
+    }
+
+    // Encoding of last image read. Raw images point inside the message instead of storage.
+    picam_encoding_t encoding;
+
+    // Memory for decoded images, reused between frames.
+    std::vector<std::uint8_t> storage;
+
+    // Reconstructed frame for delta encoding.
+    DeltaDecoder delta;
+
+    // Sequence expected for next frame and camera drops reported by last one.
+    bool received;
+    std::uint64_t next_sequence;
+    std::uint32_t dropped;
+
+    // Frames lost by the transport.
+    std::uint32_t lost;
 };
 
 /*************************************************************************************************/
@@ -35,48 +140,60 @@ namespace Jaw {
 template<class... Args>
 void write(OutputBuffer& buffer, const picam_config_t& value, const Args&... args)
 {
-    write(buffer, value.format, value.width, value.height, value.framerate);
+    write(buffer, value.format, value.width, value.height, value.framerate, value.pattern);
+    write(buffer, value.queue_depth, value.delivery, value.backend);
     write(buffer, args...);
 }
 
 template<class... Args>
 void read(InputBuffer& buffer, picam_config_t& value, Args&... args)
 {
-    read(buffer, value.format, value.width, value.height, value.framerate);
+    read(buffer, value.format, value.width, value.height, value.framerate, value.pattern);
+    read(buffer, value.queue_depth, value.delivery, value.backend);
     read(buffer, args...);
 }
 
-/*************************************************************************************************/
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_sink_config_t& value, const Args&... args)
+{
+    write(buffer, value.decimation, value.max_fps, value.queue_depth, value.delivery);
+    write(buffer, args...);
+}
 
 template<class... Args>
-void write(OutputBuffer& buffer, const picam_image_t& value, const Args&... args)
+void read(InputBuffer& buffer, picam_sink_config_t& value, Args&... args)
 {
-    // Write image meta-data
-    write(buffer, value.format, value.width, value.height, value.bytes_per_line, value.data_size);
-    // Write the image bufer
-    buffer.write(value.data, value.data_size);
+    read(buffer, value.decimation, value.max_fps, value.queue_depth, value.delivery);
+    read(buffer, args...);
+}
+
+/*************************************************************************************************/
 
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_plane_t& value, const Args&... args)
+{
+    write(buffer, value.offset, value.bytes_per_line);
     write(buffer, args...);
 }
 
 template<class... Args>
-void write(OutputBuffer& buffer, const picam_image_t& value, const picam_roi_t& crop, const Args&... args)
+void read(InputBuffer& buffer, picam_plane_t& value, Args&... args)
 {
-    const int new_width = static_cast<int>(std::round(value.width * crop.width));
-    const int new_height = static_cast<int>(std::round(value.width * crop.width));
-    const int bytes_per_pixel = value.bytes_per_line / value.width;
-    const int new_bytes_per_line =  bytes_per_pixel * new_width;
-    const int new_data_size = new_bytes_per_line * new_height;
-    const int new_x = static_cast<int>(std::round(value.width * crop.x));
-    const int new_y = static_cast<int>(std::round(value.height * crop.y));
+    read(buffer, value.offset, value.bytes_per_line);
+    read(buffer, args...);
+}
 
-    // Write image meta-data
-    write(buffer, value.format, new_width, new_height, new_bytes_per_line, new_data_size);
+/*************************************************************************************************/
 
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_image_t& value, const Args&... args)
+{
+    // Write image meta-data
+    write(buffer, value.format, value.width, value.height, value.bytes_per_line, value.data_size);
+    write(buffer, value.num_planes, value.planes[0], value.planes[1], value.planes[2]);
+    write(buffer, value.timestamp, value.sequence, value.dropped);
     // Write the image bufer
-    for (int j = new_y; j < new_y + new_height; j++) {
-        buffer.write(value.data + bytes_per_pixel * (new_x + j * value.width), new_bytes_per_line);
-    }
+    buffer.write(value.data, value.data_size);
 
     write(buffer, args...);
 }
@@ -88,12 +205,109 @@ void read(InputBuffer& buffer, picam_image_t& value, Args&... args)
 {
     // Read image meta-data
     read(buffer, value.format, value.width, value.height, value.bytes_per_line, value.data_size);
+    read(buffer, value.num_planes, value.planes[0], value.planes[1], value.planes[2]);
+    read(buffer, value.timestamp, value.sequence, value.dropped);
+    value.lost = 0;
+    value.buffer = nullptr;
     // Get the memory position of the buffer inside the InputBuffer.
     value.data = static_cast<unsigned char*>(buffer.read(0));
 
     read(buffer, args...);
 }
 
+/**************************************************************************************************/
+// Images tagged with the encoding used for transmission.
+
+// Write image compressed with specified encoding.
+// The encoder keeps memory and state between calls and must be used for a single channel.
+inline void write_encoded(OutputBuffer& buffer, const picam_image_t& value, picam_encoding_t encoding,
+                          PiCam::FrameEncoder& encoder)
+{
+    // Delta stream must restart with a keyframe whenever encoding changes.
+    if (encoding != encoder.encoding) {
+        encoder.delta.reset();
+        encoder.encoding = encoding;
+    }
+
+    // Compressed formats only deal with interleaved pixels, planes are packed after each other.
+    picam_image_t source = value;
+    if (encoding != PICAM_ENCODING_RAW && PiCam::is_planar(value.format) && !PiCam::is_compact(value)) {
+        encoder.compact.resize(PiCam::image_size(value.format, value.width, value.height));
+        source.data = encoder.compact.data();
+        PiCam::crop(value, { 0, 0, value.width, value.height }, source);
+    }
+    const picam_image_t view = PiCam::codec_view(source);
+
+    if (encoding == PICAM_ENCODING_QOI) {
+        const unsigned int channels = PiCam::codec_channels(view.format);
+        encoder.scratch.resize(PiCam::codec_max_size(view.width, view.height, channels));
+        const std::uint32_t encoded_size = static_cast<std::uint32_t>(PiCam::codec_encode(view, encoder.scratch.data()));
+
+        write(buffer, encoding, value.format, value.width, value.height, encoded_size);
+        write(buffer, value.timestamp, value.sequence, value.dropped);
+        buffer.write(encoder.scratch.data(), encoded_size);
+    } else if (encoding == PICAM_ENCODING_DELTA) {
+        encoder.delta.encode(view, encoder.scratch);
+        const std::uint32_t encoded_size = static_cast<std::uint32_t>(encoder.scratch.size());
+
+        write(buffer, encoding, value.format, value.width, value.height, encoded_size);
+        write(buffer, value.timestamp, value.sequence, value.dropped);
+        buffer.write(encoder.scratch.data(), encoded_size);
+    } else {
+        write(buffer, PICAM_ENCODING_RAW, value);
+    }
+}
+
+// Read image written by write_encoded decoding it if needed.
+// Returns false when the image can't be reconstructed (delta received after lost messages).
+// WARNING: The image buffer points either to the InputBuffer (raw) or to the decoder storage.
+// It is valid only while both of them are alive and unchanged.
+inline bool read_encoded(InputBuffer& buffer, picam_image_t& value, PiCam::FrameDecoder& decoder)
+{
+    picam_encoding_t encoding;
+    read(buffer, encoding);
+    decoder.encoding = encoding;
+
+    if (encoding == PICAM_ENCODING_RAW) {
+        read(buffer, value);
+        decoder.track(value);
+        return true;
+    }
+
+    if (encoding != PICAM_ENCODING_QOI && encoding != PICAM_ENCODING_DELTA) {
+        throw Exception(std::errc::bad_message, "Received image with unknown encoding");
+    }
+
+    std::uint32_t encoded_size;
+    read(buffer, value.format, value.width, value.height, encoded_size);
+    read(buffer, value.timestamp, value.sequence, value.dropped);
+    decoder.track(value);
+    const std::uint8_t* encoded = static_cast<const std::uint8_t*>(buffer.read(encoded_size));
+
+    picam_image_t view = PiCam::codec_view(value);
+
+    if (encoding == PICAM_ENCODING_DELTA) {
+        if (!decoder.delta.decode(encoded, encoded_size, view)) {
+            return false;
+        }
+    } else {
+        view.bytes_per_line = view.width * PiCam::codec_channels(view.format);
+        view.data_size = view.bytes_per_line * view.height;
+        decoder.storage.resize(view.data_size);
+        view.data = decoder.storage.data();
+
+        PiCam::codec_decode(encoded, encoded_size, view);
+    }
+
+    // Restore original layout, data is the same.
+    value.bytes_per_line = view.bytes_per_line;
+    value.data_size = view.data_size;
+    value.data = view.data;
+    value.buffer = nullptr;
+    PiCam::set_planes(value);
+    return true;
+}
+
 /**************************************************************************************************/
 
 template<class... Args>
@@ -112,6 +326,135 @@ void read(InputBuffer& buffer, picam_roi_t& value, Args&... args)
 
 /**************************************************************************************************/
 
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_motion_config_t& value, const Args&... args)
+{
+    write(buffer, value.threshold, value.min_area, value.suppress_static, value.hold);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, picam_motion_config_t& value, Args&... args)
+{
+    read(buffer, value.threshold, value.min_area, value.suppress_static, value.hold);
+    read(buffer, args...);
+}
+
+// Only regions in use are transmitted.
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_motion_t& value, const Args&... args)
+{
+    write(buffer, value.timestamp, value.sequence, value.changed, value.num_regions);
+    for (unsigned int i = 0; i < value.num_regions; i++) {
+        write(buffer, value.regions[i]);
+    }
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, picam_motion_t& value, Args&... args)
+{
+    read(buffer, value.timestamp, value.sequence, value.changed, value.num_regions);
+    if (value.num_regions > PICAM_MAX_MOTION_REGIONS) {
+        throw Exception(std::errc::bad_message, "Too many motion regions");
+    }
+    for (unsigned int i = 0; i < value.num_regions; i++) {
+        read(buffer, value.regions[i]);
+    }
+    read(buffer, args...);
+}
+
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_stats_config_t& value, const Args&... args)
+{
+    write(buffer, value.decimation, value.step);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, picam_stats_config_t& value, Args&... args)
+{
+    read(buffer, value.decimation, value.step);
+    read(buffer, args...);
+}
+
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_channel_stats_t& value, const Args&... args)
+{
+    write(buffer, value.mean, value.variance, value.clipped_low, value.clipped_high, value.histogram);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, picam_channel_stats_t& value, Args&... args)
+{
+    read(buffer, value.mean, value.variance, value.clipped_low, value.clipped_high, value.histogram);
+    read(buffer, args...);
+}
+
+// Only channels in use are transmitted.
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_stats_t& value, const Args&... args)
+{
+    write(buffer, value.timestamp, value.sequence, value.format, value.luma, value.num_channels);
+    for (unsigned int i = 0; i < value.num_channels; i++) {
+        write(buffer, value.channels[i]);
+    }
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, picam_stats_t& value, Args&... args)
+{
+    read(buffer, value.timestamp, value.sequence, value.format, value.luma, value.num_channels);
+    if (value.num_channels > PICAM_MAX_CHANNELS) {
+        throw Exception(std::errc::bad_message, "Too many statistics channels");
+    }
+    for (unsigned int i = 0; i < value.num_channels; i++) {
+        read(buffer, value.channels[i]);
+    }
+    read(buffer, args...);
+}
+
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_features_config_t& value, const Args&... args)
+{
+    write(buffer, value.threshold, value.max_features, value.descriptors, value.threads);
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, picam_features_config_t& value, Args&... args)
+{
+    read(buffer, value.threshold, value.max_features, value.descriptors, value.threads);
+    read(buffer, args...);
+}
+
+// Keypoints and descriptors are sent as raw data, and read pointing to the message.
+template<class... Args>
+void write(OutputBuffer& buffer, const picam_features_t& value, const Args&... args)
+{
+    const bool descriptors = value.descriptors != nullptr;
+    write(buffer, value.timestamp, value.sequence, value.width, value.height, value.num_keypoints, descriptors);
+    buffer.write(reinterpret_cast<const uint8_t*>(value.keypoints), value.num_keypoints * sizeof(picam_keypoint_t));
+    if (descriptors) {
+        buffer.write(value.descriptors, value.num_keypoints * PICAM_PATCH_SIZE * PICAM_PATCH_SIZE);
+    }
+    write(buffer, args...);
+}
+
+template<class... Args>
+void read(InputBuffer& buffer, picam_features_t& value, Args&... args)
+{
+    bool descriptors;
+    read(buffer, value.timestamp, value.sequence, value.width, value.height, value.num_keypoints, descriptors);
+    const std::size_t count = value.num_keypoints;
+    value.keypoints = static_cast<const picam_keypoint_t*>(buffer.read(count * sizeof(picam_keypoint_t)));
+    value.descriptors = descriptors ?
+        static_cast<const uint8_t*>(buffer.read(count * PICAM_PATCH_SIZE * PICAM_PATCH_SIZE)) : nullptr;
+    read(buffer, args...);
+}
+
 template<class... Args>
 void write(OutputBuffer& buffer, const picam_params_t& value, const Args&... args)
 {
@@ -1,5 +1,11 @@
 #include "picam_server.h"
 
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
 #include "picam_api.h"
 #include "jaw_server.hpp"
 #include "picam_protocol.hpp"
@@ -14,10 +20,153 @@ using PiCamServer = Server<Command>;
 
 /*************************************************************************************************/
 
+// Pyramid level published to a remote camera.
+struct Channel
+{
+    // Handle owning the channel.
+    void* handle;
+
+    // Level of images received.
+    picam_level_t level;
+
+    // Encoder state, only used from camera thread.
+    FrameEncoder encoder;
+};
+
+// Sink published to a remote camera.
+struct SinkChannel
+{
+    // Handle owning the sink.
+    void* handle;
+
+    // Identifier of the sink, used by the client to route its frames. Zero until it is known.
+    std::atomic<picam_sink_t> sink;
+
+    // Encoder state, only used from the sink thread.
+    FrameEncoder encoder;
+};
+
+// State kept by the server for each remote camera.
+struct Session
+{
+    Session(void* handle)
+        : encoding(PICAM_ENCODING_RAW)
+        , channels()
+        , crop_encoders()
+        , sinks()
+    {
+        for (int i = 0; i < PICAM_LEVEL_COUNT; i++) {
+            channels[i].handle = handle;
+            channels[i].level = static_cast<picam_level_t>(i);
+        }
+    }
+
+    // Encoding used when publishing images.
+    std::atomic<picam_encoding_t> encoding;
+
+    // Channels indexed by picam_level_t.
+    std::array<Channel, PICAM_LEVEL_COUNT> channels;
+
+    // Encoder state for each named crop region, only used from camera thread.
+    // Entries are kept after regions are removed as they might be added again.
+    std::map<std::string, FrameEncoder> crop_encoders;
+
+    // Sinks added by the client, only changed from server thread.
+    std::map<picam_sink_t, std::unique_ptr<SinkChannel>> sinks;
+};
+
+/*************************************************************************************************/
+
 template<>
 const PiCamServer::Config& PiCamServer::config()
 {
-    static std::map<void*, picam_roi_t> crop_map;
+    // Publish images received from camera on the command associated to its level.
+    static auto image_callback = [](void* user_data, picam_image_t* image)
+    {
+        Channel* channel = static_cast<Channel*>(user_data);
+        Handle* handle = static_cast<Handle*>(channel->handle);
+        Session* session = static_cast<Session*>(handle->context.get());
+        OutputBuffer message;
+        write(message, level_command(channel->level));
+        write_encoded(message, *image, session->encoding, channel->encoder);
+        handle->publish(std::move(message));
+    };
+
+    // Publish each named region in its own message.
+    static auto crop_callback = [](void* user_data, const char* name, picam_image_t* image)
+    {
+        Handle* handle = static_cast<Handle*>(user_data);
+        Session* session = static_cast<Session*>(handle->context.get());
+        OutputBuffer message;
+        write(message, Command::CROP_CALLBACK_SET, std::string(name));
+        write_encoded(message, *image, session->encoding, session->crop_encoders[name]);
+        handle->publish(std::move(message));
+    };
+
+    // Publish frames of each sink tagged with its identifier.
+    static auto sink_callback = [](void* user_data, picam_image_t* image)
+    {
+        SinkChannel* channel = static_cast<SinkChannel*>(user_data);
+        const picam_sink_t sink = channel->sink;
+        if (!sink) {
+            return;
+        }
+        Handle* handle = static_cast<Handle*>(channel->handle);
+        Session* session = static_cast<Session*>(handle->context.get());
+        OutputBuffer message;
+        write(message, Command::SINK_CALLBACK_SET, sink);
+        write_encoded(message, *image, session->encoding, channel->encoder);
+        handle->publish(std::move(message));
+    };
+
+    // Publish motion events, they are small enough to go without encoding.
+    static auto motion_callback = [](void* user_data, const picam_motion_t* motion)
+    {
+        Handle* handle = static_cast<Handle*>(user_data);
+        OutputBuffer message;
+        write(message, Command::MOTION_CALLBACK_SET, *motion);
+        handle->publish(std::move(message));
+    };
+
+    // Publish frame statistics on their own, so controllers don't need to receive frames.
+    static auto stats_callback = [](void* user_data, const picam_stats_t* stats)
+    {
+        Handle* handle = static_cast<Handle*>(user_data);
+        OutputBuffer message;
+        write(message, Command::STATS_CALLBACK_SET, *stats);
+        handle->publish(std::move(message));
+    };
+
+    // Publish features on their own, usually much smaller than the frames they come from.
+    static auto features_callback = [](void* user_data, const picam_features_t* features)
+    {
+        Handle* handle = static_cast<Handle*>(user_data);
+        OutputBuffer message;
+        write(message, Command::FEATURES_CALLBACK_SET, *features);
+        handle->publish(std::move(message));
+    };
+
+    // Create task that enables or disables callback of specified level.
+    auto level_task = [](picam_level_t level) -> Procedure
+    {
+        return [level](Handle& handle, InputBuffer args) {
+            OutputBuffer reply;
+            bool enable;
+            read(args, enable);
+            int error = 0;
+
+            if (enable) {
+                Session* session = static_cast<Session*>(handle.context.get());
+                error = picam_level_callback_set(handle.value, level, &session->channels[level], image_callback);
+            } else {
+                error = picam_level_callback_set(handle.value, level, nullptr, nullptr);
+            }
+
+            write(reply, error);
+            return reply;
+        };
+    };
+
     static Config PiCamServerConfig = {
 
         // Create Command
@@ -26,6 +175,9 @@ const PiCamServer::Config& PiCamServer::config()
             picam_config_t config;
             read(args, config);
             int error = picam_create(&handle.value, &config, nullptr);
+            if (!error) {
+                handle.context = std::make_shared<Session>(&handle);
+            }
             write(reply, error);
             return reply;
         }},
@@ -40,29 +192,167 @@ const PiCamServer::Config& PiCamServer::config()
 
         // List other commands
         {
-            { Command::CALLBACK_SET, [this](Handle& handle, InputBuffer args) {
+            { Command::CALLBACK_SET, level_task(PICAM_LEVEL_FULL) },
+            { Command::HALF_CALLBACK_SET, level_task(PICAM_LEVEL_HALF) },
+            { Command::QUARTER_CALLBACK_SET, level_task(PICAM_LEVEL_QUARTER) },
+            { Command::EIGHTH_CALLBACK_SET, level_task(PICAM_LEVEL_EIGHTH) },
+
+            { Command::FORMAT_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                picam_image_format_t format;
+                read(args, format);
+                int error = picam_format_set(handle.value, format);
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::SINK_ADD, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                picam_sink_config_t config;
+                read(args, config);
+
+                // Channel must exist before the sink, as frames may arrive before its identifier.
+                Session* session = static_cast<Session*>(handle.context.get());
+                std::unique_ptr<SinkChannel> channel(new SinkChannel());
+                channel->handle = &handle;
+                channel->sink = 0;
+
+                picam_sink_t sink = 0;
+                int error = picam_sink_add(handle.value, &config, channel.get(), sink_callback, &sink);
+                if (!error) {
+                    channel->sink = sink;
+                    session->sinks[sink] = std::move(channel);
+                }
+                write(reply, error, sink);
+                return reply;
+            }},
+
+            { Command::SINK_REMOVE, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                picam_sink_t sink;
+                read(args, sink);
+                int error = picam_sink_remove(handle.value, sink);
+                if (!error) {
+                    static_cast<Session*>(handle.context.get())->sinks.erase(sink);
+                }
+                write(reply, error);
+                return reply;
+            }},
+
+            // Sinks are published while they exist, there is nothing to enable.
+            { Command::SINK_CALLBACK_SET, [](Handle&, InputBuffer) {
+                OutputBuffer reply;
+                write(reply, 0);
+                return reply;
+            }},
+
+            { Command::CROP_ADD, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                std::string name;
+                picam_roi_t roi;
+                read(args, name, roi);
+                int error = picam_crop_add(handle.value, name.c_str(), &roi);
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::CROP_REMOVE, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                std::string name;
+                read(args, name);
+                int error = picam_crop_remove(handle.value, name.c_str());
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::CROP_CALLBACK_SET, [](Handle& handle, InputBuffer args) {
                 OutputBuffer reply;
                 bool enable;
                 read(args, enable);
                 int error = 0;
 
-                static auto image_callback = [](void* user_data, picam_image_t* image)
-                {
-                    Handle* handle = static_cast<Handle*>(user_data);
-                    OutputBuffer message;
-                    auto found = crop_map.find(handle->value);
-                    if (found == crop_map.end()) {
-                        write(message, Command::CALLBACK_SET, *image);
-                    } else {
-                        write(message, Command::CALLBACK_SET, *image, found->second);
-                    }
-                    handle->publish(std::move(message));
-                };
+                if (enable) {
+                    error = picam_crop_callback_set(handle.value, &handle, crop_callback);
+                } else {
+                    error = picam_crop_callback_set(handle.value, nullptr, nullptr);
+                }
+
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::MOTION_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                picam_motion_config_t config;
+                read(args, enable, config);
+                int error = picam_motion_set(handle.value, enable ? &config : nullptr);
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::MOTION_CALLBACK_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                read(args, enable);
+                int error = 0;
+
+                if (enable) {
+                    error = picam_motion_callback_set(handle.value, &handle, motion_callback);
+                } else {
+                    error = picam_motion_callback_set(handle.value, nullptr, nullptr);
+                }
+
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::STATS_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                picam_stats_config_t config;
+                read(args, enable, config);
+                int error = picam_stats_set(handle.value, enable ? &config : nullptr);
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::STATS_CALLBACK_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                read(args, enable);
+                int error = 0;
 
                 if (enable) {
-                    error = picam_callback_set(handle.value, &handle, image_callback);
+                    error = picam_stats_callback_set(handle.value, &handle, stats_callback);
                 } else {
-                    error = picam_callback_set(handle.value, nullptr, nullptr);
+                    error = picam_stats_callback_set(handle.value, nullptr, nullptr);
+                }
+
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::FEATURES_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                picam_features_config_t config;
+                read(args, enable, config);
+                int error = picam_features_set(handle.value, enable ? &config : nullptr);
+                write(reply, error);
+                return reply;
+            }},
+
+            { Command::FEATURES_CALLBACK_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                bool enable;
+                read(args, enable);
+                int error = 0;
+
+                if (enable) {
+                    error = picam_features_callback_set(handle.value, &handle, features_callback);
+                } else {
+                    error = picam_features_callback_set(handle.value, nullptr, nullptr);
                 }
 
                 write(reply, error);
@@ -81,16 +371,25 @@ const PiCamServer::Config& PiCamServer::config()
                 OutputBuffer reply;
                 picam_params_t params;
                 read(args, params);
-                // Highjack crop parameter to avoid extra copies of image buffer.
-                if (params.crop.x != 0.0 || params.crop.y != 0.0 ||
-                        params.crop.width != 1.0 || params.crop.height != 1.0) {
-                    crop_map[handle.value] = params.crop;
-                    params.crop = { 0.0, 0.0, 1.0, 1.0 };
-                }
                 int error = picam_params_set(handle.value, &params);
                 write(reply, error);
                 return reply;
             }},
+
+            { Command::ENCODING_SET, [](Handle& handle, InputBuffer args) {
+                OutputBuffer reply;
+                picam_encoding_t encoding;
+                read(args, encoding);
+                int error = 0;
+                if (encoding == PICAM_ENCODING_RAW || encoding == PICAM_ENCODING_QOI ||
+                        encoding == PICAM_ENCODING_DELTA) {
+                    static_cast<Session*>(handle.context.get())->encoding = encoding;
+                } else {
+                    error = static_cast<int>(std::errc::invalid_argument);
+                }
+                write(reply, error);
+                return reply;
+            }},
         }
     };
 
@@ -116,3 +415,24 @@ int picam_server_stop(picam_server_t server)
 }
 
 /*************************************************************************************************/
+
+int picam_server_start_manual(picam_server_t* server, const char* address)
+{
+    return Jaw::PiCamServer::start(server, address, false);
+}
+
+/*************************************************************************************************/
+
+int picam_server_events_fd_get(picam_server_t server, int* fd)
+{
+    return Jaw::PiCamServer::events_fd(server, fd);
+}
+
+/*************************************************************************************************/
+
+int picam_server_process_events(picam_server_t server)
+{
+    return Jaw::PiCamServer::process_events(server);
+}
+
+/*************************************************************************************************/